@@ -0,0 +1,173 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Compares the bump map kernels with the former per pixel loop
+ * (array of double normals and SDL_Colors) on a synthetic glyph.
+ *
+ * ./bench_bumpmap [size] [iterations]
+ **/
+#include "../src/base/log_contexts.h"
+#include "../src/base/logging.h"
+#include "../src/menu/bumpmap_kernel.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+    double x;
+    double y;
+} reference_normal;
+
+/**
+ * The former loop of glyph_obj_light_texture with the light already
+ * rotated into glyph space
+ **/
+static void reference_relight(const bumpmap_data *d,
+                              const reference_normal *normals,
+                              const SDL_Color *colors,
+                              double wx,
+                              double wy,
+                              const SDL_Color *tint,
+                              Uint8 *out) {
+    for (int o = 0; o < d->w * d->h; o++) {
+        SDL_Color px = colors[o];
+        Uint8 *dst = out + 4 * o;
+        if (px.a > 1) {
+            Uint8 r = tint ? tint->r : px.r, g = tint ? tint->g : px.g, b = tint ? tint->b : px.b;
+            double light = normals[o].x * wx + normals[o].y * wy;
+            if (light >= 0.0) {
+                r = r + (255.0 - r) * light;
+                g = g + (255.0 - g) * light;
+                b = b + (255.0 - b) * light;
+            } else {
+                r = r * (1.0 + light);
+                g = g * (1.0 + light);
+                b = b * (1.0 + light);
+            }
+            dst[0] = r;
+            dst[1] = g;
+            dst[2] = b;
+            dst[3] = px.a;
+        } else {
+            dst[0] = dst[1] = dst[2] = dst[3] = 0;
+        }
+    }
+}
+
+/**
+ * A ring with soft edges, roughly like a large bold glyph
+ **/
+static bumpmap_data *synthetic_glyph(int size) {
+    bumpmap_data *d = bumpmap_data_new(size, size);
+    double c = 0.5 * size;
+    for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+            int o = size * y + x;
+            double r = sqrt((x - c) * (x - c) + (y - c) * (y - c));
+            double a = 1.0 - fabs(r - 0.3 * size) / (0.12 * size);
+            d->a[o] = a <= 0.0 ? 0 : a >= 1.0 ? 255 : (Uint8) (255.0 * a);
+            d->r[o] = (Uint8) (x * 255 / size);
+            d->g[o] = (Uint8) (y * 255 / size);
+            d->b[o] = 128;
+        }
+    }
+    bumpmap_data_compute_normals(d);
+    return d;
+}
+
+static double seconds(Uint64 ticks) {
+    return (double) ticks / (double) SDL_GetPerformanceFrequency();
+}
+
+int main(int argc, char **argv) {
+    int size = argc > 1 ? atoi(argv[1]) : 96;
+    int iterations = argc > 2 ? atoi(argv[2]) : 2000;
+    static const char *kernels[] = {"scalar", "sse2", "avx2", "neon"};
+    SDL_Color tint = {200, 120, 40, 255};
+
+    set_log_level(MENU_CTX, 1);
+
+    bumpmap_data *d = synthetic_glyph(size);
+    int n = size * size;
+
+    reference_normal *normals = malloc(n * sizeof(reference_normal));
+    SDL_Color *colors = malloc(n * sizeof(SDL_Color));
+    for (int o = 0; o < n; o++) {
+        normals[o] = (reference_normal){d->nx[o], d->ny[o]};
+        colors[o] = (SDL_Color){d->r[o], d->g[o], d->b[o], d->a[o]};
+    }
+
+    Uint8 *expected = malloc(4 * n);
+    Uint8 *actual = malloc(4 * n);
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    for (int i = 0; i < iterations; i++) {
+        double angle = 2.0 * M_PI * i / iterations;
+        reference_relight(d, normals, colors, cos(angle), sin(angle), &tint, expected);
+    }
+    double reference_s = seconds(SDL_GetPerformanceCounter() - start);
+    printf("%-10s %8.3f us/glyph\n", "reference", 1e6 * reference_s / iterations);
+
+    for (unsigned int k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        bumpmap_span_fn *span = bumpmap_kernel_lookup(kernels[k]);
+        if (!span) {
+            printf("%-10s not available\n", kernels[k]);
+            continue;
+        }
+
+        int max_diff = 0;
+        for (int t = 0; t < 2; t++) {
+            const SDL_Color *tnt = t ? &tint : NULL;
+            for (int i = 0; i < 16; i++) {
+                double angle = 2.0 * M_PI * i / 16;
+                reference_relight(d, normals, colors, cos(angle), sin(angle), tnt, expected);
+                span(d, 0, n, (float) cos(angle), (float) sin(angle), tnt, actual);
+                for (int o = 0; o < 4 * n; o++) {
+                    int diff = abs(expected[o] - actual[o]);
+                    if (diff > max_diff) {
+                        max_diff = diff;
+                    }
+                }
+            }
+        }
+
+        start = SDL_GetPerformanceCounter();
+        for (int i = 0; i < iterations; i++) {
+            double angle = 2.0 * M_PI * i / iterations;
+            span(d, 0, n, (float) cos(angle), (float) sin(angle), &tint, actual);
+        }
+        double kernel_s = seconds(SDL_GetPerformanceCounter() - start);
+
+        printf("%-10s %8.3f us/glyph %6.2fx max diff %d%s\n",
+               kernels[k],
+               1e6 * kernel_s / iterations,
+               reference_s / kernel_s,
+               max_diff,
+               max_diff > 1 ? " MISMATCH" : "");
+    }
+
+    free(expected);
+    free(actual);
+    free(normals);
+    free(colors);
+    bumpmap_data_free(d);
+
+    return 0;
+}
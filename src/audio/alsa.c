@@ -49,6 +49,8 @@ static pthread_mutex_t __alsa_volume_event_mutex = PTHREAD_MUTEX_INITIALIZER;
 static int __alsa_volume_event_pending = 0;
 static int __alsa_volume_event_value = 0;
 static int __alsa_last_event_volume = -1;
+static alsa_event_notify *__alsa_event_notify = NULL;
+static void *__alsa_event_notify_data = NULL;
 
 static int __alsa_volume_from_elem(snd_mixer_elem_t *elem, long min, long range) {
     long vol = 0;
@@ -83,10 +85,24 @@ static void __alsa_queue_volume_event(int volume) {
         __alsa_last_event_volume = volume;
         __alsa_volume_event_value = volume;
         __alsa_volume_event_pending = 1;
+        if (__alsa_event_notify) {
+            __alsa_event_notify(__alsa_event_notify_data);
+        }
     }
     pthread_mutex_unlock(&__alsa_volume_event_mutex);
 }
 
+/**
+ * notify is called from the listener thread after each queued volume
+ * event, so the consumer of alsa_next_volume_event needn't poll
+ **/
+void alsa_set_event_notify(alsa_event_notify *notify, void *data) {
+    pthread_mutex_lock(&__alsa_volume_event_mutex);
+    __alsa_event_notify = notify;
+    __alsa_event_notify_data = data;
+    pthread_mutex_unlock(&__alsa_volume_event_mutex);
+}
+
 static void __alsa_check_listener_volume(void) {
     int new_volume = __alsa_volume_from_elem(__alsa_listener_info.mixer_element,
                                              __alsa_listener_info.min,
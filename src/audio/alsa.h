@@ -20,10 +20,13 @@
 #ifndef ALSA_H
 #define ALSA_H
 
+typedef void alsa_event_notify(void *data);
+
 const int alsa_init(const char *mixer_device, const char *mixer);
 int alsa_close();
 const int alsa_set_volume(const int value);
 const int alsa_get_volume();
 const int alsa_enabled();
 const int alsa_next_volume_event(int *volume);
+void alsa_set_event_notify(alsa_event_notify *notify, void *data);
 #endif
@@ -67,6 +67,8 @@ static __player_event_node *__player_event_head = NULL;
 static __player_event_node *__player_event_tail = NULL;
 static __player_action_node *__player_action_head = NULL;
 static __player_action_node *__player_action_tail = NULL;
+static player_event_notify *__player_event_notify = NULL;
+static void *__player_event_notify_data = NULL;
 
 player *player_new(const char *name,
                    const char *icon,
@@ -164,6 +166,20 @@ static void player_listener(player_event event) {
         __player_event_head = node;
     }
     __player_event_tail = node;
+    if (__player_event_notify) {
+        __player_event_notify(__player_event_notify_data);
+    }
+    pthread_mutex_unlock(&__player_event_mutex);
+}
+
+/**
+ * notify is called from the emitting thread after each queued event,
+ * so the consumer of player_next_event needn't poll
+ **/
+void player_set_event_notify(player_event_notify *notify, void *data) {
+    pthread_mutex_lock(&__player_event_mutex);
+    __player_event_notify = notify;
+    __player_event_notify_data = data;
     pthread_mutex_unlock(&__player_event_mutex);
 }
 
@@ -35,6 +35,7 @@ typedef enum {
 } player_status;
 
 typedef void player_action(void *data);
+typedef void player_event_notify(void *data);
 typedef int player_init_function();
 typedef int player_run_function();
 typedef int player_cleanup_function();
@@ -93,6 +94,7 @@ int player_start(player *p);
 int player_stop(player *p);
 void player_emit_event(player *p, player_status status);
 player_event *player_next_event(void);
+void player_set_event_notify(player_event_notify *notify, void *data);
 void player_event_free(player_event *event);
 
 int player_playback_stop(player *p);
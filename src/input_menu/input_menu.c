@@ -54,6 +54,9 @@ static const int input_menu_ok_idx = 63;
 
 char *input_menu_txt = NULL;
 
+/* The item showing input_menu_txt above its character, -1 if none */
+static int input_menu_decorated_id = -1;
+
 input_menu_ok_action *__ok_action;
 
 int input_menu_item_action(menu_event evt, menu *m, menu_item *item) {
@@ -77,6 +80,7 @@ int input_menu_item_action(menu_event evt, menu *m, menu_item *item) {
                         char *lbl1 = my_catstr(input_menu_txt,"\n");
                         char *lbl2 = my_catstr(lbl1, input_menu_alphabet_items[item->id]);
                         menu_item_set_label(item, lbl2);
+                        input_menu_decorated_id = item->id;
                         free (lbl1);
                         free (lbl2);
                     }
@@ -92,36 +96,23 @@ int input_menu_item_action(menu_event evt, menu *m, menu_item *item) {
                 char *lbl1 = my_catstr(input_menu_txt,"\n");
                 char *lbl2 = my_catstr(lbl1, input_menu_alphabet_items[item->id]);
                 menu_item_set_label(item, lbl2);
+                input_menu_decorated_id = item->id;
                 free (lbl1);
                 free (lbl2);
             }
         }
-    } else if (evt == TURN_LEFT) {
-        // current_id increases
-        if (input_menu_txt[0] != 0) {
-
-            // menu_item *last_item = m->item[last_id];
-            // menu_item_update_label(last_item, input_menu_alphabet_items[last_id]);
-
-            char *lbl1 = my_catstr(input_menu_txt,"\n");
-            char *lbl2 = my_catstr(lbl1, m->item[m->current_id]->label);
-            menu_item_set_label(m->item[m->current_id], lbl2);
-            free (lbl1);
-            free (lbl2);
+    } else if (evt == TURN_LEFT || evt == TURN_RIGHT) {
+        /* A turn may cross several characters, restore the one showing the text */
+        if (input_menu_decorated_id >= 0 && input_menu_decorated_id != m->current_id) {
+            menu_item_set_label(m->item[input_menu_decorated_id],
+                                input_menu_alphabet_items[input_menu_decorated_id]);
+            input_menu_decorated_id = -1;
         }
-    } else if (evt == TURN_RIGHT) {
-        // current_id decreases
         if (input_menu_txt[0] != 0) {
-            int last_id = m->current_id + 1;
-            if (last_id == input_menu_n_of_characters) {
-                last_id = 0;
-            }
-            menu_item *last_item = m->item[last_id];
-            menu_item_set_label(last_item, input_menu_alphabet_items[last_id]);
-
             char *lbl1 = my_catstr(input_menu_txt,"\n");
-            char *lbl2 = my_catstr(lbl1, m->item[m->current_id]->label);
+            char *lbl2 = my_catstr(lbl1, input_menu_alphabet_items[m->current_id]);
             menu_item_set_label(m->item[m->current_id], lbl2);
+            input_menu_decorated_id = m->current_id;
             free (lbl1);
             free (lbl2);
         }
@@ -0,0 +1,637 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "asset_cache.h"
+#include "../base/log_contexts.h"
+#include "../base/logging.h"
+#include "../base/util.h"
+#include <SDL2/SDL_image.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#define ASSET_CACHE_BUCKETS 64
+#define ASSET_CACHE_IMAGE_BUCKETS 256
+
+typedef struct asset asset;
+
+/**
+ * One decoded image, a file or a frame of an animation. The cache holds
+ * one reference of the surface.
+ **/
+typedef struct asset_image {
+    SDL_Surface *surface;
+    SDL_Texture *texture; /* Kept while the asset is cached, even if unused */
+    int texture_refs;
+    asset *asset;
+    struct asset_image *next_by_surface;
+    struct asset_image *next_by_texture;
+} asset_image;
+
+struct asset {
+    char *path;
+    time_t mtime;
+    int stale; /* The file has changed, the asset goes once it is unused */
+    asset_image *image;
+    int animation_loaded; /* IMG_LoadAnimation has been tried */
+    int n_frames; /* More than one for animations */
+    asset_image **frames;
+    int *delays;
+    size_t bytes;
+    asset *next; /* In its bucket */
+    asset *prev_used;
+    asset *next_used;
+};
+
+static struct {
+    SDL_mutex *mutex;
+    size_t budget; /* For assets nobody uses */
+    size_t animation_limit; /* Decoded frames of one animation */
+    size_t bytes;
+    asset *buckets[ASSET_CACHE_BUCKETS];
+    asset_image *surfaces[ASSET_CACHE_IMAGE_BUCKETS];
+    asset_image *textures[ASSET_CACHE_IMAGE_BUCKETS];
+    asset *head; /* most recently used */
+    asset *tail;
+} asset_cache = {NULL, 0, ASSET_CACHE_MAX_ANIMATION_BYTES, 0, {NULL}, {NULL}, {NULL}, NULL, NULL};
+
+static Uint32 asset_cache_hash_path(const char *path) {
+    Uint32 h = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *) path; *c; c++) {
+        h = (h ^ *c) * 16777619u;
+    }
+    return h % ASSET_CACHE_BUCKETS;
+}
+
+static Uint32 asset_cache_hash_ptr(const void *p) {
+    uintptr_t v = (uintptr_t) p;
+    return (Uint32) ((v >> 4) ^ (v >> 12)) % ASSET_CACHE_IMAGE_BUCKETS;
+}
+
+static asset_image *asset_cache_find_surface(SDL_Surface *surface) {
+    asset_image *img = asset_cache.surfaces[asset_cache_hash_ptr(surface)];
+    while (img && img->surface != surface) {
+        img = img->next_by_surface;
+    }
+    return img;
+}
+
+static asset_image *asset_cache_find_texture(SDL_Texture *texture) {
+    asset_image *img = asset_cache.textures[asset_cache_hash_ptr(texture)];
+    while (img && img->texture != texture) {
+        img = img->next_by_texture;
+    }
+    return img;
+}
+
+static size_t asset_image_bytes(SDL_Surface *surface) {
+    return (size_t) surface->pitch * surface->h;
+}
+
+static asset_image *asset_image_new(asset *a, SDL_Surface *surface) {
+    asset_image *img = calloc(1, sizeof(asset_image));
+    Uint32 h = asset_cache_hash_ptr(surface);
+
+    img->surface = surface;
+    img->asset = a;
+    img->next_by_surface = asset_cache.surfaces[h];
+    asset_cache.surfaces[h] = img;
+
+    a->bytes += asset_image_bytes(surface);
+    asset_cache.bytes += asset_image_bytes(surface);
+
+    return img;
+}
+
+static void asset_image_drop_texture(asset_image *img) {
+    if (!img->texture) {
+        return;
+    }
+
+    asset_image **i = &asset_cache.textures[asset_cache_hash_ptr(img->texture)];
+    while (*i && *i != img) {
+        i = &(*i)->next_by_texture;
+    }
+    if (*i) {
+        *i = img->next_by_texture;
+    }
+
+    SDL_DestroyTexture(img->texture);
+    img->texture = NULL;
+    img->texture_refs = 0;
+    img->asset->bytes -= asset_image_bytes(img->surface);
+    asset_cache.bytes -= asset_image_bytes(img->surface);
+}
+
+static void asset_image_free(asset_image *img) {
+    if (!img) {
+        return;
+    }
+
+    asset_image_drop_texture(img);
+
+    asset_image **i = &asset_cache.surfaces[asset_cache_hash_ptr(img->surface)];
+    while (*i && *i != img) {
+        i = &(*i)->next_by_surface;
+    }
+    if (*i) {
+        *i = img->next_by_surface;
+    }
+
+    img->asset->bytes -= asset_image_bytes(img->surface);
+    asset_cache.bytes -= asset_image_bytes(img->surface);
+    SDL_FreeSurface(img->surface);
+    free(img);
+}
+
+static int asset_image_in_use(const asset_image *img) {
+    return img && (img->surface->refcount > 1 || img->texture_refs > 0);
+}
+
+static int asset_in_use(const asset *a) {
+    if (asset_image_in_use(a->image)) {
+        return 1;
+    }
+    for (int f = 0; f < a->n_frames; f++) {
+        if (asset_image_in_use(a->frames[f])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void asset_unlink_used(asset *a) {
+    if (a->prev_used) {
+        a->prev_used->next_used = a->next_used;
+    } else {
+        asset_cache.head = a->next_used;
+    }
+    if (a->next_used) {
+        a->next_used->prev_used = a->prev_used;
+    } else {
+        asset_cache.tail = a->prev_used;
+    }
+    a->prev_used = NULL;
+    a->next_used = NULL;
+}
+
+static void asset_push_used(asset *a) {
+    a->next_used = asset_cache.head;
+    if (asset_cache.head) {
+        asset_cache.head->prev_used = a;
+    }
+    asset_cache.head = a;
+    if (!asset_cache.tail) {
+        asset_cache.tail = a;
+    }
+}
+
+/**
+ * Takes the asset out of its bucket, it can't be found by its path anymore
+ **/
+static void asset_unlink_path(asset *a) {
+    asset **e = &asset_cache.buckets[asset_cache_hash_path(a->path)];
+    while (*e && *e != a) {
+        e = &(*e)->next;
+    }
+    if (*e) {
+        *e = a->next;
+    }
+    a->next = NULL;
+}
+
+static void asset_free(asset *a) {
+    if (!a->stale) {
+        asset_unlink_path(a);
+    }
+    asset_unlink_used(a);
+
+    asset_image_free(a->image);
+    for (int f = 0; f < a->n_frames; f++) {
+        asset_image_free(a->frames[f]);
+    }
+    free(a->frames);
+    free(a->delays);
+    free(a->path);
+    free(a);
+}
+
+/**
+ * Frees unused assets, changed files first and the least recently used
+ * while the cache exceeds its budget
+ **/
+static void asset_cache_trim(void) {
+    asset *a = asset_cache.tail;
+    while (a) {
+        asset *prev = a->prev_used;
+        if ((a->stale || asset_cache.bytes > asset_cache.budget) && !asset_in_use(a)) {
+            asset_free(a);
+        }
+        a = prev;
+    }
+}
+
+static int asset_cache_mtime(const char *path, time_t *mtime) {
+    struct stat st;
+    if (!path || stat(path, &st) != 0) {
+        SDL_SetError("Could not open %s: %s", path ? path : "(null)", strerror(errno));
+        return 0;
+    }
+    *mtime = st.st_mtime;
+    return 1;
+}
+
+/**
+ * The asset of path, created if there is none yet or the file has changed
+ **/
+static asset *asset_cache_get(const char *path, time_t mtime) {
+    Uint32 h = asset_cache_hash_path(path);
+    asset *a = asset_cache.buckets[h];
+
+    while (a && strcmp(a->path, path)) {
+        a = a->next;
+    }
+
+    if (a && a->mtime != mtime) {
+        log_info(MENU_CTX, "%s has changed, decoding it again\n", path);
+        asset_unlink_path(a);
+        a->stale = 1;
+        a = NULL;
+    }
+
+    if (!a) {
+        a = calloc(1, sizeof(asset));
+        a->path = my_copystr(path);
+        a->mtime = mtime;
+        a->next = asset_cache.buckets[h];
+        asset_cache.buckets[h] = a;
+    } else {
+        asset_unlink_used(a);
+    }
+    asset_push_used(a);
+
+    return a;
+}
+
+/**
+ * Sets the budget of the decoded images nobody uses anymore
+ **/
+void asset_cache_set_budget(size_t budget) {
+    if (asset_cache.mutex) {
+        SDL_LockMutex(asset_cache.mutex);
+    }
+    asset_cache.budget = budget;
+    asset_cache_trim();
+    if (asset_cache.mutex) {
+        SDL_UnlockMutex(asset_cache.mutex);
+    }
+
+    log_config(MENU_CTX, "Asset cache: %zu bytes\n", budget);
+}
+
+/**
+ * Sets the size animations are thinned to when they are decoded
+ **/
+void asset_cache_set_animation_limit(size_t max_bytes) {
+    asset_cache.animation_limit = max_bytes;
+}
+
+/**
+ * The bytes of all decoded images and their textures, used or not
+ **/
+size_t asset_cache_get_bytes(void) {
+    if (!asset_cache.mutex) {
+        return 0;
+    }
+
+    SDL_LockMutex(asset_cache.mutex);
+    size_t bytes = asset_cache.bytes;
+    SDL_UnlockMutex(asset_cache.mutex);
+
+    return bytes;
+}
+
+void asset_cache_init(size_t budget) {
+    if (asset_cache.mutex) {
+        return;
+    }
+
+    asset_cache.mutex = SDL_CreateMutex();
+    if (!asset_cache.mutex) {
+        log_error(MENU_CTX, "Could not create asset cache lock, images are not shared: %s\n", SDL_GetError());
+        return;
+    }
+    asset_cache.budget = budget;
+}
+
+/**
+ * Frees all assets, textures still in use included. Must be called
+ * before the renderer is destroyed.
+ **/
+void asset_cache_free(void) {
+    if (!asset_cache.mutex) {
+        return;
+    }
+
+    SDL_LockMutex(asset_cache.mutex);
+    while (asset_cache.tail) {
+        asset_free(asset_cache.tail);
+    }
+    SDL_UnlockMutex(asset_cache.mutex);
+
+    SDL_DestroyMutex(asset_cache.mutex);
+    asset_cache.mutex = NULL;
+}
+
+SDL_Surface *asset_cache_load_surface(const char *path) {
+    time_t mtime;
+
+    if (!asset_cache.mutex) {
+        return IMG_Load(path);
+    }
+
+    if (!asset_cache_mtime(path, &mtime)) {
+        return NULL;
+    }
+
+    SDL_LockMutex(asset_cache.mutex);
+    asset *a = asset_cache_get(path, mtime);
+    if (!a->image) {
+        /* Other threads may use the cache meanwhile */
+        SDL_UnlockMutex(asset_cache.mutex);
+        SDL_Surface *surface = IMG_Load(path);
+        SDL_LockMutex(asset_cache.mutex);
+
+        if (!surface) {
+            SDL_UnlockMutex(asset_cache.mutex);
+            return NULL;
+        }
+
+        a = asset_cache_get(path, mtime);
+        if (a->image) {
+            SDL_FreeSurface(surface);
+        } else {
+            a->image = asset_image_new(a, surface);
+        }
+    }
+
+    SDL_Surface *surface = a->image->surface;
+    surface->refcount++;
+    asset_cache_trim();
+    SDL_UnlockMutex(asset_cache.mutex);
+
+    return surface;
+}
+
+/**
+ * Moves the frames of animation to malloc'd arrays and frees it. Keeps
+ * the frames within max_bytes by dropping all but every n-th frame; the
+ * kept frames are shown for the delays of the dropped ones, so the
+ * animation runs at its speed. Returns the number of frames kept, 0 for
+ * still images and errors.
+ **/
+static int asset_take_animation(const char *path,
+                                IMG_Animation *animation,
+                                size_t max_bytes,
+                                SDL_Surface ***frames,
+                                int **delays) {
+    if (!animation || animation->count < 2) {
+        if (animation) {
+            IMG_FreeAnimation(animation);
+        }
+        return 0;
+    }
+
+    int n = animation->count;
+    *frames = malloc(n * sizeof(SDL_Surface *));
+    *delays = malloc(n * sizeof(int));
+    if (!*frames || !*delays) {
+        log_error(MENU_CTX, "asset_take_animation: malloc failed\n");
+        free(*frames);
+        free(*delays);
+        IMG_FreeAnimation(animation);
+        return 0;
+    }
+
+    size_t frame_bytes = asset_image_bytes(animation->frames[0]);
+    int step = 1;
+    if (max_bytes > 0 && frame_bytes * n > max_bytes) {
+        step = (int) ((frame_bytes * n + max_bytes - 1) / max_bytes);
+    }
+
+    int n_frames = 0;
+    for (int f = 0; f < n; f++) {
+        if (f % step == 0) {
+            (*frames)[n_frames] = animation->frames[f];
+            (*delays)[n_frames++] = animation->delays[f];
+            /* Detached, IMG_FreeAnimation must not free it */
+            animation->frames[f] = NULL;
+        } else {
+            (*delays)[n_frames - 1] += animation->delays[f];
+        }
+    }
+
+    if (n_frames < n) {
+        log_info(MENU_CTX, "Animation %s has %d frames of %zu bytes, keeping %d\n",
+                 path, n, frame_bytes, n_frames);
+    }
+
+    /* Frees the dropped frames, they are not shared yet */
+    IMG_FreeAnimation(animation);
+    return n_frames;
+}
+
+static void asset_set_animation(asset *a, IMG_Animation *animation, size_t max_bytes) {
+    SDL_Surface **frames;
+    int *delays;
+
+    a->animation_loaded = 1;
+
+    int n_frames = asset_take_animation(a->path, animation, max_bytes, &frames, &delays);
+    if (n_frames < 2) {
+        if (n_frames == 1) {
+            SDL_FreeSurface(frames[0]);
+            free(frames);
+            free(delays);
+        }
+        return;
+    }
+
+    a->n_frames = n_frames;
+    a->frames = calloc(n_frames, sizeof(asset_image *));
+    for (int f = 0; f < n_frames; f++) {
+        a->frames[f] = asset_image_new(a, frames[f]);
+    }
+    a->delays = delays;
+    free(frames);
+}
+
+/**
+ * Returns the number of frames and malloc'd copies of the frame and delay
+ * arrays, if path is an animation. Returns 0 for still images and errors.
+ * Animations are thinned to the animation limit when they are decoded.
+ **/
+int asset_cache_load_animation(const char *path, SDL_Surface ***frames, int **delays) {
+    time_t mtime;
+
+    if (!asset_cache.mutex) {
+        int n_frames = asset_take_animation(path,
+                                            IMG_LoadAnimation(path),
+                                            asset_cache.animation_limit,
+                                            frames,
+                                            delays);
+        if (n_frames == 1) {
+            SDL_FreeSurface((*frames)[0]);
+            free(*frames);
+            free(*delays);
+            return 0;
+        }
+        return n_frames;
+    }
+
+    if (!asset_cache_mtime(path, &mtime)) {
+        return 0;
+    }
+
+    SDL_LockMutex(asset_cache.mutex);
+    asset *a = asset_cache_get(path, mtime);
+    if (!a->animation_loaded) {
+        size_t max_bytes = asset_cache.animation_limit;
+        SDL_UnlockMutex(asset_cache.mutex);
+        IMG_Animation *animation = IMG_LoadAnimation(path);
+        SDL_LockMutex(asset_cache.mutex);
+
+        a = asset_cache_get(path, mtime);
+        if (a->animation_loaded) {
+            if (animation) {
+                IMG_FreeAnimation(animation);
+            }
+        } else {
+            asset_set_animation(a, animation, max_bytes);
+        }
+    }
+
+    int n_frames = a->n_frames;
+    if (n_frames > 1) {
+        *frames = malloc(n_frames * sizeof(SDL_Surface *));
+        *delays = malloc(n_frames * sizeof(int));
+        for (int f = 0; f < n_frames; f++) {
+            (*frames)[f] = a->frames[f]->surface;
+            (*frames)[f]->refcount++;
+            (*delays)[f] = a->delays[f];
+        }
+    }
+    asset_cache_trim();
+    SDL_UnlockMutex(asset_cache.mutex);
+
+    return n_frames > 1 ? n_frames : 0;
+}
+
+/**
+ * Gives back a surface of the cache. Other surfaces are just freed.
+ **/
+void asset_cache_release_surface(SDL_Surface *surface) {
+    if (!surface) {
+        return;
+    }
+
+    if (!asset_cache.mutex) {
+        SDL_FreeSurface(surface);
+        return;
+    }
+
+    SDL_LockMutex(asset_cache.mutex);
+    asset_image *img = asset_cache_find_surface(surface);
+    SDL_FreeSurface(surface);
+    if (img && !asset_image_in_use(img)) {
+        asset_cache_trim();
+    }
+    SDL_UnlockMutex(asset_cache.mutex);
+}
+
+/**
+ * The texture of surface, shared if the surface is one of the cache.
+ * Render thread only, give it back with asset_cache_release_texture.
+ **/
+SDL_Texture *asset_cache_texture(SDL_Renderer *renderer, SDL_Surface *surface) {
+    if (asset_cache.mutex) {
+        SDL_LockMutex(asset_cache.mutex);
+        asset_image *img = asset_cache_find_surface(surface);
+        if (img) {
+            if (!img->texture) {
+                img->texture = SDL_CreateTextureFromSurface(renderer, surface);
+                if (img->texture) {
+                    Uint32 h = asset_cache_hash_ptr(img->texture);
+                    img->next_by_texture = asset_cache.textures[h];
+                    asset_cache.textures[h] = img;
+                    img->asset->bytes += asset_image_bytes(surface);
+                    asset_cache.bytes += asset_image_bytes(surface);
+                }
+            }
+            if (img->texture) {
+                img->texture_refs++;
+            }
+            SDL_Texture *texture = img->texture;
+            SDL_UnlockMutex(asset_cache.mutex);
+            return texture;
+        }
+        SDL_UnlockMutex(asset_cache.mutex);
+    }
+
+    return SDL_CreateTextureFromSurface(renderer, surface);
+}
+
+SDL_Texture *asset_cache_load_texture(SDL_Renderer *renderer, const char *path) {
+    SDL_Surface *surface = asset_cache_load_surface(path);
+    if (!surface) {
+        return NULL;
+    }
+
+    SDL_Texture *texture = asset_cache_texture(renderer, surface);
+    asset_cache_release_surface(surface);
+
+    return texture;
+}
+
+/**
+ * Gives back a texture of the cache. Other textures are destroyed.
+ **/
+void asset_cache_release_texture(SDL_Texture *texture) {
+    if (!texture) {
+        return;
+    }
+
+    if (asset_cache.mutex) {
+        SDL_LockMutex(asset_cache.mutex);
+        asset_image *img = asset_cache_find_texture(texture);
+        if (img) {
+            img->texture_refs--;
+            if (!asset_image_in_use(img)) {
+                asset_cache_trim();
+            }
+            SDL_UnlockMutex(asset_cache.mutex);
+            return;
+        }
+        SDL_UnlockMutex(asset_cache.mutex);
+    }
+
+    SDL_DestroyTexture(texture);
+}
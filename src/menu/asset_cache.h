@@ -0,0 +1,51 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include <SDL2/SDL.h>
+#include <stddef.h>
+
+#define ASSET_CACHE_DEFAULT_BYTES (16 * 1024 * 1024)
+#define ASSET_CACHE_MAX_ANIMATION_BYTES (16 * 1024 * 1024)
+
+/**
+ * Decoded images shared by icons and backgrounds, process wide. A file is
+ * decoded once per path and modification time. Surfaces are shared with
+ * their SDL reference count and have to be given back with
+ * asset_cache_release_surface, which may be called from any thread.
+ * Textures are shared per surface and only used on the render thread.
+ * Without asset_cache_init every call loads the file itself.
+ **/
+void asset_cache_init(size_t budget);
+void asset_cache_free(void);
+void asset_cache_set_budget(size_t budget);
+void asset_cache_set_animation_limit(size_t max_bytes);
+size_t asset_cache_get_bytes(void);
+
+SDL_Surface *asset_cache_load_surface(const char *path);
+int asset_cache_load_animation(const char *path, SDL_Surface ***frames, int **delays);
+void asset_cache_release_surface(SDL_Surface *surface);
+
+SDL_Texture *asset_cache_texture(SDL_Renderer *renderer, SDL_Surface *surface);
+SDL_Texture *asset_cache_load_texture(SDL_Renderer *renderer, const char *path);
+void asset_cache_release_texture(SDL_Texture *texture);
+
+#endif // ASSET_CACHE_H
@@ -0,0 +1,405 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Per pixel bump map relighting. The inner loop exists as scalar code
+ * and as SSE2, AVX2 and NEON kernels, the best one is chosen at runtime.
+ **/
+#include "bumpmap_kernel.h"
+#include "../base/log_contexts.h"
+#include "../base/logging.h"
+#include "../base/util.h"
+#include "../util/sdl_util.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if SDL_BYTEORDER == SDL_LIL_ENDIAN
+#if defined(__SSE2__)
+#define BUMPMAP_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BUMPMAP_AVX2
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define BUMPMAP_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+bumpmap_data *bumpmap_data_new(int w, int h) {
+    bumpmap_data *d = calloc(1, sizeof(bumpmap_data));
+    d->w = w;
+    d->h = h;
+    d->nx = calloc(w * h, sizeof(float));
+    d->ny = calloc(w * h, sizeof(float));
+    d->r = calloc(w * h, sizeof(Uint8));
+    d->g = calloc(w * h, sizeof(Uint8));
+    d->b = calloc(w * h, sizeof(Uint8));
+    d->a = calloc(w * h, sizeof(Uint8));
+    return d;
+}
+
+void bumpmap_data_free(bumpmap_data *d) {
+    if (d) {
+        free(d->nx);
+        free(d->ny);
+        free(d->r);
+        free(d->g);
+        free(d->b);
+        free(d->a);
+        free(d);
+    }
+}
+
+/**
+ * The normals are the normalized alpha gradients. Border pixels are
+ * cleared, so that the relit glyph never has hard edges.
+ **/
+void bumpmap_data_compute_normals(bumpmap_data *d) {
+    int w = d->w;
+    int h = d->h;
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            int o = w * y + x;
+            float dx = 0.0f;
+            float dy = 0.0f;
+
+            if (d->a[o]) {
+                Uint8 pax = x <= 0 ? 0 : d->a[o - 1];
+                Uint8 pay = y <= 0 ? 0 : d->a[o - w];
+                Uint8 nax = x < w - 1 ? d->a[o + 1] : 0;
+                Uint8 nay = y < h - 1 ? d->a[o + w] : 0;
+
+                dx = (float) (nax - pax);
+                dy = (float) (nay - pay);
+
+                if (dx != 0.0f || dy != 0.0f) {
+                    float inv_dn = Q_rsqrt(dx * dx + dy * dy);
+                    dx = dx * inv_dn;
+                    dy = dy * inv_dn;
+                }
+            }
+
+            d->nx[o] = dx;
+            d->ny[o] = dy;
+        }
+    }
+
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (x == 0 || y == 0 || x == w - 1 || y == h - 1) {
+                int o = w * y + x;
+                d->nx[o] = 0.0f;
+                d->ny[o] = 0.0f;
+                d->r[o] = 0;
+                d->g[o] = 0;
+                d->b[o] = 0;
+                d->a[o] = 0;
+            }
+        }
+    }
+}
+
+bumpmap_data *bumpmap_data_new_from_surface(SDL_Surface *surface) {
+    bumpmap_data *d = bumpmap_data_new(surface->w, surface->h);
+
+    if (SDL_MUSTLOCK(surface)) {
+        SDL_LockSurface(surface);
+    }
+
+    int bpp = surface->format->BytesPerPixel;
+
+    for (int y = 0; y < surface->h; y++) {
+        Uint8 *row = (Uint8 *) surface->pixels + surface->pitch * y;
+        for (int x = 0; x < surface->w; x++) {
+            int o = surface->w * y + x;
+            Uint32 pixel = 0;
+            memcpy(&pixel, row + bpp * x, bpp);
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+            pixel >>= 8 * (4 - bpp);
+#endif
+            SDL_GetRGBA(pixel, surface->format, &d->r[o], &d->g[o], &d->b[o], &d->a[o]);
+        }
+    }
+
+    if (SDL_MUSTLOCK(surface)) {
+        SDL_UnlockSurface(surface);
+    }
+
+    bumpmap_data_compute_normals(d);
+
+    return d;
+}
+
+/******************* kernels ***************************************/
+
+/**
+ * Brightens towards white for positive light, darkens towards black
+ * for negative light
+ **/
+static inline Uint8 bumpmap_relight_channel(float c, float light) {
+    return (Uint8) (light >= 0.0f ? c + (255.0f - c) * light : c + c * light);
+}
+
+static void bumpmap_span_scalar(const bumpmap_data *d,
+                                int offset,
+                                int n,
+                                float wx,
+                                float wy,
+                                const SDL_Color *tint,
+                                Uint8 *out) {
+    for (int i = 0; i < n; i++) {
+        int o = offset + i;
+        Uint8 *px = out + 4 * i;
+
+        if (d->a[o] > 1) {
+            float light = d->nx[o] * wx + d->ny[o] * wy;
+            px[0] = bumpmap_relight_channel(tint ? tint->r : d->r[o], light);
+            px[1] = bumpmap_relight_channel(tint ? tint->g : d->g[o], light);
+            px[2] = bumpmap_relight_channel(tint ? tint->b : d->b[o], light);
+            px[3] = d->a[o];
+        } else {
+            memset(px, 0, 4);
+        }
+    }
+}
+
+#ifdef BUMPMAP_SSE2
+static inline __m128i bumpmap_load4_sse2(const Uint8 *p) {
+    int v;
+    memcpy(&v, p, sizeof(v));
+    __m128i zero = _mm_setzero_si128();
+    __m128i x = _mm_cvtsi32_si128(v);
+    x = _mm_unpacklo_epi8(x, zero);
+    return _mm_unpacklo_epi16(x, zero);
+}
+
+static inline __m128i bumpmap_relight4_sse2(__m128 c, __m128 light, __m128 positive) {
+    __m128 hi = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(255.0f), c), light));
+    __m128 lo = _mm_add_ps(c, _mm_mul_ps(c, light));
+    return _mm_cvttps_epi32(_mm_or_ps(_mm_and_ps(positive, hi), _mm_andnot_ps(positive, lo)));
+}
+
+static void bumpmap_span_sse2(const bumpmap_data *d,
+                              int offset,
+                              int n,
+                              float wx,
+                              float wy,
+                              const SDL_Color *tint,
+                              Uint8 *out) {
+    __m128 vwx = _mm_set1_ps(wx);
+    __m128 vwy = _mm_set1_ps(wy);
+    __m128 zero = _mm_setzero_ps();
+    __m128i one = _mm_set1_epi32(1);
+    __m128 tr = _mm_set1_ps(tint ? tint->r : 0);
+    __m128 tg = _mm_set1_ps(tint ? tint->g : 0);
+    __m128 tb = _mm_set1_ps(tint ? tint->b : 0);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        int o = offset + i;
+        __m128 light = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(d->nx + o), vwx),
+                                  _mm_mul_ps(_mm_loadu_ps(d->ny + o), vwy));
+        __m128 positive = _mm_cmpge_ps(light, zero);
+        __m128i a = bumpmap_load4_sse2(d->a + o);
+        __m128 r = tint ? tr : _mm_cvtepi32_ps(bumpmap_load4_sse2(d->r + o));
+        __m128 g = tint ? tg : _mm_cvtepi32_ps(bumpmap_load4_sse2(d->g + o));
+        __m128 b = tint ? tb : _mm_cvtepi32_ps(bumpmap_load4_sse2(d->b + o));
+
+        __m128i px = bumpmap_relight4_sse2(r, light, positive);
+        px = _mm_or_si128(px, _mm_slli_epi32(bumpmap_relight4_sse2(g, light, positive), 8));
+        px = _mm_or_si128(px, _mm_slli_epi32(bumpmap_relight4_sse2(b, light, positive), 16));
+        px = _mm_or_si128(px, _mm_slli_epi32(a, 24));
+        px = _mm_and_si128(px, _mm_cmpgt_epi32(a, one));
+
+        _mm_storeu_si128((__m128i *) (out + 4 * i), px);
+    }
+
+    bumpmap_span_scalar(d, offset + i, n - i, wx, wy, tint, out + 4 * i);
+}
+#endif
+
+#ifdef BUMPMAP_AVX2
+__attribute__((target("avx2"))) static void bumpmap_span_avx2(const bumpmap_data *d,
+                                                              int offset,
+                                                              int n,
+                                                              float wx,
+                                                              float wy,
+                                                              const SDL_Color *tint,
+                                                              Uint8 *out) {
+    __m256 vwx = _mm256_set1_ps(wx);
+    __m256 vwy = _mm256_set1_ps(wy);
+    __m256 v255 = _mm256_set1_ps(255.0f);
+    __m256 zero = _mm256_setzero_ps();
+    __m256i one = _mm256_set1_epi32(1);
+    __m256 tint_c[3] = {_mm256_set1_ps(tint ? tint->r : 0),
+                        _mm256_set1_ps(tint ? tint->g : 0),
+                        _mm256_set1_ps(tint ? tint->b : 0)};
+    const Uint8 *planes[3] = {d->r, d->g, d->b};
+    int i = 0;
+
+    for (; i + 8 <= n; i += 8) {
+        int o = offset + i;
+        __m256 light = _mm256_add_ps(_mm256_mul_ps(_mm256_loadu_ps(d->nx + o), vwx),
+                                     _mm256_mul_ps(_mm256_loadu_ps(d->ny + o), vwy));
+        __m256 positive = _mm256_cmp_ps(light, zero, _CMP_GE_OQ);
+        __m256i a = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) (d->a + o)));
+        __m256i px = _mm256_slli_epi32(a, 24);
+
+        for (int ch = 0; ch < 3; ch++) {
+            __m256 c = tint ? tint_c[ch]
+                            : _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+                                  _mm_loadl_epi64((const __m128i *) (planes[ch] + o))));
+            __m256 hi = _mm256_add_ps(c, _mm256_mul_ps(_mm256_sub_ps(v255, c), light));
+            __m256 lo = _mm256_add_ps(c, _mm256_mul_ps(c, light));
+            __m256i lit = _mm256_cvttps_epi32(_mm256_blendv_ps(lo, hi, positive));
+            px = _mm256_or_si256(px, _mm256_slli_epi32(lit, 8 * ch));
+        }
+
+        px = _mm256_and_si256(px, _mm256_cmpgt_epi32(a, one));
+        _mm256_storeu_si256((__m256i *) (out + 4 * i), px);
+    }
+
+    bumpmap_span_scalar(d, offset + i, n - i, wx, wy, tint, out + 4 * i);
+}
+#endif
+
+#ifdef BUMPMAP_NEON
+static inline float32x4_t bumpmap_load4_neon(const Uint8 *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    uint16x8_t x = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(v)));
+    return vcvtq_f32_u32(vmovl_u16(vget_low_u16(x)));
+}
+
+static inline uint32x4_t bumpmap_relight4_neon(float32x4_t c, float32x4_t light, uint32x4_t positive) {
+    float32x4_t hi = vmlaq_f32(c, vsubq_f32(vdupq_n_f32(255.0f), c), light);
+    float32x4_t lo = vmlaq_f32(c, c, light);
+    return vcvtq_u32_f32(vmaxq_f32(vbslq_f32(positive, hi, lo), vdupq_n_f32(0.0f)));
+}
+
+static void bumpmap_span_neon(const bumpmap_data *d,
+                              int offset,
+                              int n,
+                              float wx,
+                              float wy,
+                              const SDL_Color *tint,
+                              Uint8 *out) {
+    float32x4_t vwx = vdupq_n_f32(wx);
+    float32x4_t vwy = vdupq_n_f32(wy);
+    float32x4_t tr = vdupq_n_f32(tint ? tint->r : 0);
+    float32x4_t tg = vdupq_n_f32(tint ? tint->g : 0);
+    float32x4_t tb = vdupq_n_f32(tint ? tint->b : 0);
+    int i = 0;
+
+    for (; i + 4 <= n; i += 4) {
+        int o = offset + i;
+        float32x4_t light = vmlaq_f32(vmulq_f32(vld1q_f32(d->nx + o), vwx), vld1q_f32(d->ny + o), vwy);
+        uint32x4_t positive = vcgeq_f32(light, vdupq_n_f32(0.0f));
+        uint32x4_t a = vcvtq_u32_f32(bumpmap_load4_neon(d->a + o));
+        float32x4_t r = tint ? tr : bumpmap_load4_neon(d->r + o);
+        float32x4_t g = tint ? tg : bumpmap_load4_neon(d->g + o);
+        float32x4_t b = tint ? tb : bumpmap_load4_neon(d->b + o);
+
+        uint32x4_t px = bumpmap_relight4_neon(r, light, positive);
+        px = vorrq_u32(px, vshlq_n_u32(bumpmap_relight4_neon(g, light, positive), 8));
+        px = vorrq_u32(px, vshlq_n_u32(bumpmap_relight4_neon(b, light, positive), 16));
+        px = vorrq_u32(px, vshlq_n_u32(a, 24));
+        px = vandq_u32(px, vcgtq_u32(a, vdupq_n_u32(1)));
+
+        vst1q_u32((uint32_t *) (out + 4 * i), px);
+    }
+
+    bumpmap_span_scalar(d, offset + i, n - i, wx, wy, tint, out + 4 * i);
+}
+#endif
+
+/******************* dispatch ***************************************/
+
+static bumpmap_span_fn *bumpmap_span = NULL;
+
+/**
+ * Returns the kernel with the given name, if it is compiled in and
+ * supported by the CPU
+ **/
+bumpmap_span_fn *bumpmap_kernel_lookup(const char *name) {
+    if (!name) {
+        return NULL;
+    }
+#ifdef BUMPMAP_AVX2
+    if (!strcmp(name, "avx2") && SDL_HasAVX2()) {
+        return bumpmap_span_avx2;
+    }
+#endif
+#ifdef BUMPMAP_SSE2
+    if (!strcmp(name, "sse2") && SDL_HasSSE2()) {
+        return bumpmap_span_sse2;
+    }
+#endif
+#ifdef BUMPMAP_NEON
+    if (!strcmp(name, "neon") && SDL_HasNEON()) {
+        return bumpmap_span_neon;
+    }
+#endif
+    if (!strcmp(name, "scalar")) {
+        return bumpmap_span_scalar;
+    }
+    return NULL;
+}
+
+/**
+ * Selects the kernel by name or the fastest available one (name = NULL)
+ **/
+const char *bumpmap_kernel_select(const char *name) {
+    static const char *kernels[] = {"avx2", "sse2", "neon", "scalar"};
+
+    if (name) {
+        bumpmap_span_fn *span = bumpmap_kernel_lookup(name);
+        if (span) {
+            bumpmap_span = span;
+            log_config(MENU_CTX, "Bump map kernel: %s\n", name);
+            return name;
+        }
+        log_warning(MENU_CTX, "Bump map kernel %s not available\n", name);
+    }
+
+    for (unsigned int k = 0; k < sizeof(kernels) / sizeof(kernels[0]); k++) {
+        bumpmap_span_fn *span = bumpmap_kernel_lookup(kernels[k]);
+        if (span) {
+            bumpmap_span = span;
+            log_config(MENU_CTX, "Bump map kernel: %s\n", kernels[k]);
+            return kernels[k];
+        }
+    }
+
+    return NULL;
+}
+
+void bumpmap_relight(const bumpmap_data *d, float wx, float wy, const SDL_Color *tint, Uint8 *pixels, int pitch) {
+    if (!bumpmap_span) {
+        bumpmap_kernel_select(NULL);
+    }
+
+    for (int y = 0; y < d->h; y++) {
+        bumpmap_span(d, d->w * y, d->w, wx, wy, tint, pixels + pitch * y);
+    }
+}
@@ -0,0 +1,61 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BUMPMAP_KERNEL_H
+#define BUMPMAP_KERNEL_H
+
+#include<SDL2/SDL.h>
+
+/**
+ * Bump map data of one glyph as structure of arrays (w * h each)
+ **/
+typedef struct bumpmap_data {
+    int w;
+    int h;
+    float *nx;
+    float *ny;
+    Uint8 *r;
+    Uint8 *g;
+    Uint8 *b;
+    Uint8 *a;
+} bumpmap_data;
+
+/**
+ * Relights n pixels starting at offset. wx and wy are the light vector
+ * rotated into glyph space, so the light of a pixel is nx * wx + ny * wy.
+ * With tint != NULL the color planes are ignored. Writes RGBA32 pixels.
+ **/
+typedef void bumpmap_span_fn(const bumpmap_data *d,
+                             int offset,
+                             int n,
+                             float wx,
+                             float wy,
+                             const SDL_Color *tint,
+                             Uint8 *out);
+
+bumpmap_data *bumpmap_data_new(int w, int h);
+bumpmap_data *bumpmap_data_new_from_surface(SDL_Surface *surface);
+void bumpmap_data_compute_normals(bumpmap_data *d);
+void bumpmap_data_free(bumpmap_data *d);
+
+bumpmap_span_fn *bumpmap_kernel_lookup(const char *name);
+const char *bumpmap_kernel_select(const char *name);
+void bumpmap_relight(const bumpmap_data *d, float wx, float wy, const SDL_Color *tint, Uint8 *pixels, int pitch);
+
+#endif // BUMPMAP_KERNEL_H
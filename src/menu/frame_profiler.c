@@ -0,0 +1,210 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Times the phases of each frame and keeps the last samples of every
+ * phase, so percentiles can be reported on SIGUSR1 or periodically.
+ * While disabled frame_profiler_now returns 0 and nothing is recorded.
+ **/
+#include "frame_profiler.h"
+#include "../base/log_contexts.h"
+#include "../base/logging.h"
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct frame_profiler_series {
+    Uint32 samples[FRAME_PROFILER_SAMPLES]; /* Microseconds, a ring buffer */
+    int n;
+    int next;
+} frame_profiler_series;
+
+static const char *frame_phase_names[FRAME_PHASE_COUNT] = {
+    "clear", "scales", "items", " shadows", " bumpmap", "indicator", "light", "present", "frame", "callback"};
+
+static struct {
+    int enabled;
+    int dump_seconds;
+    Uint64 last_dump;
+    int in_frame;
+    Uint64 frame_start;
+    Uint64 current[FRAME_PHASE_COUNT]; /* Accumulated over the current frame */
+    frame_profiler_series series[FRAME_PHASE_COUNT];
+} profiler;
+
+static volatile sig_atomic_t dump_requested = 0;
+
+static Uint64 frame_profiler_clock(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (Uint64) ts.tv_sec * 1000000000ULL + (Uint64) ts.tv_nsec;
+}
+
+static void frame_profiler_sample(frame_phase phase, Uint64 ns) {
+    frame_profiler_series *series = &profiler.series[phase];
+    Uint64 us = ns / 1000;
+    series->samples[series->next] = us > 0xffffffff ? 0xffffffff : (Uint32) us;
+    series->next = (series->next + 1) % FRAME_PROFILER_SAMPLES;
+    if (series->n < FRAME_PROFILER_SAMPLES) {
+        series->n++;
+    }
+}
+
+static void frame_profiler_signal(int sig) {
+    (void) sig;
+    dump_requested = 1;
+}
+
+/**
+ * Starts (or stops) recording. With dump_seconds > 0 the percentiles
+ * are logged every dump_seconds.
+ **/
+void frame_profiler_enable(int enable, int dump_seconds) {
+    if (enable && !profiler.enabled) {
+        memset(profiler.series, 0, sizeof(profiler.series));
+        memset(profiler.current, 0, sizeof(profiler.current));
+        profiler.in_frame = 0;
+        profiler.last_dump = frame_profiler_clock();
+    }
+    profiler.enabled = enable;
+    profiler.dump_seconds = dump_seconds > 0 ? dump_seconds : 0;
+}
+
+/**
+ * SIGUSR1 enables the profiler, if it isn't already, and requests a
+ * report otherwise. The report is logged by the next frame_profiler_poll.
+ **/
+void frame_profiler_install_signal(void) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = frame_profiler_signal;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    if (sigaction(SIGUSR1, &action, NULL) != 0) {
+        log_warning(MENU_CTX, "Could not install the frame profiler signal handler\n");
+    }
+}
+
+Uint64 frame_profiler_now(void) {
+    return profiler.enabled ? frame_profiler_clock() : 0;
+}
+
+/**
+ * Adds the time since start to phase in the current frame
+ **/
+void frame_profiler_add(frame_phase phase, Uint64 start) {
+    if (start && profiler.enabled) {
+        profiler.current[phase] += frame_profiler_clock() - start;
+    }
+}
+
+/**
+ * Records the time since start as one sample of phase
+ **/
+void frame_profiler_record(frame_phase phase, Uint64 start) {
+    if (start && profiler.enabled) {
+        frame_profiler_sample(phase, frame_profiler_clock() - start);
+    }
+}
+
+/**
+ * A frame may consist of several menus drawn before they are presented,
+ * it begins with the first one
+ **/
+void frame_profiler_frame_begin(void) {
+    if (profiler.enabled && !profiler.in_frame) {
+        profiler.in_frame = 1;
+        profiler.frame_start = frame_profiler_clock();
+    }
+}
+
+void frame_profiler_frame_end(void) {
+    if (!profiler.enabled) {
+        return;
+    }
+
+    if (profiler.in_frame) {
+        profiler.current[FRAME_PHASE_FRAME] = frame_profiler_clock() - profiler.frame_start;
+        for (int p = 0; p < FRAME_PHASE_COUNT; p++) {
+            if (p != FRAME_PHASE_CALLBACK) {
+                frame_profiler_sample(p, profiler.current[p]);
+            }
+        }
+    }
+
+    memset(profiler.current, 0, sizeof(profiler.current));
+    profiler.in_frame = 0;
+}
+
+/**
+ * Called by the menu loop, logs the report if it has been requested by
+ * SIGUSR1 or is due
+ **/
+void frame_profiler_poll(void) {
+    if (dump_requested) {
+        dump_requested = 0;
+        if (!profiler.enabled) {
+            frame_profiler_enable(1, profiler.dump_seconds);
+            log_info(MENU_CTX, "Frame profiler enabled, send SIGUSR1 again for a report\n");
+        } else {
+            frame_profiler_dump();
+        }
+    } else if (profiler.enabled && profiler.dump_seconds > 0
+               && frame_profiler_clock() - profiler.last_dump >= (Uint64) profiler.dump_seconds * 1000000000ULL) {
+        frame_profiler_dump();
+    }
+}
+
+static int frame_profiler_compare(const void *a, const void *b) {
+    Uint32 x = *(const Uint32 *) a;
+    Uint32 y = *(const Uint32 *) b;
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static double frame_profiler_percentile(const Uint32 *sorted, int n, int percent) {
+    int i = (n * percent + 99) / 100 - 1;
+    return sorted[i < 0 ? 0 : i] / 1000.0;
+}
+
+void frame_profiler_dump(void) {
+    Uint32 sorted[FRAME_PROFILER_SAMPLES];
+
+    profiler.last_dump = frame_profiler_clock();
+
+    log_info(MENU_CTX, "Frame profiler, last %d frames (ms):\n", profiler.series[FRAME_PHASE_FRAME].n);
+    log_info(MENU_CTX, "%-10s %8s %8s %8s %8s %8s\n", "phase", "p50", "p95", "p99", "max", "samples");
+    for (int p = 0; p < FRAME_PHASE_COUNT; p++) {
+        frame_profiler_series *series = &profiler.series[p];
+        if (series->n == 0) {
+            log_info(MENU_CTX, "%-10s %8s %8s %8s %8s %8d\n", frame_phase_names[p], "-", "-", "-", "-", 0);
+            continue;
+        }
+        memcpy(sorted, series->samples, series->n * sizeof(Uint32));
+        qsort(sorted, series->n, sizeof(Uint32), frame_profiler_compare);
+        log_info(MENU_CTX,
+                 "%-10s %8.2f %8.2f %8.2f %8.2f %8d\n",
+                 frame_phase_names[p],
+                 frame_profiler_percentile(sorted, series->n, 50),
+                 frame_profiler_percentile(sorted, series->n, 95),
+                 frame_profiler_percentile(sorted, series->n, 99),
+                 sorted[series->n - 1] / 1000.0,
+                 series->n);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include<SDL2/SDL.h>
+
+/* The number of frames the percentiles are computed over */
+#define FRAME_PROFILER_SAMPLES 512
+
+/**
+ * The phases of a frame. Shadows and bump map updates happen while
+ * drawing the items and are included in FRAME_PHASE_ITEMS.
+ **/
+typedef enum frame_phase {
+    FRAME_PHASE_CLEAR = 0,
+    FRAME_PHASE_SCALES,
+    FRAME_PHASE_ITEMS,
+    FRAME_PHASE_SHADOWS,
+    FRAME_PHASE_BUMPMAP,
+    FRAME_PHASE_INDICATOR,
+    FRAME_PHASE_LIGHT,
+    FRAME_PHASE_PRESENT,
+    FRAME_PHASE_FRAME,
+    FRAME_PHASE_CALLBACK, /* Not part of a frame, one sample per call */
+    FRAME_PHASE_COUNT
+} frame_phase;
+
+void frame_profiler_enable(int enable, int dump_seconds);
+void frame_profiler_install_signal(void);
+Uint64 frame_profiler_now(void);
+void frame_profiler_add(frame_phase phase, Uint64 start);
+void frame_profiler_record(frame_phase phase, Uint64 start);
+void frame_profiler_frame_begin(void);
+void frame_profiler_frame_end(void);
+void frame_profiler_poll(void);
+void frame_profiler_dump(void);
+
+#endif // FRAME_PROFILER_H
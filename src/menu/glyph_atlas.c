@@ -0,0 +1,512 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Glyph atlas shared by all text objects. Glyphs are rendered once per
+ * (font, codepoint) into large texture pages and all quads using the
+ * same page are sent to the renderer with one SDL_RenderGeometry call.
+ **/
+#include "glyph_atlas.h"
+#include "../base/log_contexts.h"
+#include "../base/logging.h"
+#include "../base/util.h"
+#include "../util/sdl_util.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#define GLYPH_ATLAS_PAGE_SIZE 512
+#define GLYPH_ATLAS_PADDING 1
+#define GLYPH_ATLAS_BUCKETS 256
+#define GLYPH_ATLAS_INITIAL_QUADS 64
+
+typedef struct glyph_atlas_page {
+    SDL_Texture *texture;
+    int shelf_x;
+    int shelf_y;
+    int shelf_h;
+    int n_entries;
+} glyph_atlas_page;
+
+typedef struct glyph_atlas_quad {
+    SDL_Rect src;
+    SDL_Rect dst;
+    double angle;
+    SDL_Point rot_center;
+    SDL_Color color;
+} glyph_atlas_quad;
+
+struct glyph_atlas {
+    SDL_Renderer *renderer;
+    glyph_atlas_page *pages;
+    int n_pages;
+    glyph_atlas_entry *buckets[GLYPH_ATLAS_BUCKETS];
+    glyph_atlas_entry *orphans; /* Entries of closed fonts which are still referenced */
+    glyph_atlas_quad *quads;
+    int n_quads;
+    int max_quads;
+    int batch_page;
+    SDL_Vertex *vertices;
+    int *indices;
+    int use_geometry;
+    int shade_unsupported; /* The renderer rejected the blend mode of the linear bump map gradients */
+};
+
+static Uint32 glyph_atlas_hash(TTF_Font *font, Uint16 c, int blur) {
+    uintptr_t f = (uintptr_t) font;
+    return (Uint32) ((f >> 4) ^ (f >> 12) ^ ((Uint32) c * 2654435761u) ^ ((Uint32) blur * 40503u)) % GLYPH_ATLAS_BUCKETS;
+}
+
+glyph_atlas *glyph_atlas_new(SDL_Renderer *renderer) {
+    glyph_atlas *atlas = calloc(1, sizeof(glyph_atlas));
+    atlas->renderer = renderer;
+    atlas->batch_page = -1;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    atlas->use_geometry = 1;
+#else
+    atlas->use_geometry = 0;
+#endif
+    return atlas;
+}
+
+int glyph_atlas_shade_unsupported(const glyph_atlas *atlas) {
+    return atlas && atlas->shade_unsupported;
+}
+
+void glyph_atlas_set_shade_unsupported(glyph_atlas *atlas) {
+    if (atlas) {
+        atlas->shade_unsupported = 1;
+    }
+}
+
+static void glyph_atlas_page_reset(glyph_atlas_page *page) {
+    page->shelf_x = 0;
+    page->shelf_y = 0;
+    page->shelf_h = 0;
+}
+
+static int glyph_atlas_page_pack(glyph_atlas_page *page, int w, int h, SDL_Rect *rect) {
+    if (w > GLYPH_ATLAS_PAGE_SIZE || h > GLYPH_ATLAS_PAGE_SIZE) {
+        return 0;
+    }
+
+    if (page->shelf_x + w > GLYPH_ATLAS_PAGE_SIZE) {
+        page->shelf_y += page->shelf_h;
+        page->shelf_x = 0;
+        page->shelf_h = 0;
+    }
+
+    if (page->shelf_y + h > GLYPH_ATLAS_PAGE_SIZE) {
+        return 0;
+    }
+
+    rect->x = page->shelf_x;
+    rect->y = page->shelf_y;
+    rect->w = w;
+    rect->h = h;
+
+    page->shelf_x += w;
+    if (h > page->shelf_h) {
+        page->shelf_h = h;
+    }
+
+    return 1;
+}
+
+static int glyph_atlas_add_page(glyph_atlas *atlas) {
+    SDL_Texture *texture = SDL_CreateTexture(atlas->renderer,
+                                             DEFAULT_SDL_PIXELFORMAT,
+                                             SDL_TEXTUREACCESS_STATIC,
+                                             GLYPH_ATLAS_PAGE_SIZE,
+                                             GLYPH_ATLAS_PAGE_SIZE);
+    if (!texture) {
+        log_error(MENU_CTX, "Could not create glyph atlas page: %s\n", SDL_GetError());
+        return -1;
+    }
+
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    Uint32 *pixels = calloc(GLYPH_ATLAS_PAGE_SIZE * GLYPH_ATLAS_PAGE_SIZE, sizeof(Uint32));
+    SDL_UpdateTexture(texture, NULL, pixels, GLYPH_ATLAS_PAGE_SIZE * sizeof(Uint32));
+    free(pixels);
+
+    atlas->pages = realloc(atlas->pages, (atlas->n_pages + 1) * sizeof(glyph_atlas_page));
+    glyph_atlas_page *page = &atlas->pages[atlas->n_pages];
+    page->texture = texture;
+    page->n_entries = 0;
+    glyph_atlas_page_reset(page);
+
+    log_config(MENU_CTX, "Added glyph atlas page %d\n", atlas->n_pages);
+
+    return atlas->n_pages++;
+}
+
+/**
+ * Copies the glyph surface into a page. The glyph is surrounded by a
+ * transparent border so that filtering never picks up the neighbours.
+ **/
+static int glyph_atlas_upload(glyph_atlas *atlas, glyph_atlas_entry *entry, SDL_Surface *glyph) {
+    int w = glyph->w + 2 * GLYPH_ATLAS_PADDING;
+    int h = glyph->h + 2 * GLYPH_ATLAS_PADDING;
+    SDL_Rect padded;
+    int page = -1;
+
+    for (int p = 0; p < atlas->n_pages && page < 0; p++) {
+        if (glyph_atlas_page_pack(&atlas->pages[p], w, h, &padded)) {
+            page = p;
+        }
+    }
+
+    if (page < 0) {
+        page = glyph_atlas_add_page(atlas);
+        if (page < 0) {
+            return 0;
+        }
+        if (!glyph_atlas_page_pack(&atlas->pages[page], w, h, &padded)) {
+            log_error(MENU_CTX, "Glyph %d does not fit into an atlas page (%dx%d)\n", entry->c, w, h);
+            return 0;
+        }
+    }
+
+    SDL_Surface *surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, DEFAULT_SDL_PIXELFORMAT);
+    if (!surface) {
+        log_error(MENU_CTX, "Could not create glyph atlas surface: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    SDL_Rect inner = {GLYPH_ATLAS_PADDING, GLYPH_ATLAS_PADDING, glyph->w, glyph->h};
+    SDL_SetSurfaceBlendMode(glyph, SDL_BLENDMODE_NONE);
+    SDL_BlitSurface(glyph, NULL, surface, &inner);
+
+    if (SDL_UpdateTexture(atlas->pages[page].texture, &padded, surface->pixels, surface->pitch) != 0) {
+        log_error(MENU_CTX, "Could not update glyph atlas page: %s\n", SDL_GetError());
+        SDL_FreeSurface(surface);
+        return 0;
+    }
+
+    SDL_FreeSurface(surface);
+
+    entry->page = page;
+    entry->rect.x = padded.x + GLYPH_ATLAS_PADDING;
+    entry->rect.y = padded.y + GLYPH_ATLAS_PADDING;
+    atlas->pages[page].n_entries++;
+
+    return 1;
+}
+
+static glyph_atlas_entry *glyph_atlas_lookup(glyph_atlas *atlas, TTF_Font *font, Uint16 c, int blur) {
+    if (!atlas || !font) {
+        return NULL;
+    }
+
+    Uint32 bucket = glyph_atlas_hash(font, c, blur);
+
+    for (glyph_atlas_entry *e = atlas->buckets[bucket]; e; e = e->next) {
+        if (e->font == font && e->c == c && e->blur == blur) {
+            e->refs++;
+            return e;
+        }
+    }
+
+    SDL_Color white = {255, 255, 255, 255};
+    glyph_atlas_entry *entry = calloc(1, sizeof(glyph_atlas_entry));
+    my_LockTTF();
+    SDL_Surface *glyph = TTF_RenderGlyph_Blended(font, c, white);
+    if (!glyph) {
+        log_error(MENU_CTX, "Could not render glyph %c: %s\n", c, TTF_GetError());
+        my_UnlockTTF();
+        free(entry);
+        return NULL;
+    }
+    TTF_GlyphMetrics(font, c, &entry->minx, &entry->maxx, &entry->miny, &entry->maxy, &entry->advance);
+    my_UnlockTTF();
+
+    if (blur > 0) {
+        SDL_Surface *shadow = new_shadow_surface(glyph, blur);
+        SDL_FreeSurface(glyph);
+        if (!shadow) {
+            free(entry);
+            return NULL;
+        }
+        glyph = shadow;
+    }
+
+    entry->atlas = atlas;
+    entry->font = font;
+    entry->c = c;
+    entry->blur = blur;
+    entry->page = -1;
+    entry->rect.w = glyph->w;
+    entry->rect.h = glyph->h;
+
+    if (glyph->w > 0 && glyph->h > 0 && !glyph_atlas_upload(atlas, entry, glyph)) {
+        SDL_FreeSurface(glyph);
+        free(entry);
+        return NULL;
+    }
+
+    SDL_FreeSurface(glyph);
+
+    entry->refs = 1;
+    entry->next = atlas->buckets[bucket];
+    atlas->buckets[bucket] = entry;
+
+    return entry;
+}
+
+glyph_atlas_entry *glyph_atlas_get(glyph_atlas *atlas, TTF_Font *font, Uint16 c) {
+    return glyph_atlas_lookup(atlas, font, c, 0);
+}
+
+/**
+ * The soft shadow of a glyph: white with the blurred glyph alpha, grown
+ * by blur pixels on each side
+ **/
+glyph_atlas_entry *glyph_atlas_get_shadow(glyph_atlas *atlas, TTF_Font *font, Uint16 c, int blur) {
+    return glyph_atlas_lookup(atlas, font, c, blur);
+}
+
+static void glyph_atlas_destroy_entry(glyph_atlas *atlas, glyph_atlas_entry *entry) {
+    if (entry->page >= 0) {
+        glyph_atlas_page *page = &atlas->pages[entry->page];
+        if (--page->n_entries <= 0) {
+            /* Pending quads may still sample the page */
+            glyph_atlas_flush(atlas);
+            page->n_entries = 0;
+            glyph_atlas_page_reset(page);
+        }
+    }
+    free(entry);
+}
+
+void glyph_atlas_release(glyph_atlas_entry *entry) {
+    if (!entry || --entry->refs > 0) {
+        return;
+    }
+
+    /* Entries of open fonts stay cached */
+    if (entry->font) {
+        return;
+    }
+
+    glyph_atlas *atlas = entry->atlas;
+    glyph_atlas_entry **e = &atlas->orphans;
+    while (*e && *e != entry) {
+        e = &(*e)->next;
+    }
+    if (*e) {
+        *e = entry->next;
+    }
+
+    glyph_atlas_destroy_entry(atlas, entry);
+}
+
+/**
+ * Must be called before the font is closed. Otherwise a font opened
+ * later at the same address would find the stale glyphs.
+ **/
+void glyph_atlas_forget_font(glyph_atlas *atlas, TTF_Font *font) {
+    if (!atlas || !font) {
+        return;
+    }
+
+    glyph_atlas_flush(atlas);
+
+    for (int b = 0; b < GLYPH_ATLAS_BUCKETS; b++) {
+        glyph_atlas_entry **e = &atlas->buckets[b];
+        while (*e) {
+            glyph_atlas_entry *entry = *e;
+            if (entry->font == font) {
+                *e = entry->next;
+                if (entry->refs > 0) {
+                    entry->font = NULL;
+                    entry->next = atlas->orphans;
+                    atlas->orphans = entry;
+                } else {
+                    glyph_atlas_destroy_entry(atlas, entry);
+                }
+            } else {
+                e = &entry->next;
+            }
+        }
+    }
+}
+
+/**
+ * Releases a font from my_OpenTTF_Font. The glyphs are forgotten only
+ * with the last user, the others keep drawing from the atlas.
+ **/
+void glyph_atlas_close_font(glyph_atlas *atlas, TTF_Font *font) {
+    if (!font) {
+        return;
+    }
+    if (my_TTF_FontRefs(font) <= 1) {
+        glyph_atlas_forget_font(atlas, font);
+    }
+    my_CloseTTF_Font(font);
+}
+
+void glyph_atlas_draw(glyph_atlas *atlas,
+                      const glyph_atlas_entry *entry,
+                      const SDL_Rect *dst,
+                      double angle,
+                      const SDL_Point *rot_center,
+                      SDL_Color color) {
+    if (!atlas || !entry || entry->page < 0) {
+        return;
+    }
+
+    if (atlas->n_quads > 0 && atlas->batch_page != entry->page) {
+        glyph_atlas_flush(atlas);
+    }
+
+    if (atlas->n_quads >= atlas->max_quads) {
+        int max_quads = atlas->max_quads > 0 ? 2 * atlas->max_quads : GLYPH_ATLAS_INITIAL_QUADS;
+        atlas->quads = realloc(atlas->quads, max_quads * sizeof(glyph_atlas_quad));
+        atlas->vertices = realloc(atlas->vertices, 4 * max_quads * sizeof(SDL_Vertex));
+        atlas->indices = realloc(atlas->indices, 6 * max_quads * sizeof(int));
+        for (int q = atlas->max_quads; q < max_quads; q++) {
+            int *i = &atlas->indices[6 * q];
+            i[0] = 4 * q;
+            i[1] = 4 * q + 1;
+            i[2] = 4 * q + 2;
+            i[3] = 4 * q;
+            i[4] = 4 * q + 2;
+            i[5] = 4 * q + 3;
+        }
+        atlas->max_quads = max_quads;
+    }
+
+    glyph_atlas_quad *quad = &atlas->quads[atlas->n_quads++];
+    quad->src = entry->rect;
+    quad->dst = *dst;
+    quad->angle = angle;
+    quad->rot_center = *rot_center;
+    quad->color = color;
+    atlas->batch_page = entry->page;
+}
+
+/**
+ * Same transformation as SDL_RenderCopyEx: rotate clockwise by angle
+ * degrees around dst + rot_center.
+ **/
+static void glyph_atlas_quad_vertices(const glyph_atlas_quad *quad, SDL_Vertex *v) {
+    double a = M_PI * quad->angle / 180.0;
+    float s = (float) sin(a);
+    float c = (float) cos(a);
+    float px = (float) (quad->dst.x + quad->rot_center.x);
+    float py = (float) (quad->dst.y + quad->rot_center.y);
+    float x0 = (float) -quad->rot_center.x;
+    float y0 = (float) -quad->rot_center.y;
+    float x1 = x0 + quad->dst.w;
+    float y1 = y0 + quad->dst.h;
+    float u0 = (float) quad->src.x / GLYPH_ATLAS_PAGE_SIZE;
+    float v0 = (float) quad->src.y / GLYPH_ATLAS_PAGE_SIZE;
+    float u1 = (float) (quad->src.x + quad->src.w) / GLYPH_ATLAS_PAGE_SIZE;
+    float v1 = (float) (quad->src.y + quad->src.h) / GLYPH_ATLAS_PAGE_SIZE;
+    float xs[4] = {x0, x1, x1, x0};
+    float ys[4] = {y0, y0, y1, y1};
+    float us[4] = {u0, u1, u1, u0};
+    float vs[4] = {v0, v0, v1, v1};
+
+    for (int i = 0; i < 4; i++) {
+        v[i].position.x = px + c * xs[i] - s * ys[i];
+        v[i].position.y = py + s * xs[i] + c * ys[i];
+        v[i].color = quad->color;
+        v[i].tex_coord.x = us[i];
+        v[i].tex_coord.y = vs[i];
+    }
+}
+
+void glyph_atlas_flush(glyph_atlas *atlas) {
+    if (!atlas || atlas->n_quads == 0) {
+        return;
+    }
+
+    SDL_Texture *texture = atlas->pages[atlas->batch_page].texture;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (atlas->use_geometry) {
+        for (int q = 0; q < atlas->n_quads; q++) {
+            glyph_atlas_quad_vertices(&atlas->quads[q], &atlas->vertices[4 * q]);
+        }
+
+        if (SDL_RenderGeometry(atlas->renderer,
+                               texture,
+                               atlas->vertices,
+                               4 * atlas->n_quads,
+                               atlas->indices,
+                               6 * atlas->n_quads) == 0) {
+            atlas->n_quads = 0;
+            return;
+        }
+
+        log_warning(MENU_CTX, "SDL_RenderGeometry failed: %s. Falling back to SDL_RenderCopyEx\n", SDL_GetError());
+        atlas->use_geometry = 0;
+    }
+#endif
+
+    for (int q = 0; q < atlas->n_quads; q++) {
+        glyph_atlas_quad *quad = &atlas->quads[q];
+        SDL_SetTextureColorMod(texture, quad->color.r, quad->color.g, quad->color.b);
+        SDL_SetTextureAlphaMod(texture, quad->color.a);
+        SDL_RenderCopyEx(atlas->renderer, texture, &quad->src, &quad->dst, quad->angle,
+                         &quad->rot_center, SDL_FLIP_NONE);
+    }
+
+    SDL_SetTextureColorMod(texture, 255, 255, 255);
+    SDL_SetTextureAlphaMod(texture, 255);
+
+    atlas->n_quads = 0;
+}
+
+void glyph_atlas_free(glyph_atlas *atlas) {
+    if (atlas) {
+        for (int b = 0; b < GLYPH_ATLAS_BUCKETS; b++) {
+            glyph_atlas_entry *e = atlas->buckets[b];
+            while (e) {
+                glyph_atlas_entry *next = e->next;
+                free(e);
+                e = next;
+            }
+            atlas->buckets[b] = NULL;
+        }
+
+        glyph_atlas_entry *e = atlas->orphans;
+        while (e) {
+            glyph_atlas_entry *next = e->next;
+            free(e);
+            e = next;
+        }
+        atlas->orphans = NULL;
+
+        for (int p = 0; p < atlas->n_pages; p++) {
+            if (atlas->pages[p].texture) {
+                SDL_DestroyTexture(atlas->pages[p].texture);
+            }
+        }
+
+        free_and_set_null((void **) &atlas->pages);
+        free_and_set_null((void **) &atlas->quads);
+        free_and_set_null((void **) &atlas->vertices);
+        free_and_set_null((void **) &atlas->indices);
+
+        free(atlas);
+    }
+}
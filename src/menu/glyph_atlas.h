@@ -0,0 +1,72 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include<SDL2/SDL.h>
+#include<SDL2/SDL_ttf.h>
+
+typedef struct glyph_atlas glyph_atlas;
+
+/**
+ * One glyph stored in an atlas page. The glyph is rendered white,
+ * the color is applied when drawing.
+ **/
+typedef struct glyph_atlas_entry {
+    glyph_atlas *atlas;
+    TTF_Font *font; /* NULL, if the font has been closed while the entry was still in use */
+    Uint16 c;
+    int blur; /* > 0 for blurred shadow glyphs */
+    int page;
+    SDL_Rect rect; /* The position of the glyph in the page texture */
+    int minx;
+    int maxx;
+    int miny;
+    int maxy;
+    int advance;
+    int refs;
+    struct glyph_atlas_entry *next;
+} glyph_atlas_entry;
+
+glyph_atlas *glyph_atlas_new(SDL_Renderer *renderer);
+void glyph_atlas_free(glyph_atlas *atlas);
+
+glyph_atlas_entry *glyph_atlas_get(glyph_atlas *atlas, TTF_Font *font, Uint16 c);
+glyph_atlas_entry *glyph_atlas_get_shadow(glyph_atlas *atlas, TTF_Font *font, Uint16 c, int blur);
+void glyph_atlas_release(glyph_atlas_entry *entry);
+void glyph_atlas_forget_font(glyph_atlas *atlas, TTF_Font *font);
+void glyph_atlas_close_font(glyph_atlas *atlas, TTF_Font *font);
+
+void glyph_atlas_draw(glyph_atlas *atlas,
+                      const glyph_atlas_entry *entry,
+                      const SDL_Rect *dst,
+                      double angle,
+                      const SDL_Point *rot_center,
+                      SDL_Color color);
+void glyph_atlas_flush(glyph_atlas *atlas);
+
+/**
+ * Whether the renderer of the atlas can't draw the linear bump map
+ * gradients, kept here as the atlas lives as long as its renderer
+ **/
+int glyph_atlas_shade_unsupported(const glyph_atlas *atlas);
+void glyph_atlas_set_shade_unsupported(glyph_atlas *atlas);
+
+#endif // GLYPH_ATLAS_H
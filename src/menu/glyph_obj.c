@@ -25,18 +25,108 @@
 #include "../base/logging.h"
 #include "../base/util.h"
 #include "../util/sdl_util.h"
+#include "asset_cache.h"
+#include "frame_profiler.h"
 #include <SDL2/SDL2_rotozoom.h>
 
-/**
-* For bump mapping
-**/
-struct normal_vector {
-    double x;
-    double y;
-};
-
-// the number of possible angles. Don't know yet
+// the default number of cached angles (2 degrees apart)
 #define N_ANGLES 180
+#define BUMPMAP_CACHE_DEFAULT_BYTES (8 * 1024 * 1024)
+/* Frames of an animated glyph that keep their texture and bump map data */
+#define GLYPH_ANIMATION_MAX_TEXTURES 8
+/* Shorter frame delays are taken as unset, like browsers do */
+#define GLYPH_ANIMATION_MIN_DELAY_MS 20
+#define GLYPH_ANIMATION_DEFAULT_DELAY_MS 100
+
+/**
+ * Lit bump map textures at quantized angles, shared LRU over all glyphs
+ **/
+typedef struct bumpmap_cache_node {
+    glyph_obj *glyph;
+    int slot;
+    size_t bytes;
+    struct bumpmap_cache_node *prev;
+    struct bumpmap_cache_node *next;
+} bumpmap_cache_node;
+
+static struct {
+    int angle_step;
+    int n_slots;
+    size_t budget;
+    size_t bytes;
+    bumpmap_cache_node *head; /* most recently used */
+    bumpmap_cache_node *tail;
+} bumpmap_cache = {360 / N_ANGLES, N_ANGLES, BUMPMAP_CACHE_DEFAULT_BYTES, 0, NULL, NULL};
+
+/* The earliest next frame of the animated glyphs drawn, 0 if none */
+static Uint32 animation_due = 0;
+
+static void bumpmap_cache_unlink(bumpmap_cache_node *node) {
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        bumpmap_cache.head = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        bumpmap_cache.tail = node->prev;
+    }
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+static void bumpmap_cache_push(bumpmap_cache_node *node) {
+    node->next = bumpmap_cache.head;
+    if (bumpmap_cache.head) {
+        bumpmap_cache.head->prev = node;
+    }
+    bumpmap_cache.head = node;
+    if (!bumpmap_cache.tail) {
+        bumpmap_cache.tail = node;
+    }
+}
+
+static void bumpmap_cache_evict(bumpmap_cache_node *node) {
+    glyph_obj *glyph_o = node->glyph;
+
+    bumpmap_cache_unlink(node);
+    SDL_DestroyTexture(glyph_o->bumpmap_textures[node->slot]);
+    glyph_o->bumpmap_textures[node->slot] = NULL;
+    glyph_o->bumpmap_nodes[node->slot] = NULL;
+    bumpmap_cache.bytes -= node->bytes;
+    free(node);
+}
+
+static void glyph_obj_drop_bumpmap_cache(glyph_obj *glyph_o) {
+    if (glyph_o->bumpmap_nodes) {
+        for (int a = 0; a < glyph_o->n_bumpmap_textures; a++) {
+            if (glyph_o->bumpmap_nodes[a]) {
+                bumpmap_cache_evict(glyph_o->bumpmap_nodes[a]);
+            }
+        }
+    }
+}
+
+/**
+ * Sets the angle resolution (in degrees) and the memory budget of the
+ * bump map cache. A budget of 0 disables the cache.
+ **/
+void glyph_obj_set_bumpmap_cache(int angle_step, size_t budget) {
+    if (angle_step < 1) {
+        angle_step = 1;
+    }
+
+    while (bumpmap_cache.tail) {
+        bumpmap_cache_evict(bumpmap_cache.tail);
+    }
+
+    bumpmap_cache.angle_step = angle_step;
+    bumpmap_cache.n_slots = (360 + angle_step - 1) / angle_step;
+    bumpmap_cache.budget = budget;
+
+    log_config(MENU_CTX, "Bump map cache: %d degree steps, %zu bytes\n", angle_step, budget);
+}
 
 /******************* glyph_obj ***************************************/
 void glyph_obj_free(glyph_obj *obj) {
@@ -44,57 +134,59 @@ void glyph_obj_free(glyph_obj *obj) {
     if (obj) {
         if (obj->animated) {
             glyph_obj_animated *animated = (glyph_obj_animated *) obj;
-            SDL_Texture *current_overlay = obj->bumpmap_overlay;
-
-            for (int i = 0; i < animated->n_animations; i++) {
-                if (animated->textures && animated->textures[i]) {
-                    SDL_DestroyTexture(animated->textures[i]);
-                }
-                if (animated->surfaces && animated->surfaces[i]) {
-                    SDL_FreeSurface(animated->surfaces[i]);
-                }
-                if (animated->colorss) {
-                    free(animated->colorss[i]);
-                }
-                if (animated->normalss) {
-                    free(animated->normalss[i]);
-                }
-                if (animated->bumpmap_overlays && animated->bumpmap_overlays[i]
-                    && animated->bumpmap_overlays[i] != current_overlay) {
-                    SDL_DestroyTexture(animated->bumpmap_overlays[i]);
-                }
+
+            /* The bump map data of the frame shown may have been computed since */
+            animated->bumpmaps[animated->frame] = obj->bumpmap;
+
+            for (int i = 0; i < animated->n_frames; i++) {
+                asset_cache_release_texture(animated->textures[i]);
+                asset_cache_release_surface(animated->surfaces[i]);
+                bumpmap_data_free(animated->bumpmaps[i]);
             }
 
-            if (current_overlay) {
-                SDL_DestroyTexture(current_overlay);
+            if (obj->bumpmap_overlay) {
+                SDL_DestroyTexture(obj->bumpmap_overlay);
             }
 
             free_and_set_null((void **) &animated->textures);
             free_and_set_null((void **) &animated->surfaces);
-            free_and_set_null((void **) &animated->colorss);
-            free_and_set_null((void **) &animated->normalss);
-            free_and_set_null((void **) &animated->bumpmap_overlays);
-            free_and_set_null((void **) &animated->bumpmap_texturess);
-            free_and_set_null((void **) &animated->light_pixelss);
+            free_and_set_null((void **) &animated->bumpmaps);
+            free_and_set_null((void **) &animated->delays);
+            free_and_set_null((void **) &animated->used);
             free_and_set_null((void **) &obj->rot_center);
             free_and_set_null((void **) &obj->dst_rect);
             free(obj);
             return;
         }
 
-        free_and_set_null((void **) &obj->colors);
-        free_and_set_null((void **) &obj->normals);
+        if (obj->atlas_entry) {
+            glyph_atlas_release(obj->atlas_entry);
+            obj->atlas_entry = NULL;
+        }
+
+        if (obj->shadow_entry) {
+            glyph_atlas_release(obj->shadow_entry);
+            obj->shadow_entry = NULL;
+        }
+
+        if (obj->shadow_texture) {
+            SDL_DestroyTexture(obj->shadow_texture);
+            obj->shadow_texture = NULL;
+        }
+
+        bumpmap_data_free(obj->bumpmap);
+        obj->bumpmap = NULL;
         free_and_set_null((void **) &obj->rot_center);
         free_and_set_null((void **) &obj->dst_rect);
 
         if (obj->surface) {
             log_debug(MENU_CTX,"SDL_FreeSurface(obj->surface => %p);\n", obj->surface);
-            SDL_FreeSurface(obj->surface);
+            asset_cache_release_surface(obj->surface);
             obj->surface = NULL;
         }
 
         if (obj->texture) {
-            SDL_DestroyTexture(obj->texture);
+            asset_cache_release_texture(obj->texture);
             obj->texture = NULL;
         }
 
@@ -103,15 +195,15 @@ void glyph_obj_free(glyph_obj *obj) {
             obj->bumpmap_overlay = NULL;
         }
 
-        if (obj->bump_map && obj->bumpmap_textures) {
-            for (int a = 0; a < N_ANGLES; a++) {
-                if (obj->bumpmap_textures[a]) {
-                    SDL_DestroyTexture(obj->bumpmap_textures[a]);
-                }
-            }
-            free_and_set_null((void **) &obj->bumpmap_textures);
+        if (obj->bumpmap_gradients) {
+            SDL_DestroyTexture(obj->bumpmap_gradients);
+            obj->bumpmap_gradients = NULL;
         }
 
+        glyph_obj_drop_bumpmap_cache(obj);
+        free_and_set_null((void **) &obj->bumpmap_textures);
+        free_and_set_null((void **) &obj->bumpmap_nodes);
+
         free (obj);
 
     }
@@ -119,6 +211,10 @@ void glyph_obj_free(glyph_obj *obj) {
 
 void glyph_obj_update_cnt_rad(glyph_obj *glyph_o, SDL_Point center, int radius) {
 
+    /* The light depends on the position */
+    glyph_obj_drop_bumpmap_cache(glyph_o);
+    glyph_o->lit_angle = -2000.0;
+
     glyph_o->dst_rect->x = center.x - 0.5 * glyph_o->dst_rect->w;
     glyph_o->dst_rect->y = center.y - radius - 0.5 * glyph_o->dst_rect->h;
     glyph_o->rot_center->x = 0.5 * glyph_o->dst_rect->w;
@@ -127,106 +223,76 @@ void glyph_obj_update_cnt_rad(glyph_obj *glyph_o, SDL_Point center, int radius)
 }
 
 void init_bumpmap_data(glyph_obj *glyph_o) {
-    glyph_o->normals = calloc(glyph_o->surface->w * glyph_o->surface->h, sizeof(normal_vector));
-    glyph_o->colors = calloc(glyph_o->surface->w * glyph_o->surface->h, sizeof(SDL_Color));
+    glyph_o->bumpmap = bumpmap_data_new_from_surface(glyph_o->surface);
+}
 
-    Uint32 *pixels = (Uint32 *) glyph_o->surface->pixels;
+/**
+ * The light term n.l is linear in the normal, so it can be split into the
+ * positive and negative parts of both normal components. Each part goes
+ * into the alpha of one quadrant of a white texture:
+ *   (0, 0) x+   (w, 0) x-
+ *   (0, h) y+   (w, h) y-
+ * Textures can't hold negative values, hence four masks instead of two.
+ **/
+static void glyph_obj_init_gradients(SDL_Renderer *renderer, glyph_atlas *atlas, glyph_obj *glyph_o) {
+    if (glyph_atlas_shade_unsupported(atlas)) {
+        return;
+    }
 
-    int bpp = glyph_o->surface->format->BytesPerPixel;
-    int pitch = glyph_o->surface->pitch / bpp;
+    int w = glyph_o->surface->w;
+    int h = glyph_o->surface->h;
 
-    for (int y = 0; y < glyph_o->surface->h; y++) {
-        int o = glyph_o->surface->w * y;
-        int p = pitch * y;
+    SDL_Surface *gradients = SDL_CreateRGBSurfaceWithFormat(0, 2 * w, 2 * h, 32, DEFAULT_SDL_PIXELFORMAT);
+    if (!gradients) {
+        log_error(MENU_CTX, "Could not create gradient surface: %s\n", SDL_GetError());
+        return;
+    }
 
-        for (int x = 0; x < glyph_o->surface->w; x++) {
-            SDL_Color color;
-            SDL_GetRGBA(pixels[p + x],
-                        glyph_o->surface->format,
-                        &(color.r),
-                        &(color.g),
-                        &(color.b),
-                        &(color.a));
+    Uint32 *pixels = (Uint32 *) gradients->pixels;
+    int pitch = gradients->pitch / (int) sizeof(Uint32);
 
-            glyph_o->colors[o + x] = color;
-        }
-    }
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            float nx = glyph_o->bumpmap->nx[w * y + x];
+            float ny = glyph_o->bumpmap->ny[w * y + x];
+            double a = glyph_o->bumpmap->a[w * y + x];
+            double v[4] = {nx > 0 ? nx : 0, nx < 0 ? -nx : 0, ny > 0 ? ny : 0, ny < 0 ? -ny : 0};
 
-    for (int y = 0; y < glyph_o->surface->h; y++) {
-        int o = glyph_o->surface->w * y;
-        int pop = glyph_o->surface->w * (y - 1);
-        int pon = glyph_o->surface->w * (y + 1);
-
-        for (int x = 0; x < glyph_o->surface->w; x++) {
-            SDL_Color color = glyph_o->colors[o + x];
-
-            double dx = 0.0;
-            double dy = 0.0;
-
-            if (color.a) {
-                Uint8 pax = x <= 0 ? 0 : glyph_o->colors[o + (x - 1)].a;
-                Uint8 pay = y <= 0 ? 0 : glyph_o->colors[pop + x].a;
-                Uint8 nax = x < glyph_o->surface->w - 1
-                                ? glyph_o->colors[o + (x + 1)].a
-                                : 0;
-                Uint8 nay = y < glyph_o->surface->h - 1
-                                ? glyph_o->colors[pon + x].a
-                                : 0;
-
-                dx = (nax - pax);
-                dy = (nay - pay);
-
-                if (dx || dy) {
-                    double inv_dn = Q_rsqrt(dx * dx + dy * dy);
-                    dx = dx * inv_dn;
-                    dy = dy * inv_dn;
-                } else {
-                    dx = 0.0;
-                    dy = 0.0;
-                }
+            for (int q = 0; q < 4; q++) {
+                int px = x + (q % 2) * w;
+                int py = y + (q / 2) * h;
+                pixels[pitch * py + px] = SDL_MapRGBA(gradients->format, 255, 255, 255, (Uint8) (v[q] * a));
             }
-
-            glyph_o->normals[o + x] = (normal_vector){dx, dy};
         }
     }
 
-    normal_vector df;
-    df.x = 0;
-    df.y = 0;
-    SDL_Color transparent;
-    transparent.r = 0;
-    transparent.g = 0;
-    transparent.b = 0;
-    transparent.a = 0;
-
-    glyph_o->normals[0] = df;
-    glyph_o->colors[0] = transparent;
-
-    for (int y = 1; y < glyph_o->surface->h; y++) {
-        int p = glyph_o->surface->w * y;
-        if (glyph_o->surface->w * glyph_o->surface->h - p <= 0)
-            log_error(MENU_CTX,
-                      "Pointer %d out of range %d\n",
-                      p,
-                      glyph_o->surface->w * glyph_o->surface->h);
+    glyph_o->bumpmap_gradients = SDL_CreateTextureFromSurface(renderer, gradients);
+    SDL_FreeSurface(gradients);
 
-        glyph_o->normals[p] = df;
-        glyph_o->normals[p - 1] = df;
-        glyph_o->colors[p] = transparent;
-        glyph_o->colors[p - 1] = transparent;
+    if (!glyph_o->bumpmap_gradients) {
+        log_error(MENU_CTX, "Could not create gradient texture: %s\n", SDL_GetError());
+        return;
     }
 
-    for (int x = 0; x < glyph_o->surface->w; x++) {
-        glyph_o->normals[x] = df;
-        glyph_o->normals[glyph_o->surface->w * (glyph_o->surface->h - 1) + x] = df;
-        glyph_o->colors[x] = transparent;
-        glyph_o->colors[glyph_o->surface->w * (glyph_o->surface->h - 1) + x] = transparent;
+    SDL_BlendMode shade = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_SRC_ALPHA,
+                                                     SDL_BLENDFACTOR_ONE,
+                                                     SDL_BLENDOPERATION_REV_SUBTRACT,
+                                                     SDL_BLENDFACTOR_ZERO,
+                                                     SDL_BLENDFACTOR_ONE,
+                                                     SDL_BLENDOPERATION_ADD);
+
+    if (SDL_SetTextureBlendMode(glyph_o->bumpmap_gradients, shade) != 0) {
+        log_warning(MENU_CTX, "Renderer does not support linear bump mapping (%s), using per pixel bump mapping\n", SDL_GetError());
+        glyph_atlas_set_shade_unsupported(atlas);
+        SDL_DestroyTexture(glyph_o->bumpmap_gradients);
+        glyph_o->bumpmap_gradients = NULL;
     }
 }
 
 void glyph_obj_init_surface(glyph_obj *glyph_o,
                             SDL_Renderer *renderer,
                             SDL_Surface *surface,
+                            bumpmap_data *bumpmap,
                             SDL_Point center,
                             int radius,
                             int bump_map) {
@@ -238,15 +304,15 @@ void glyph_obj_init_surface(glyph_obj *glyph_o,
     glyph_o->radius = radius;
 
     glyph_o->current_angle = -2000.0;
+    glyph_o->lit_angle = -2000.0;
 
-    glyph_o->colors = NULL;
-    glyph_o->normals = NULL;
+    glyph_o->bumpmap = bumpmap;
 
-    if (bump_map) {
+    if (bump_map && !bumpmap) {
         init_bumpmap_data(glyph_o);
     }
 
-    glyph_o->texture = SDL_CreateTextureFromSurface(renderer, glyph_o->surface);
+    glyph_o->texture = asset_cache_texture(renderer, glyph_o->surface);
     if (!glyph_o->texture) {
         log_error(MENU_CTX, "Could not generate texture from surface: %s\n", SDL_GetError());
     }
@@ -275,217 +341,591 @@ void glyph_obj_init_surface(glyph_obj *glyph_o,
     glyph_o->advance = 0;
 }
 
+/**
+ * Takes the surface and the bump map data (NULL to compute it here, if needed)
+ **/
 glyph_obj *glyph_obj_new_surface(
-    SDL_Renderer *renderer, SDL_Surface *surface, SDL_Point center, int radius, int bump_map) {
+    SDL_Renderer *renderer, SDL_Surface *surface, bumpmap_data *bumpmap, SDL_Point center, int radius, int bump_map) {
     glyph_obj *glyph_o = calloc(1, sizeof(glyph_obj));
     glyph_o->animated = 0;
 
-    glyph_obj_init_surface(glyph_o, renderer, surface, center, radius, bump_map);
+    glyph_obj_init_surface(glyph_o, renderer, surface, bumpmap, center, radius, bump_map);
 
     return glyph_o;
 }
 
+/**
+ * Takes the surfaces, delays are the times in ms each frame is shown.
+ * Only the first frame gets its texture here, the others when they are
+ * shown.
+ **/
 glyph_obj *glyph_obj_new_animated(SDL_Renderer *renderer,
                                   SDL_Surface **surfaces,
+                                  const int *delays,
                                   int n_surfaces,
                                   SDL_Point center,
                                   int radius,
                                   int bump_map) {
     glyph_obj_animated *glyph_o = calloc(1, sizeof(glyph_obj_animated));
     glyph_o->glyph_obj.animated = 1;
-    glyph_o->n_animations = n_surfaces;
-    glyph_o->next_animation = 0;
+    glyph_o->n_frames = n_surfaces;
     glyph_o->surfaces = calloc(n_surfaces, sizeof(SDL_Surface *));
     glyph_o->textures = calloc(n_surfaces, sizeof(SDL_Texture *));
-    glyph_o->normalss = calloc(n_surfaces, sizeof(normal_vector *));
-    glyph_o->colorss = calloc(n_surfaces, sizeof(SDL_Color *));
-    glyph_o->bumpmap_overlays = calloc(n_surfaces, sizeof(SDL_Texture *));
+    glyph_o->bumpmaps = calloc(n_surfaces, sizeof(bumpmap_data *));
+    glyph_o->delays = calloc(n_surfaces, sizeof(int));
+    glyph_o->used = calloc(n_surfaces, sizeof(Uint32));
 
     for (int i = 0; i < n_surfaces; i++) {
-        glyph_obj_init_surface((glyph_obj *) glyph_o,
-                               renderer,
-                               surfaces[i],
-                               center,
-                               radius,
-                               bump_map);
-        glyph_o->surfaces[i] = glyph_o->glyph_obj.surface;
-        glyph_o->textures[i] = glyph_o->glyph_obj.texture;
-        glyph_o->normalss[i] = glyph_o->glyph_obj.normals;
-        glyph_o->colorss[i] = glyph_o->glyph_obj.colors;
+        glyph_o->surfaces[i] = surfaces[i];
+        glyph_o->delays[i] = delays && delays[i] >= GLYPH_ANIMATION_MIN_DELAY_MS
+                             ? delays[i] : GLYPH_ANIMATION_DEFAULT_DELAY_MS;
+        glyph_o->duration += glyph_o->delays[i];
     }
 
+    glyph_obj_init_surface((glyph_obj *) glyph_o, renderer, surfaces[0], NULL, center, radius, bump_map);
+    glyph_o->textures[0] = glyph_o->glyph_obj.texture;
+    glyph_o->bumpmaps[0] = glyph_o->glyph_obj.bumpmap;
+    glyph_o->n_textures = glyph_o->textures[0] ? 1 : 0;
+
     return (glyph_obj *) glyph_o;
 }
 
 glyph_obj *glyph_obj_new(SDL_Renderer *renderer,
+                         glyph_atlas *atlas,
                          uint16_t c,
                          TTF_Font *font,
                          SDL_Color fg,
                          SDL_Point center,
                          int radius,
                          int bump_map) {
+
+    /*
+     * Bump mapped glyphs need their own pixels, all others
+     * are taken from the shared atlas
+     */
+    if (atlas && !bump_map) {
+        glyph_atlas_entry *entry = glyph_atlas_get(atlas, font, c);
+        if (entry) {
+            glyph_obj *glyph_o = calloc(1, sizeof(glyph_obj));
+            glyph_o->atlas_entry = entry;
+            glyph_o->tinted = 1;
+            glyph_o->radius = radius;
+            glyph_o->current_angle = -2000.0;
+            glyph_o->dst_rect = malloc(sizeof(SDL_Rect));
+            glyph_o->dst_rect->w = entry->rect.w;
+            glyph_o->dst_rect->h = entry->rect.h;
+            glyph_o->rot_center = malloc(sizeof(SDL_Point));
+            glyph_obj_update_cnt_rad(glyph_o, center, radius);
+            glyph_o->minx = entry->minx;
+            glyph_o->maxx = entry->maxx;
+            glyph_o->miny = entry->miny;
+            glyph_o->maxy = entry->maxy;
+            glyph_o->advance = entry->advance;
+            return glyph_o;
+        }
+        log_warning(MENU_CTX, "Glyph %c not available from atlas, rendering it separately\n", c);
+    }
+
+    glyph_metrics metrics = {0, 0, 0, 0, 0};
+    my_LockTTF();
     SDL_Surface *surface = TTF_RenderGlyph_Blended(font, c, fg);
     if (surface == NULL) {
         log_error(MENU_CTX, "Could not render glyph %c: %s\n", c, TTF_GetError());
+        my_UnlockTTF();
         return NULL;
     }
+    TTF_GlyphMetrics(font, c, &metrics.minx, &metrics.maxx, &metrics.miny, &metrics.maxy, &metrics.advance);
+    my_UnlockTTF();
 
-    glyph_obj *glyph_o = glyph_obj_new_surface(renderer, surface, center, radius, bump_map);
+    return glyph_obj_new_rendered(renderer, atlas, c, font, surface, NULL, &metrics, center, radius, bump_map);
+}
 
-    int minx = 0,maxx = 0,miny = 0,maxy = 0,advance = 0;
-    TTF_GlyphMetrics(font,c,&minx,&maxx,&miny,&maxy,&advance);
-    glyph_o->minx = minx;
-    glyph_o->maxx = maxx;
-    glyph_o->miny = miny;
-    glyph_o->maxy = maxy;
-    glyph_o->advance = advance;
+/**
+ * Creates the glyph from pixels rendered ahead (on a raster worker).
+ * Takes surface and bumpmap. Without a surface the glyph is taken from
+ * the atlas or rendered here.
+ **/
+glyph_obj *glyph_obj_new_rendered(SDL_Renderer *renderer,
+                                  glyph_atlas *atlas,
+                                  uint16_t c,
+                                  TTF_Font *font,
+                                  SDL_Surface *surface,
+                                  bumpmap_data *bumpmap,
+                                  const glyph_metrics *metrics,
+                                  SDL_Point center,
+                                  int radius,
+                                  int bump_map) {
+    if (!surface) {
+        SDL_Color white = {255, 255, 255, 255};
+        bumpmap_data_free(bumpmap);
+        return glyph_obj_new(renderer, atlas, c, font, white, center, radius, bump_map);
+    }
+
+    glyph_obj *glyph_o = glyph_obj_new_surface(renderer, surface, bumpmap, center, radius, bump_map);
+    glyph_o->tinted = 1;
+
+    if (bump_map == BUMP_MAP_LINEAR) {
+        glyph_obj_init_gradients(renderer, atlas, glyph_o);
+    }
+
+    glyph_o->minx = metrics->minx;
+    glyph_o->maxx = metrics->maxx;
+    glyph_o->miny = metrics->miny;
+    glyph_o->maxy = metrics->maxy;
+    glyph_o->advance = metrics->advance;
 
     return glyph_o;
 }
 
-void glyph_obj_update_bumpmap_texture(SDL_Renderer *renderer, glyph_obj *glyph_o, double center_x, double center_y, int angle, double l_x, double l_y) {
+/**
+ * Updates the direction of the drop shadow (away from the light source)
+ **/
+void glyph_obj_update_light_direction(glyph_obj *glyph_o, double center_x, double center_y, int angle, double l_x, double l_y) {
+    double s, c;
+
+    get_sinus_and_cosinus(angle, &c, &s);
+
+    double x = glyph_o->dst_rect->x+0.5*glyph_o->dst_rect->w-center_x;
+    double y = glyph_o->dst_rect->y+0.5*glyph_o->dst_rect->h-center_y;
+    double c_x_rot = c * x - s * y + center_x;
+    double c_y_rot = s * x + c * y + center_y;
 
-    Uint32 *bumpmap_pixels;
+    double light_x = c_x_rot - l_x;
+    double light_y = c_y_rot - l_y;
+    double light_d = (double) Q_rsqrt((float)(light_x*light_x + light_y*light_y));
+
+    glyph_o->shadow_dx = light_d * light_x;
+    glyph_o->shadow_dy = light_d * light_y;
+}
+
+/**
+ * Usually, the distance to the light source should be taken for each pixel (to be adjusted)
+ * in the glyph. For performance, only take the distance from the top left pixel
+ */
+static void glyph_obj_light_vector(glyph_obj *glyph_o, double center_x, double center_y, double c, double s,
+                                   double l_x, double l_y, double *light_x, double *light_y) {
+    double x_rot = c * (glyph_o->dst_rect->x-center_x) - s * (glyph_o->dst_rect->y - center_y) + center_x;
+    double y_rot = s * (glyph_o->dst_rect->x-center_x) + c * (glyph_o->dst_rect->y - center_y) + center_y;
+
+    double lx = x_rot - l_x;
+    double ly = y_rot - l_y;
+
+    double inv_light_d = Q_rsqrt((float)(lx*lx + ly*ly));
+
+    *light_x = inv_light_d * lx;
+    *light_y = inv_light_d * ly;
+}
+
+/**
+ * Writes the lit glyph into the given streaming texture. Tinted glyphs
+ * take their color from the given color, icons from their own pixels.
+ **/
+static int glyph_obj_light_texture(glyph_obj *glyph_o, SDL_Texture *texture, double center_x, double center_y, int angle, double l_x, double l_y, SDL_Color color) {
+
+    Uint8 *bumpmap_pixels;
     int pitch;
+    Uint64 start = frame_profiler_now();
+
+    if (SDL_LockTexture(texture, NULL, (void **) &bumpmap_pixels, &pitch) != 0) {
+        log_error(MENU_CTX, "Could not lock bumpmap texture: %s\n", SDL_GetError());
+        return 0;
+    }
+
+    double s, c;
+
+    get_sinus_and_cosinus(angle, &c, &s);
+
+    double light_x, light_y;
+    glyph_obj_light_vector(glyph_o, center_x, center_y, c, s, l_x, l_y, &light_x, &light_y);
+
+    /* Rotate the light into glyph space instead of rotating every normal */
+    float wx = light_x * c + light_y * s;
+    float wy = light_y * c - light_x * s;
+
+    bumpmap_relight(glyph_o->bumpmap, wx, wy, glyph_o->tinted ? &color : NULL, bumpmap_pixels, pitch);
+
+    SDL_UnlockTexture(texture);
+    frame_profiler_add(FRAME_PHASE_BUMPMAP, start);
+
+    return 1;
+
+}
+
+static SDL_Texture *glyph_obj_new_bumpmap_texture(SDL_Renderer *renderer, glyph_obj *glyph_o) {
+    SDL_Texture *texture = SDL_CreateTexture(renderer, DEFAULT_SDL_PIXELFORMAT, SDL_TEXTUREACCESS_STREAMING, glyph_o->surface->w, glyph_o->surface->h);
+    if (!texture) {
+        log_error(MENU_CTX, "Could not create bumpmap texture: %s\n", SDL_GetError());
+        return NULL;
+    }
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    return texture;
+}
+
+/**
+ * Relights the bumpmap overlay.
+ **/
+void glyph_obj_update_bumpmap_texture(SDL_Renderer *renderer, glyph_obj *glyph_o, double center_x, double center_y, int angle, double l_x, double l_y, SDL_Color color) {
 
     if (!glyph_o || !glyph_o->surface) {
         return;
     }
 
-    if (!glyph_o->colors || !glyph_o->normals) {
+    if (!glyph_o->bumpmap) {
         init_bumpmap_data(glyph_o);
-        if (!glyph_o->colors || !glyph_o->normals) {
+        if (!glyph_o->bumpmap) {
             return;
         }
     }
 
     if (!glyph_o->bumpmap_overlay) {
-        glyph_o->bumpmap_overlay = SDL_CreateTexture(renderer, DEFAULT_SDL_PIXELFORMAT, SDL_TEXTUREACCESS_STREAMING, glyph_o->surface->w, glyph_o->surface->h);
+        glyph_o->bumpmap_overlay = glyph_obj_new_bumpmap_texture(renderer, glyph_o);
         if (!glyph_o->bumpmap_overlay) {
-            log_error(MENU_CTX, "Could not create bumpmap texture: %s\n", SDL_GetError());
             return;
         }
-        SDL_SetTextureBlendMode(glyph_o->bumpmap_overlay, SDL_BLENDMODE_BLEND);
     }
 
-    if (SDL_LockTexture(glyph_o->bumpmap_overlay, NULL, (void **) &bumpmap_pixels, &pitch) != 0) {
-        log_error(MENU_CTX, "Could not lock bumpmap texture: %s\n", SDL_GetError());
-        return;
+    glyph_obj_update_light_direction(glyph_o, center_x, center_y, angle, l_x, l_y);
+
+    if (glyph_obj_light_texture(glyph_o, glyph_o->bumpmap_overlay, center_x, center_y, angle, l_x, l_y, color)) {
+        glyph_o->color = color;
+        glyph_o->lit_angle = angle;
     }
+}
 
-    double s, c;
+static int glyph_obj_same_color(SDL_Color c1, SDL_Color c2) {
+    return c1.r == c2.r && c1.g == c2.g && c1.b == c2.b;
+}
 
-    get_sinus_and_cosinus(angle, &c, &s);
+/**
+ * Returns the lit texture for the given angle. Lit textures are cached at
+ * quantized angles, so turning back and forth only costs lookups. Animated
+ * glyphs and glyphs too large for the budget use the overlay, which is
+ * relit when the angle or color changed.
+ **/
+SDL_Texture *glyph_obj_get_bumpmap_texture(SDL_Renderer *renderer, glyph_obj *glyph_o, double center_x, double center_y, double angle, double l_x, double l_y, SDL_Color color) {
+    if (!glyph_o || !glyph_o->surface) {
+        return NULL;
+    }
 
-    SDL_PixelFormat *format = glyph_o->surface->format;
-    Uint32 transparent = 0;
+    size_t bytes = (size_t) glyph_o->surface->w * glyph_o->surface->h * sizeof(Uint32);
 
-    /*
-     * Update shadow offset direction
-     */
-    double x = glyph_o->dst_rect->x+0.5*glyph_o->dst_rect->w-center_x;
-    double y = glyph_o->dst_rect->y+0.5*glyph_o->dst_rect->h-center_y;
-    double c_x_rot = c * x - s * y + center_x;
-    double c_y_rot = s * x + c * y + center_y;
+    if (glyph_o->animated || bytes > bumpmap_cache.budget) {
+        if (angle != glyph_o->lit_angle || !glyph_obj_same_color(color, glyph_o->color)) {
+            glyph_obj_update_bumpmap_texture(renderer, glyph_o, center_x, center_y, angle, l_x, l_y, color);
+            glyph_o->lit_angle = angle;
+        }
+        return glyph_o->bumpmap_overlay;
+    }
 
-    double light_x = c_x_rot - l_x;
-    double light_y = c_y_rot - l_y;
-    double light_d = (double) Q_rsqrt((float)(light_x*light_x + light_y*light_y));
+    glyph_obj_update_light_direction(glyph_o, center_x, center_y, angle, l_x, l_y);
 
-    glyph_o->shadow_dx = light_d * light_x;
-    glyph_o->shadow_dy = light_d * light_y;
+    if (!glyph_obj_same_color(color, glyph_o->color)) {
+        glyph_obj_drop_bumpmap_cache(glyph_o);
+        glyph_o->color = color;
+    }
 
-    /**
-     * See below. Usually, the distance to the light source should be taken for each pixel (to be adjusted)
-     * in the glyph. For performance, only take the distance from the top left pixel
-     */
-    double x_rot = c * (glyph_o->dst_rect->x-center_x) - s * (glyph_o->dst_rect->y - center_y) + center_x;
-    double y_rot = s * (glyph_o->dst_rect->x-center_x) + c * (glyph_o->dst_rect->y - center_y) + center_y;
+    if (glyph_o->n_bumpmap_textures != bumpmap_cache.n_slots) {
+        glyph_obj_drop_bumpmap_cache(glyph_o);
+        free_and_set_null((void **) &glyph_o->bumpmap_textures);
+        free_and_set_null((void **) &glyph_o->bumpmap_nodes);
+        glyph_o->bumpmap_textures = calloc(bumpmap_cache.n_slots, sizeof(SDL_Texture *));
+        glyph_o->bumpmap_nodes = calloc(bumpmap_cache.n_slots, sizeof(bumpmap_cache_node *));
+        glyph_o->n_bumpmap_textures = bumpmap_cache.n_slots;
+    }
 
-    light_x = x_rot - l_x;
-    light_y = y_rot - l_y;
+    int q = (int) lround(angle / bumpmap_cache.angle_step);
+    int slot = ((q % bumpmap_cache.n_slots) + bumpmap_cache.n_slots) % bumpmap_cache.n_slots;
 
-    double inv_light_d = Q_rsqrt((float)(light_x*light_x + light_y*light_y));
+    bumpmap_cache_node *node = glyph_o->bumpmap_nodes[slot];
+    if (node) {
+        bumpmap_cache_unlink(node);
+        bumpmap_cache_push(node);
+        return glyph_o->bumpmap_textures[slot];
+    }
 
-    light_x = inv_light_d * light_x;
-    light_y = inv_light_d * light_y;
+    if (!glyph_o->bumpmap) {
+        init_bumpmap_data(glyph_o);
+        if (!glyph_o->bumpmap) {
+            return NULL;
+        }
+    }
 
-    /**
-     * <<
-     */
+    while (bumpmap_cache.tail && bumpmap_cache.bytes + bytes > bumpmap_cache.budget) {
+        bumpmap_cache_evict(bumpmap_cache.tail);
+    }
 
-    int bumpmap_pitch_px = pitch / (int)sizeof(Uint32);
+    SDL_Texture *texture = glyph_obj_new_bumpmap_texture(renderer, glyph_o);
+    if (!texture) {
+        return NULL;
+    }
+
+    if (!glyph_obj_light_texture(glyph_o, texture, center_x, center_y, q * bumpmap_cache.angle_step, l_x, l_y, color)) {
+        SDL_DestroyTexture(texture);
+        return NULL;
+    }
 
-    for (int y = 0; y < glyph_o->surface->h; y++) {
+    node = calloc(1, sizeof(bumpmap_cache_node));
+    node->glyph = glyph_o;
+    node->slot = slot;
+    node->bytes = bytes;
+    bumpmap_cache_push(node);
+    bumpmap_cache.bytes += bytes;
 
-        int src_o = glyph_o->surface->w * y;
-        int dst_o = bumpmap_pitch_px * y;
+    glyph_o->bumpmap_textures[slot] = texture;
+    glyph_o->bumpmap_nodes[slot] = node;
 
-        for (int x = 0; x < glyph_o->surface->w; x++) {
+    return texture;
+}
 
-            SDL_Color color = glyph_o->colors[src_o + x];
+/**
+ * Draws the glyph and adds the light with the gradient masks:
+ * n.l = n.x * (l.x c + l.y s) + n.y * (l.y c - l.x s).
+ * Positive terms add (255 - color) * weight like the highlight of the
+ * per pixel path, negative terms subtract color * weight like its shading.
+ **/
+void glyph_obj_draw_linear_bumpmap(SDL_Renderer *renderer, glyph_obj *glyph_o, double center_x, double center_y, double angle, double l_x, double l_y, SDL_Color color) {
+    double s, c;
+    double light_x, light_y;
 
-            if (color.a > 1) {
+    get_sinus_and_cosinus((int) angle, &c, &s);
+    glyph_obj_light_vector(glyph_o, center_x, center_y, c, s, l_x, l_y, &light_x, &light_y);
 
-                Uint8 r = color.r,g = color.g,b = color.b,a = color.a;
-                normal_vector df = glyph_o->normals[src_o + x];
+    double wx = light_x * c + light_y * s;
+    double wy = light_y * c - light_x * s;
+    double weights[4] = {wx, -wx, wy, -wy};
 
-                if (df.x || df.y) {
-                    // angle to light
-                    double dx_rot = c * df.x - s * df.y;
-                    double dy_rot = s * df.x + c * df.y;
+    SDL_SetTextureColorMod(glyph_o->texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(glyph_o->texture, color.a);
+    SDL_RenderCopyEx(renderer, glyph_o->texture, NULL, glyph_o->dst_rect, angle,
+                     glyph_o->rot_center, SDL_FLIP_NONE);
 
-                    double light = light_x * dx_rot + light_y * dy_rot;
+    SDL_BlendMode shade;
+    SDL_GetTextureBlendMode(glyph_o->bumpmap_gradients, &shade);
 
-                    if (light >= 0.0) {
-                        r = r + (255.0 - r) * light;
-                        g = g + (255.0 - g) * light;
-                        b = b + (255.0 - b) * light;
-                    } else {
-                        r = r * (1.0+light);
-                        g = g * (1.0+light);
-                        b = b * (1.0+light);
-                    }
-                }
+    int w = glyph_o->surface->w;
+    int h = glyph_o->surface->h;
 
-                /**
-                 * Have to switch B and R, i don't know why
-                 */
-                Uint32 lght = (b << format->Rshift) | (g << format->Gshift) | (r << format->Bshift) | (a << format->Ashift & format->Amask);
-                bumpmap_pixels[dst_o + x] = lght;
+    /* Highlights first, then shades */
+    for (int pass = 0; pass < 2; pass++) {
+        SDL_SetTextureBlendMode(glyph_o->bumpmap_gradients, pass == 0 ? SDL_BLENDMODE_ADD : shade);
+        for (int q = 0; q < 4; q++) {
+            double weight = pass == 0 ? weights[q] : -weights[q];
+            if (weight <= 1.0 / 255.0) {
+                continue;
+            }
 
+            SDL_Rect src = {(q % 2) * w, (q / 2) * h, w, h};
+            if (pass == 0) {
+                SDL_SetTextureColorMod(glyph_o->bumpmap_gradients,
+                                       (255 - color.r) * weight,
+                                       (255 - color.g) * weight,
+                                       (255 - color.b) * weight);
             } else {
-                bumpmap_pixels[dst_o + x] = transparent;
+                SDL_SetTextureColorMod(glyph_o->bumpmap_gradients,
+                                       color.r * weight,
+                                       color.g * weight,
+                                       color.b * weight);
             }
+            SDL_RenderCopyEx(renderer, glyph_o->bumpmap_gradients, &src, glyph_o->dst_rect, angle,
+                             glyph_o->rot_center, SDL_FLIP_NONE);
         }
+    }
 
+    SDL_SetTextureBlendMode(glyph_o->bumpmap_gradients, shade);
+}
+
+static int glyph_obj_update_shadow(SDL_Renderer *renderer, glyph_atlas *atlas, glyph_obj *glyph_o, int blur) {
+    if (glyph_o->shadow_blur == blur && (glyph_o->shadow_entry || glyph_o->shadow_texture)) {
+        return 1;
+    }
+
+    if (glyph_o->shadow_entry) {
+        glyph_atlas_release(glyph_o->shadow_entry);
+        glyph_o->shadow_entry = NULL;
+    }
+
+    if (glyph_o->shadow_texture) {
+        SDL_DestroyTexture(glyph_o->shadow_texture);
+        glyph_o->shadow_texture = NULL;
+    }
+
+    glyph_o->shadow_blur = blur;
+
+    if (glyph_o->atlas_entry) {
+        glyph_o->shadow_entry = glyph_atlas_get_shadow(atlas, glyph_o->atlas_entry->font, glyph_o->atlas_entry->c, blur);
+        return glyph_o->shadow_entry != NULL;
+    }
+
+    if (!glyph_o->surface) {
+        return 0;
+    }
+
+    SDL_Surface *shadow = new_shadow_surface(glyph_o->surface, blur);
+    if (!shadow) {
+        return 0;
+    }
+
+    glyph_o->shadow_texture = SDL_CreateTextureFromSurface(renderer, shadow);
+    SDL_FreeSurface(shadow);
+
+    if (!glyph_o->shadow_texture) {
+        log_error(MENU_CTX, "Could not create shadow texture: %s\n", SDL_GetError());
+        return 0;
     }
 
-    SDL_UnlockTexture(glyph_o->bumpmap_overlay);
+    SDL_SetTextureBlendMode(glyph_o->shadow_texture, SDL_BLENDMODE_BLEND);
+    SDL_SetTextureColorMod(glyph_o->shadow_texture, 0, 0, 0);
 
+    return 1;
 }
 
-void glyph_obj_animation_update(glyph_obj *glyph_o) {
+/**
+ * Draws the drop shadow with one blit of a blurred copy of the glyph.
+ * It stands in for shadow_offset copies at increasing distance along the
+ * light direction (shadow_dx, shadow_dy), which get more transparent the
+ * farther they are away: the blur covers the spread, the distance is the
+ * weighted mean of the offsets and the alpha is the combined coverage of
+ * all copies. Returns 0, if the glyph has no shadow (animated glyphs).
+ **/
+int glyph_obj_draw_shadow(SDL_Renderer *renderer,
+                          glyph_atlas *atlas,
+                          glyph_obj *glyph_o,
+                          double angle,
+                          int shadow_offset,
+                          int shadow_alpha) {
+    int blur = (shadow_offset + 1) / 2;
+    double distance = (shadow_offset + 2) / 3.0;
+    double transparency = 1.0;
+
+    if (glyph_o->animated || !glyph_obj_update_shadow(renderer, atlas, glyph_o, blur)) {
+        return 0;
+    }
+
+    for (int so = 1; so <= shadow_offset; so++) {
+        transparency *= 1.0 - (double) so * shadow_alpha / (255.0 * shadow_offset);
+    }
+
+    SDL_Color shadow_color = {0, 0, 0, to_Uint8(255.0 * (1.0 - transparency))};
+    SDL_Rect dst = {glyph_o->dst_rect->x - blur + to_int(distance * glyph_o->shadow_dx),
+                    glyph_o->dst_rect->y - blur + to_int(distance * glyph_o->shadow_dy),
+                    glyph_o->dst_rect->w + 2 * blur,
+                    glyph_o->dst_rect->h + 2 * blur};
+    SDL_Point rot_center = {glyph_o->rot_center->x + blur, glyph_o->rot_center->y + blur};
+
+    if (glyph_o->shadow_entry) {
+        glyph_atlas_draw(atlas, glyph_o->shadow_entry, &dst, angle, &rot_center, shadow_color);
+    } else {
+        glyph_atlas_flush(atlas);
+        SDL_SetTextureAlphaMod(glyph_o->shadow_texture, shadow_color.a);
+        SDL_RenderCopyEx(renderer, glyph_o->shadow_texture, NULL, &dst, angle, &rot_center, SDL_FLIP_NONE);
+    }
+
+    return 1;
+}
+
+/**
+ * Drops the texture and bump map data of the frame shown longest ago
+ **/
+static void glyph_obj_animation_evict(glyph_obj_animated *glyph_o_a, int keep) {
+    int oldest = -1;
+
+    for (int f = 0; f < glyph_o_a->n_frames; f++) {
+        if (glyph_o_a->textures[f] && f != glyph_o_a->frame && f != keep
+            && (oldest < 0 || SDL_TICKS_PASSED(glyph_o_a->used[oldest], glyph_o_a->used[f]))) {
+            oldest = f;
+        }
+    }
+
+    if (oldest >= 0) {
+        asset_cache_release_texture(glyph_o_a->textures[oldest]);
+        glyph_o_a->textures[oldest] = NULL;
+        bumpmap_data_free(glyph_o_a->bumpmaps[oldest]);
+        glyph_o_a->bumpmaps[oldest] = NULL;
+        glyph_o_a->n_textures--;
+    }
+}
+
+static void glyph_obj_animation_show(SDL_Renderer *renderer, glyph_obj_animated *glyph_o_a, int frame, Uint32 now) {
+    glyph_obj *glyph_o = &glyph_o_a->glyph_obj;
+
+    if (!glyph_o_a->textures[frame]) {
+        while (glyph_o_a->n_textures >= GLYPH_ANIMATION_MAX_TEXTURES) {
+            int n_textures = glyph_o_a->n_textures;
+            glyph_obj_animation_evict(glyph_o_a, frame);
+            if (glyph_o_a->n_textures == n_textures) {
+                break;
+            }
+        }
+
+        SDL_Texture *texture = asset_cache_texture(renderer, glyph_o_a->surfaces[frame]);
+        if (!texture) {
+            log_error(MENU_CTX, "Could not generate texture for frame %d: %s\n", frame, SDL_GetError());
+            return;
+        }
+        SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+        glyph_o_a->textures[frame] = texture;
+        glyph_o_a->n_textures++;
+    }
+
+    /* The bump map data is computed when the frame is lit first */
+    glyph_o_a->bumpmaps[glyph_o_a->frame] = glyph_o->bumpmap;
+
+    glyph_o_a->frame = frame;
+    glyph_o_a->used[frame] = now;
+    glyph_o->surface = glyph_o_a->surfaces[frame];
+    glyph_o->texture = glyph_o_a->textures[frame];
+    glyph_o->bumpmap = glyph_o_a->bumpmaps[frame];
+    glyph_o->lit_angle = -2000.0;
+}
+
+/**
+ * Shows the frame due at now. Frames are skipped, if the glyph hasn't been
+ * drawn for longer than their delay.
+ **/
+void glyph_obj_animation_update(SDL_Renderer *renderer, glyph_obj *glyph_o, Uint32 now) {
     if (!glyph_o->animated) {
         return;
     }
 
     glyph_obj_animated *glyph_o_a = (glyph_obj_animated *) glyph_o;
-    int next_animation = glyph_o_a->next_animation;
-    glyph_o_a->glyph_obj.colors = glyph_o_a->colorss[next_animation];
-    glyph_o_a->glyph_obj.normals = glyph_o_a->normalss[next_animation];
-    glyph_o_a->glyph_obj.surface = glyph_o_a->surfaces[next_animation];
-    glyph_o_a->glyph_obj.texture = glyph_o_a->textures[next_animation];
 
-    if (glyph_o_a->glyph_obj.bumpmap_overlay && next_animation > 0) {
-        glyph_o_a->bumpmap_overlays[next_animation - 1] = glyph_o_a->glyph_obj.bumpmap_overlay;
+    if (glyph_o_a->frame_ticks == 0) {
+        glyph_o_a->frame_ticks = now;
+    }
+
+    Uint32 passed = now - glyph_o_a->frame_ticks;
+    int frame = glyph_o_a->frame;
+
+    if (passed >= glyph_o_a->duration) {
+        glyph_o_a->frame_ticks += passed - passed % glyph_o_a->duration;
+        passed %= glyph_o_a->duration;
     }
 
-    glyph_o_a->glyph_obj.bumpmap_overlay = glyph_o_a->bumpmap_overlays[next_animation];
+    while (passed >= (Uint32) glyph_o_a->delays[frame]) {
+        passed -= glyph_o_a->delays[frame];
+        glyph_o_a->frame_ticks += glyph_o_a->delays[frame];
+        frame = (frame + 1) % glyph_o_a->n_frames;
+    }
 
-    if (++next_animation >= glyph_o_a->n_animations) {
-        next_animation = 0;
+    if (frame != glyph_o_a->frame) {
+        glyph_obj_animation_show(renderer, glyph_o_a, frame, now);
     }
 
-    glyph_o_a->next_animation = next_animation;
+    Uint32 due = glyph_o_a->frame_ticks + glyph_o_a->delays[frame];
+    if (due == 0) {
+        due = 1;
+    }
+    if (animation_due == 0 || SDL_TICKS_PASSED(animation_due, due)) {
+        animation_due = due;
+    }
+}
+
+/**
+ * When the next frame of an animated glyph drawn since the last call is
+ * due, 0 if none has been drawn
+ **/
+Uint32 glyph_obj_take_animation_due(void) {
+    Uint32 due = animation_due;
+    animation_due = 0;
+    return due;
 }
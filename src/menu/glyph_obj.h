@@ -22,17 +22,36 @@
 
 #include<SDL2/SDL.h>
 #include<SDL2/SDL_ttf.h>
+#include "glyph_atlas.h"
+#include "bumpmap_kernel.h"
 
-typedef struct normal_vector normal_vector;
+/**
+ * Bump map modes (theme font_bumpmap)
+ **/
+#define BUMP_MAP_OFF 0
+#define BUMP_MAP_PER_PIXEL 1 /* Relight every pixel when the glyph moves */
+#define BUMP_MAP_LINEAR 2 /* Blend precomputed gradient masks, no per pixel work */
+
+typedef struct bumpmap_cache_node bumpmap_cache_node;
+
+typedef struct glyph_metrics {
+    int minx;
+    int maxx;
+    int miny;
+    int maxy;
+    int advance;
+} glyph_metrics;
 
 typedef struct glyph_obj {
     SDL_Texture *texture;
     SDL_Surface *surface;
     SDL_Texture *bumpmap_overlay;
-    SDL_Texture **bumpmap_textures;
+    SDL_Texture **bumpmap_textures; /* Lit textures at quantized angles */
+    bumpmap_cache_node **bumpmap_nodes;
+    int n_bumpmap_textures;
+    SDL_Texture *bumpmap_gradients; /* x+, x-, y+ and y- gradient masks for linear bump mapping */
     Uint32 *light_pixels;
-    SDL_Color *colors;
-    normal_vector *normals;
+    bumpmap_data *bumpmap; /* Colors and normals for per pixel bump mapping */
     int pitch;
     int advance;
     int minx;
@@ -43,50 +62,85 @@ typedef struct glyph_obj {
     SDL_Point *rot_center;
     double radius;
     double current_angle;
+    double lit_angle; /* The angle the bumpmap overlay has been lit for */
     double shadow_dx;
     double shadow_dy;
     int bump_map;
     int animated;
+    glyph_atlas_entry *atlas_entry; /* Set, if the glyph is drawn from the shared atlas */
+    glyph_atlas_entry *shadow_entry; /* The blurred shadow of atlas glyphs */
+    SDL_Texture *shadow_texture; /* The blurred shadow of all other glyphs */
+    int shadow_blur; /* The blur of shadow_entry or shadow_texture */
+    int tinted; /* Text glyphs are white masks which get their color when drawn */
+    SDL_Color color; /* The color the bumpmap overlay has been lit with */
 } glyph_obj;
 
+/**
+ * An animated icon. All frames are kept as surfaces, textures and bump
+ * map data only for the frames shown last, see GLYPH_ANIMATION_MAX_TEXTURES.
+ **/
 typedef struct glyph_obj_animated {
     glyph_obj glyph_obj;
-    int n_animations;
-    int next_animation;
-    SDL_Texture **textures;
+    int n_frames;
+    int frame; /* The frame shown */
+    Uint32 frame_ticks; /* When the frame was shown, 0 before the first draw */
+    Uint32 duration; /* Of all frames */
+    int *delays; /* How long each frame is shown (ms) */
     SDL_Surface **surfaces;
-    SDL_Texture **bumpmap_overlays;
-    SDL_Texture ***bumpmap_texturess;
-    Uint32 **light_pixelss;
-    SDL_Color **colorss;
-    normal_vector **normalss;
+    SDL_Texture **textures;
+    bumpmap_data **bumpmaps;
+    Uint32 *used; /* When each frame was shown last */
+    int n_textures;
 } glyph_obj_animated;
 
 glyph_obj *glyph_obj_new(SDL_Renderer *renderer,
+                         glyph_atlas *atlas,
                          uint16_t c,
                          TTF_Font *font,
                          SDL_Color fg,
                          SDL_Point center,
                          int radius,
                          int bump_map);
+glyph_obj *glyph_obj_new_rendered(SDL_Renderer *renderer,
+                                  glyph_atlas *atlas,
+                                  uint16_t c,
+                                  TTF_Font *font,
+                                  SDL_Surface *surface,
+                                  bumpmap_data *bumpmap,
+                                  const glyph_metrics *metrics,
+                                  SDL_Point center,
+                                  int radius,
+                                  int bump_map);
 glyph_obj *glyph_obj_new_surface(SDL_Renderer *renderer,
                                  SDL_Surface *surface,
+                                 bumpmap_data *bumpmap,
                                  SDL_Point center,
                                  int radius,
                                  int bump_map);
 
 glyph_obj *glyph_obj_new_animated(SDL_Renderer *renderer,
                                   SDL_Surface **surfaces,
+                                  const int *delays,
                                   int n_surfaces,
                                   SDL_Point center,
                                   int radius,
                                   int bump_map);
 
-void glyph_obj_animation_update(glyph_obj *glyph_obj);
+void glyph_obj_animation_update(SDL_Renderer *renderer, glyph_obj *glyph_o, Uint32 now);
+Uint32 glyph_obj_take_animation_due(void);
 
 void glyph_obj_free(glyph_obj *obj);
 void glyph_obj_update_cnt_rad(glyph_obj *glyph_o, SDL_Point center, int radius);
-void glyph_obj_update_bumpmap_texture(SDL_Renderer *renderer, glyph_obj *glyph_o, double center_x, double center_y, int angle, double l_x, double l_y);
-void glyph_obj_animation_update(glyph_obj *glyph_o);
+void glyph_obj_update_light_direction(glyph_obj *glyph_o, double center_x, double center_y, int angle, double l_x, double l_y);
+SDL_Texture *glyph_obj_get_bumpmap_texture(SDL_Renderer *renderer, glyph_obj *glyph_o, double center_x, double center_y, double angle, double l_x, double l_y, SDL_Color color);
+void glyph_obj_set_bumpmap_cache(int angle_step, size_t budget);
+int glyph_obj_draw_shadow(SDL_Renderer *renderer,
+                          glyph_atlas *atlas,
+                          glyph_obj *glyph_o,
+                          double angle,
+                          int shadow_offset,
+                          int shadow_alpha);
+void glyph_obj_update_bumpmap_texture(SDL_Renderer *renderer, glyph_obj *glyph_o, double center_x, double center_y, int angle, double l_x, double l_y, SDL_Color color);
+void glyph_obj_draw_linear_bumpmap(SDL_Renderer *renderer, glyph_obj *glyph_o, double center_x, double center_y, double angle, double l_x, double l_y, SDL_Color color);
 
 #endif // GLYPH_OBJ_H
@@ -0,0 +1,190 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Time based animations driven by the menu loop. The progress of an
+ * animation only depends on the time passed since it started, so it
+ * ends on time however many frames could be drawn in between.
+ **/
+#include "menu_animation.h"
+#include "../base/log_contexts.h"
+#include "../base/logging.h"
+#include <stdlib.h>
+
+struct menu_animation {
+    Uint32 start;
+    Uint32 duration;
+    int started;
+    menu_easing *easing;
+    menu_animation_begin *begin;
+    menu_animation_step *step;
+    void *data; /* Owned by the animation */
+    menu_animation *next;
+};
+
+double menu_ease_linear(double t) {
+    return t;
+}
+
+double menu_ease_in_out(double t) {
+    return t * t * (3.0 - 2.0 * t);
+}
+
+double menu_ease_out(double t) {
+    return t * (2.0 - t);
+}
+
+static void menu_animation_begin_once(menu_animation *a) {
+    if (!a->started) {
+        a->started = 1;
+        if (a->begin) {
+            a->begin(a->data, &a->duration);
+        }
+    }
+}
+
+/**
+ * Queues an animation, which takes ownership of data (freed with free()
+ * after the last step)
+ **/
+int menu_animation_queue_push(menu_animation_queue *queue,
+                              Uint32 duration_ms,
+                              menu_easing *easing,
+                              menu_animation_begin *begin,
+                              menu_animation_step *step,
+                              void *data) {
+    menu_animation *a = calloc(1, sizeof(menu_animation));
+    if (!a) {
+        log_error(MENU_CTX, "menu_animation_queue_push: calloc failed\n");
+        return 0;
+    }
+
+    a->duration = duration_ms;
+    a->easing = easing ? easing : menu_ease_linear;
+    a->begin = begin;
+    a->step = step;
+    a->data = data;
+
+    if (queue->tail) {
+        queue->tail->next = a;
+        queue->tail = a;
+    } else {
+        /* Begin at once, so a draw before the next run shows the first frame */
+        a->start = SDL_GetTicks();
+        queue->head = queue->tail = a;
+        menu_animation_begin_once(a);
+        a->step(a->data, 0.0);
+    }
+
+    return 1;
+}
+
+static void menu_animation_queue_pop(menu_animation_queue *queue) {
+    menu_animation *a = queue->head;
+    queue->head = a->next;
+    if (!queue->head) {
+        queue->tail = NULL;
+    } else {
+        queue->head->start = a->start + a->duration;
+    }
+    free(a->data);
+    free(a);
+}
+
+/**
+ * Advances the animations to now. Returns 1 while there are animations
+ * left, 0 once the last one has made its final step.
+ **/
+int menu_animation_queue_run(menu_animation_queue *queue, Uint32 now) {
+    while (queue->head) {
+        menu_animation *a = queue->head;
+        menu_animation_begin_once(a);
+
+        Uint32 elapsed = SDL_TICKS_PASSED(now, a->start) ? now - a->start : 0;
+        if (elapsed < a->duration) {
+            a->step(a->data, a->easing((double) elapsed / (double) a->duration));
+            return 1;
+        }
+
+        a->step(a->data, 1.0);
+        menu_animation_queue_pop(queue);
+    }
+
+    return 0;
+}
+
+/**
+ * Jumps to the end of all queued animations
+ **/
+void menu_animation_queue_skip(menu_animation_queue *queue) {
+    while (queue->head) {
+        menu_animation_begin_once(queue->head);
+        queue->head->step(queue->head->data, 1.0);
+        menu_animation_queue_pop(queue);
+    }
+}
+
+/**
+ * Drops all queued animations without finishing them
+ **/
+void menu_animation_queue_clear(menu_animation_queue *queue) {
+    while (queue->head) {
+        menu_animation_queue_pop(queue);
+    }
+}
+
+/**
+ * Drops the animations made of step for which drop returns 1, without
+ * finishing them. The next animation starts when the running one is
+ * dropped.
+ **/
+void menu_animation_queue_remove(menu_animation_queue *queue,
+                                 menu_animation_step *step,
+                                 menu_animation_filter *drop,
+                                 void *arg) {
+    menu_animation *prev = NULL;
+    menu_animation *a = queue->head;
+    while (a) {
+        menu_animation *next = a->next;
+        if (a->step != step || !drop(a->data, arg)) {
+            prev = a;
+            a = next;
+            continue;
+        }
+
+        if (prev) {
+            prev->next = next;
+        } else {
+            queue->head = next;
+            if (next) {
+                next->start = SDL_GetTicks();
+            }
+        }
+        if (queue->tail == a) {
+            queue->tail = prev;
+        }
+        free(a->data);
+        free(a);
+        a = next;
+    }
+}
+
+int menu_animation_queue_active(const menu_animation_queue *queue) {
+    return queue->head != NULL;
+}
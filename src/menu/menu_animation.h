@@ -0,0 +1,77 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef MENU_ANIMATION_H
+#define MENU_ANIMATION_H
+
+#include<SDL2/SDL.h>
+
+/* The frame interval the loop aims at while animations are running */
+#define MENU_ANIMATION_FRAME_MS 16
+
+typedef double menu_easing(double t);
+
+double menu_ease_linear(double t);
+double menu_ease_in_out(double t);
+double menu_ease_out(double t);
+
+/**
+ * Called once, when the animation becomes the first in its queue (at
+ * once, if it is pushed to an empty queue). May
+ * change the duration, e.g. depending on the state at that time.
+ **/
+typedef void menu_animation_begin(void *data, Uint32 *duration_ms);
+/**
+ * Called with the eased progress of each frame. Frames are dropped when
+ * drawing is slow, only the last call with progress 1.0 is guaranteed.
+ **/
+typedef void menu_animation_step(void *data, double progress);
+/**
+ * Decides whether menu_animation_queue_remove drops an animation. May
+ * also change the data of animations it keeps.
+ **/
+typedef int menu_animation_filter(void *data, void *arg);
+
+typedef struct menu_animation menu_animation;
+
+/**
+ * Animations run one after the other, each starting when the one
+ * before has ended (not when its last frame was drawn).
+ **/
+typedef struct menu_animation_queue {
+    menu_animation *head;
+    menu_animation *tail;
+} menu_animation_queue;
+
+int menu_animation_queue_push(menu_animation_queue *queue,
+                              Uint32 duration_ms,
+                              menu_easing *easing,
+                              menu_animation_begin *begin,
+                              menu_animation_step *step,
+                              void *data);
+int menu_animation_queue_run(menu_animation_queue *queue, Uint32 now);
+void menu_animation_queue_skip(menu_animation_queue *queue);
+void menu_animation_queue_clear(menu_animation_queue *queue);
+void menu_animation_queue_remove(menu_animation_queue *queue,
+                                 menu_animation_step *step,
+                                 menu_animation_filter *drop,
+                                 void *arg);
+int menu_animation_queue_active(const menu_animation_queue *queue);
+
+#endif // MENU_ANIMATION_H
@@ -33,6 +33,8 @@
 #include "../raspberry/rotaryencoder.h"
 #endif
 
+#include "asset_cache.h"
+#include "frame_profiler.h"
 #include "menu_item_priv.h"
 #include "menu_menu_priv.h"
 #include "menu_ctrl_priv.h"
@@ -55,6 +57,14 @@
 #define get_kerning TTF_GetFontKerningSizeGlyphs
 
 #define MAX_LABEL_LENGTH 25
+#define CALLBACK_INTERVAL_DEFAULT 500
+#define FADE_DURATION_MS 300
+#define WARP_SEGMENT_MS 16
+#define WARP_MAX_MS 300 /* Far warps skip items rather than take longer */
+#define RASTER_THREADS_MAX 2
+#define TURN_ACCEL_TICKS_PER_SECOND 15.0 /* Slower spins turn one segment per tick */
+#define TURN_ACCEL_MAX_FACTOR 16.0
+#define TURN_SPIN_PAUSE_MS 250 /* Ticks further apart start a new spin */
 #define FONT_DEFAULT "/usr/share/fonts/truetype/freefont/FreeSans.ttf"
 #define BOLD_FONT_DEFAULT "/usr/share/fonts/truetype/freefont/FreeSansBold.ttf"
 
@@ -65,6 +75,8 @@
 static SDL_Color black = { 0, 0, 0, 255 };
 static SDL_Color white = { 255, 255, 255, 255 };
 
+void __menu_turn(menu *m, int direction, int redraw);
+void __menu_turn_by(menu *m, int segments);
 void __menu_turn_left(menu *m, int redraw);
 void __menu_turn_right(menu *m, int redraw);
 void menu_fade_out(menu *menu_frm, menu *menu_to);
@@ -85,12 +97,106 @@ int menu_action(menu_event evt, menu_ctrl *ctrl, menu *menu) {
 
 }
 
-void __menu_warp_sleep(menu_ctrl *ctrl) {
-    if (ctrl->warp_speed < 10) {
-        usleep((10 - ctrl->warp_speed) * 1000);
+/**
+ * Moves the position (id, segment) by one segment, as turning the menu
+ * right (direction 1) or left (direction -1) does
+ **/
+static void menu_step_position(menu *m, int direction, int *id, double *segment) {
+    *segment = *segment + direction;
+    if (*segment > m->segments_per_item) {
+        *segment = -m->segments_per_item;
+        *id = *id - 1;
+        if (*id < 0) {
+            *id = m->max_id;
+        }
+    } else if (*segment < -m->segments_per_item) {
+        *segment = m->segments_per_item;
+        *id = *id + 1;
+        if (*id > m->max_id) {
+            *id = 0;
+        }
+    }
+}
+
+typedef struct menu_warp {
+    menu_ctrl *ctrl;
+    menu *menu;
+    int id; /* The target, items of virtual menus may be recycled meanwhile */
+    int direction[3];
+    int turns[3]; /* Turn to the item, then lock in from the left and from the right */
+    int total;
+    int done;
+} menu_warp;
+
+static void menu_warp_begin(void *data, Uint32 *duration_ms) {
+    menu_warp *warp = (menu_warp *) data;
+    menu *m = warp->menu;
+    menu_ctrl *ctrl = warp->ctrl;
+    int id = m->current_id;
+    double segment = m->segment;
+
+    ctrl->warping = 1;
+
+    int dist_right  = (warp->id < m->current_id) ? m->current_id - warp->id : m->current_id + m->max_id - warp->id;
+    int dist_left   = (warp->id < m->current_id) ? m->max_id - m->current_id + warp->id : warp->id - m->current_id;
+
+    warp->direction[0] = dist_right < dist_left ? 1 : -1;
+    warp->direction[1] = 1;
+    warp->direction[2] = -1;
+
+    if (warp->id >= 0 && warp->id <= m->max_id && m->max_id >= 0) {
+        /* The first item takes the rest of its segments, every further one all of them */
+        int n = m->max_id + 1;
+        int items = warp->direction[0] > 0 ? (m->current_id - warp->id + n) % n : (warp->id - m->current_id + n) % n;
+        if (items > 0) {
+            int first = warp->direction[0] > 0 ? m->segments_per_item - to_int(segment) + 1
+                                               : to_int(segment) + m->segments_per_item + 1;
+            warp->turns[0] = first + (items - 1) * (2 * m->segments_per_item + 1);
+            segment = warp->direction[0] > 0 ? -m->segments_per_item : m->segments_per_item;
+        }
+    }
+
+    while (segment < 0) {
+        menu_step_position(m, warp->direction[1], &id, &segment);
+        warp->turns[1]++;
+    }
+
+    while (segment > 0) {
+        menu_step_position(m, warp->direction[2], &id, &segment);
+        warp->turns[2]++;
+    }
+
+    warp->total = warp->turns[0] + warp->turns[1] + warp->turns[2];
+    *duration_ms = warp->total * (WARP_SEGMENT_MS + 10 - ctrl->warp_speed);
+    if (*duration_ms > WARP_MAX_MS) {
+        *duration_ms = WARP_MAX_MS;
+    }
+}
+
+static void menu_warp_step(void *data, double progress) {
+    menu_warp *warp = (menu_warp *) data;
+    menu *m = warp->menu;
+    int target = progress >= 1.0 ? warp->total : to_int(progress * warp->total);
+
+    /* Each frame jumps straight to where the warp should be by now */
+    while (warp->done < target) {
+        int phase = warp->done < warp->turns[0] ? 0 : warp->done < warp->turns[0] + warp->turns[1] ? 1 : 2;
+        int phase_end = phase == 0 ? warp->turns[0] : phase == 1 ? warp->turns[0] + warp->turns[1] : warp->total;
+        int n = (target < phase_end ? target : phase_end) - warp->done;
+        __menu_turn_by(m, warp->direction[phase] * n);
+        warp->done += n;
+    }
+
+    if (progress >= 1.0) {
+        warp->ctrl->warping = 0;
     }
 }
 
+/**
+ * Turns the menu of item until item is selected, fading to the menu
+ * first if it isn't the current one. Returns at once, the menu loop
+ * draws the animation.
+ **/
 void menu_item_warp_to(menu_item *item) {
     log_debug(MENU_CTX,
               "menu_item_warp_to: menu_item->menu->ctrl->object = %p->%p->%p->%p\n",
@@ -100,6 +206,9 @@ void menu_item_warp_to(menu_item *item) {
               item->menu->ctrl->user_data);
     menu *m = (menu *) item->menu;
     menu_ctrl *ctrl = (menu_ctrl *) m->ctrl;
+
+    menu_animation_queue_skip(&ctrl->animations);
+
     if (m != ctrl->current) {
         menu_fade_out(ctrl->current, m);
         ctrl->current = m;
@@ -111,41 +220,40 @@ void menu_item_warp_to(menu_item *item) {
         }
     }
 
-    ctrl->warping = 1;
-
-    int dist_right  = (item->id < m->current_id) ? m->current_id - item->id : m->current_id + m->max_id - item->id;
-    int dist_left   = (item->id < m->current_id) ? m->max_id - m->current_id + item->id : item->id - m->current_id;
-
-    if (dist_right < dist_left) {
-        while (item->id != m->current_id && ctrl->warping) {
-            __menu_turn_right(m,1);
-            menu_ctrl_process_events(ctrl);
-            __menu_warp_sleep(ctrl);
-        }
-    } else {
-        while (item->id != m->current_id && ctrl->warping) {
-            __menu_turn_left(m,1);
-            menu_ctrl_process_events(ctrl);
-            __menu_warp_sleep(ctrl);
-        }
+    menu_warp *warp = calloc(1, sizeof(menu_warp));
+    if (!warp) {
+        log_error(MENU_CTX, "menu_item_warp_to: calloc failed\n");
+        return;
     }
-
-    // Lock in
-    while (m->segment < 0 && ctrl->warping) {
-        __menu_turn_right(m,1);
-        menu_ctrl_process_events(ctrl);
-        __menu_warp_sleep(ctrl);
+    warp->ctrl = ctrl;
+    warp->menu = m;
+    warp->id = item->id;
+    if (!menu_animation_queue_push(&ctrl->animations, 0, menu_ease_out, menu_warp_begin, menu_warp_step, warp)) {
+        free(warp);
     }
 
-    while (m->segment > 0 && ctrl->warping) {
-        __menu_turn_left(m,1);
-        menu_ctrl_process_events(ctrl);
-        __menu_warp_sleep(ctrl);
-    }
+    log_debug(MENU_CTX, "menu_item_warp_to: ctrl->object = %p->%p\n", ctrl, ctrl->user_data);
+}
 
-    ctrl->warping = 0;
+/**
+ * Plays the queued animations to their end, drawing each frame.
+ * Blocks, meant for situations like shutting down, where the loop
+ * doesn't run anymore.
+ **/
+void menu_ctrl_finish_animations(menu_ctrl *ctrl) {
+    while (menu_ctrl_animate(ctrl)) {
+    }
+}
 
-    log_debug(MENU_CTX, "menu_item_warp_to: ctrl->object = %p->%p\n", ctrl, ctrl->user_data);
+/**
+ * Advances the animations to now and draws the frame. Returns 1 while
+ * there are animations left or labels are still being rendered.
+ **/
+int menu_ctrl_animate(menu_ctrl *ctrl) {
+    int animating = menu_animation_queue_run(&ctrl->animations, SDL_GetTicks());
+    ctrl->glyphs_pending = 0;
+    menu_ctrl_draw(ctrl);
+    return animating || ctrl->glyphs_pending;
 }
 
 int menu_ctrl_clear(menu_ctrl *ctrl,
@@ -197,59 +305,163 @@ int menu_ctrl_clear(menu_ctrl *ctrl,
     return 1;
 }
 
-void menu_update_cnt_rad(menu *m, SDL_Point center, int radius, int recursive) {
-    for (int i = 0; i <= m->max_id; i++) {
-        if (m->item[i]) {
-            if (recursive && m->item[i]->sub_menu) {
-                menu_update_cnt_rad((menu *) m->item[i]->sub_menu, center, radius, recursive);
-            } else {
-                menu_item_update_cnt_rad(m->item[i],center,radius);
-            }
+typedef struct menu_fade {
+    menu_ctrl *ctrl;
+    menu *menu_frm;
+    menu *menu_to;
+    int out; /* Fading out to a sub menu or in to the parent */
+    double R_frm;
+    double r_frm;
+    double d_frm;
+    double R_to;
+    double r_to;
+} menu_fade;
+
+static void menu_fade_begin(void *data, Uint32 *duration_ms) {
+    menu_fade *fade = (menu_fade *) data;
+    menu *menu_frm = fade->menu_frm;
+    (void) duration_ms;
+
+    fade->ctrl->warping = 1;
+    fade->ctrl->fade_from = menu_frm;
+
+    fade->R_frm = menu_frm ? menu_frm->radius_scales_end : 0.0;
+    fade->r_frm = menu_frm ? menu_frm->radius_labels : 0.0;
+    fade->d_frm = fade->R_frm - fade->r_frm;
+
+    if (fade->out) {
+        fade->R_to = fade->r_frm;
+        fade->r_to = 0;
+    } else {
+        fade->r_to = fade->R_frm;
+        fade->R_to = fade->R_frm + fade->d_frm;
+    }
+}
+
+static void menu_fade_step(void *data, double t) {
+    menu_fade *fade = (menu_fade *) data;
+    menu_ctrl *ctrl = fade->ctrl;
+    menu *menu_frm = fade->menu_frm;
+    menu *menu_to = fade->menu_to;
+    double t_1 = 1.0 - t;
+
+    if (menu_frm) {
+        if (fade->out) {
+            menu_frm->radius_labels = to_int(t * fade->R_frm + t_1 * fade->r_frm);
+            menu_frm->radius_scales_end = to_int(t * (fade->R_frm + fade->d_frm) + t_1 * fade->R_frm);
+        } else {
+            menu_frm->radius_labels = to_int(t_1 * fade->r_frm);
+            menu_frm->radius_scales_end = to_int(t * fade->r_frm + t_1 * fade->R_frm);
+        }
+        menu_frm->dirty = 1;
+    }
+    menu_to->radius_labels = to_int(t * fade->r_frm + t_1 * fade->r_to);
+    menu_to->radius_scales_end = to_int(t * fade->R_frm + t_1 * fade->R_to);
+    menu_to->dirty = 1;
+
+    if (t < 1.0) {
+        return;
+    }
+
+    ctrl->fade_from = NULL;
+    if (fade->out) {
+        if (menu_frm) {
+            menu_frm->radius_labels = ctrl->radius_labels;
         }
+        menu_to->radius_labels = ctrl->radius_labels;
     }
 }
 
-void menu_fade_out(menu *menu_frm, menu *menu_to) {
-    menu_ctrl *ctrl = (menu_ctrl *) menu_frm->ctrl;
-    ctrl->warping = 1;
-    double R_frm = menu_frm ? menu_frm->radius_scales_end : 0.0;
-    double r_frm = menu_frm ? menu_frm->radius_labels : 0.0;
-    double d_frm = R_frm - r_frm;
+/**
+ * Queues the animation from menu_frm to menu_to, the menu loop draws
+ * both menus until it has finished
+ **/
+static void menu_fade_start(menu *menu_frm, menu *menu_to, int out) {
+    menu_ctrl *ctrl = (menu_ctrl *) menu_to->ctrl;
 
-    double R_to = r_frm;
-    double r_to = 0;
+    menu_animation_queue_skip(&ctrl->animations);
 
-    int s = 20;
-    double ds = (double) s;
-    double inv_ds = 1 / ds;
+    menu_fade *fade = calloc(1, sizeof(menu_fade));
+    if (!fade) {
+        log_error(MENU_CTX, "menu_fade_start: calloc failed\n");
+        return;
+    }
+    fade->ctrl = ctrl;
+    fade->menu_frm = menu_frm != menu_to ? menu_frm : NULL;
+    fade->menu_to = menu_to;
+    fade->out = out;
+    if (!menu_animation_queue_push(&ctrl->animations,
+                                   FADE_DURATION_MS,
+                                   menu_ease_in_out,
+                                   menu_fade_begin,
+                                   menu_fade_step,
+                                   fade)) {
+        free(fade);
+    }
+}
 
-    int i = 0;
-    for (i = 0; i <= s; i++) {
+static int menu_warp_drop_menu(void *data, void *arg) {
+    menu_warp *warp = (menu_warp *) data;
+    if (warp->menu != (menu *) arg) {
+        return 0;
+    }
+    warp->ctrl->warping = 0;
+    return 1;
+}
 
-        double x = (double) i;
-        double x_1 = ds - x;
+/**
+ * Fades to the menu are dropped, fades from it go on without it
+ **/
+static int menu_fade_drop_menu(void *data, void *arg) {
+    menu_fade *fade = (menu_fade *) data;
+    menu *m = (menu *) arg;
+    menu_ctrl *ctrl = fade->ctrl;
+
+    if (fade->menu_to != m) {
+        if (fade->menu_frm == m) {
+            fade->menu_frm = NULL;
+        }
+        return 0;
+    }
 
-        if (menu_frm) {
-            menu_frm->radius_labels = to_int(inv_ds * (x * R_frm + x_1 * r_frm));
-            menu_update_cnt_rad(menu_frm, ctrl->center, menu_frm->radius_labels, 0);
-            menu_frm->radius_scales_end = to_int(inv_ds * (x * (R_frm + d_frm) + x_1 * R_frm));
-            menu_frm->dirty = 1;
-            menu_draw(menu_frm, 1, 0);
+    if (fade->menu_frm) {
+        fade->menu_frm->radius_labels = ctrl->radius_labels;
+        fade->menu_frm->dirty = 1;
+        if (ctrl->fade_from == fade->menu_frm) {
+            ctrl->fade_from = NULL;
         }
-        menu_to->radius_labels = to_int(inv_ds * (x * r_frm + x_1 * r_to));
-        menu_update_cnt_rad(menu_to, ctrl->center, menu_to->radius_labels, 0);
-        menu_to->radius_scales_end = to_int(inv_ds * (x * R_frm + x_1 * R_to));
-        menu_to->dirty = 1;
-        menu_draw(menu_to, 0, 1);
     }
+    return 1;
+}
 
-    menu_frm->radius_labels = ctrl->radius_labels;
-    menu_update_cnt_rad(menu_frm, ctrl->center, menu_frm->radius_labels, 0);
-    menu_to->radius_labels = ctrl->radius_labels;
-    menu_update_cnt_rad(menu_to, ctrl->center, menu_to->radius_labels, 0);
+/**
+ * Called by menu_free before m goes away, drops everything of ctrl
+ * still pointing to it
+ **/
+void menu_ctrl_forget_menu(menu_ctrl *ctrl, menu *m) {
+    if (!ctrl || !m) {
+        return;
+    }
+
+    menu_animation_queue_remove(&ctrl->animations, menu_warp_step, menu_warp_drop_menu, m);
+    menu_animation_queue_remove(&ctrl->animations, menu_fade_step, menu_fade_drop_menu, m);
+
+    if (ctrl->fade_from == m) {
+        ctrl->fade_from = NULL;
+    }
+    if (ctrl->current_transient == m) {
+        ctrl->current_transient = NULL;
+    }
+    if (ctrl->snapshot_menu == m) {
+        ctrl->snapshot_menu = NULL;
+    }
+}
+
+void menu_fade_out(menu *menu_frm, menu *menu_to) {
+    menu_ctrl *ctrl = (menu_ctrl *) menu_to->ctrl;
+
+    menu_fade_start(menu_frm, menu_to, 1);
 
-    menu_to->dirty = 1;
-    menu_draw(menu_to, 1, 1);
     if (!menu_to->transient) {
         ctrl->active = menu_to;
     }
@@ -260,39 +472,10 @@ void menu_fade_out(menu *menu_frm, menu *menu_to) {
 }
 
 void menu_fade_in(menu *menu_frm, menu *menu_to) {
-    menu_ctrl *ctrl = (menu_ctrl *) menu_frm->ctrl;
-
-    ctrl->warping = 1;
-    double R_frm = menu_frm->radius_scales_end;
-    double r_frm = menu_frm->radius_labels;
-    double d_frm = R_frm - r_frm;
+    menu_ctrl *ctrl = (menu_ctrl *) menu_to->ctrl;
 
-    double r_to = R_frm;
-    double R_to = R_frm + d_frm;
+    menu_fade_start(menu_frm, menu_to, 0);
 
-    int s = 20;
-    double ds = (double) s;
-    double inv_ds = 1 / ds;
-
-    int i = 0;
-    for (i = 0; i <= s; i++) {
-
-        double x = (double) i;
-        double x_1 = ds - x;
-
-        menu_frm->radius_labels = to_int(inv_ds * x_1 * r_frm);
-        menu_update_cnt_rad(menu_frm, ctrl->center, menu_frm->radius_labels, 0);
-        menu_frm->radius_scales_end = to_int(inv_ds * (x * r_frm + x_1 * R_frm));
-        menu_to->radius_labels = to_int(inv_ds * (x * r_frm + x_1 * r_to));
-        menu_update_cnt_rad(menu_to, ctrl->center, menu_to->radius_labels, 0);
-        menu_to->radius_scales_end = to_int(inv_ds * (x * R_frm + x_1 * R_to));
-        menu_frm->dirty = 1;
-        menu_draw(menu_frm, 1, 0);
-        menu_to->dirty = 1;
-        menu_draw(menu_to, 0, 1);
-    }
-    menu_to->dirty = 1;
-    menu_draw(menu_to, 1, 1);
     if (!menu_to->transient) {
         ctrl->active = menu_to;
     }
@@ -336,21 +519,8 @@ void __menu_turn(menu *m, int direction, int redraw) {
 
     ctrl->warping = 1;
     unsigned int total_n_o_segments = m->n_o_items_on_scale * (2.0*m->segments_per_item+1);
-    m->segment = m->segment + direction;
+    menu_step_position(m, direction, &m->current_id, &m->segment);
     m->dirty = 1;
-    if (m->segment > m->segments_per_item) {
-        m->segment = -m->segments_per_item;
-        m->current_id = m->current_id - 1;
-        if (m->current_id < 0) {
-            m->current_id = m->max_id;
-        }
-    } else if (m->segment < -m->segments_per_item) {
-        m->segment = m->segments_per_item;
-        m->current_id = m->current_id + 1;
-        if (m->current_id > m->max_id) {
-            m->current_id = 0;
-        }
-    }
     ctrl->bg_segment = ctrl->bg_segment + direction;
     if (ctrl->bg_segment >= total_n_o_segments) {
         ctrl->bg_segment = 0;
@@ -365,6 +535,33 @@ void __menu_turn(menu *m, int direction, int redraw) {
 
 }
 
+/**
+ * Turns m by segments at once, right for positive segments, as that many
+ * calls of __menu_turn would
+ **/
+void __menu_turn_by(menu *m, int segments) {
+    if (segments == 0) {
+        return;
+    }
+
+    menu_ctrl *ctrl = (menu_ctrl *) m->ctrl;
+
+    ctrl->warping = 1;
+    if (m->max_id >= 0) {
+        /* The position counted in segments, the segments of an item run from -segments_per_item */
+        long l = 2 * m->segments_per_item + 1;
+        long n = (long) (m->max_id + 1) * l;
+        long p = to_int(m->segment) + m->segments_per_item - (long) m->current_id * l + segments;
+        p = (p % n + n) % n;
+        m->segment = (double) (p % l - m->segments_per_item);
+        m->current_id = (int) ((m->max_id + 1 - p / l) % (m->max_id + 1));
+    }
+    m->dirty = 1;
+
+    double total_n_o_segments = m->n_o_items_on_scale * (2.0*m->segments_per_item+1);
+    ctrl->bg_segment = fmod(fmod(ctrl->bg_segment + segments, total_n_o_segments) + total_n_o_segments, total_n_o_segments);
+}
+
 void menu_turn_right(menu *m) {
     __menu_turn_right(m, 1);
 }
@@ -413,12 +610,9 @@ void menu_ctrl_set_offset(menu_ctrl *ctrl, int x_offset, int y_offset) {
     center.x = ctrl->x_offset + ctrl->w / 2.0;
     center.y = ctrl->y_offset + 0.5 * ctrl->offset * ctrl->w;
 
+    /* Labels follow the new center when they are drawn next */
     ctrl->center = center;
 
-    for (int r = 0; r < ctrl->n_roots; r++) {
-        menu_update_cnt_rad(ctrl->root[r],ctrl->center,ctrl->radius_labels, 1);
-    }
-
 }
 
 void *menu_ctrl_get_user_data(menu_ctrl *ctrl) {
@@ -429,7 +623,7 @@ menu *menu_ctrl_get_root(menu_ctrl *ctrl) {
     return ctrl->root[0];
 }
 
-void menu_ctrl_draw_indicator(menu_ctrl *ctrl, double xc, double yc, double angle) {
+static void menu_ctrl_draw_indicator_lines(menu_ctrl *ctrl, SDL_Renderer *renderer, double xc, double yc, SDL_BlendMode blend_mode) {
     double a = - M_PI * ctrl->angle_offset / 180.0 - M_PI_2;
 
     double cos_a = cos(a);
@@ -442,77 +636,289 @@ void menu_ctrl_draw_indicator(menu_ctrl *ctrl, double xc, double yc, double angl
     double fy2 = yc + ctrl->w * sin_a;
 
     SDL_SetRenderDrawBlendMode(
-            ctrl->renderer,
-            SDL_BLENDMODE_BLEND);
+            renderer,
+            blend_mode);
 
     SDL_SetRenderDrawColor(
-            ctrl->renderer,
+            renderer,
             ctrl->indicator_color->r,
             ctrl->indicator_color->g,
             ctrl->indicator_color->b,
             ctrl->indicator_color->a);
 
     SDL_RenderDrawLineF(
-            ctrl->renderer,
+            renderer,
             fx1,
             fy1,
             fx2,
             fy2);
 
     SDL_RenderDrawLineF(
-            ctrl->renderer,
+            renderer,
             fx1-1.0,
             fy1,
             fx2-1.0,
             fy2);
 
     SDL_RenderDrawLineF(
-            ctrl->renderer,
+            renderer,
             fx1+1.0,
             fy1,
             fx2+1.0,
             fy2);
 
     SDL_SetRenderDrawColor(
-            ctrl->renderer,
+            renderer,
             ctrl->indicator_color_light->r,
             ctrl->indicator_color_light->g,
             ctrl->indicator_color_light->b,
             ctrl->indicator_color->a * 180 / 255);
 
     SDL_RenderDrawLineF(
-            ctrl->renderer,
+            renderer,
             fx1-2.0,
             fy1,
             fx2-2.0,
             fy2);
 
     SDL_SetRenderDrawColor(
-            ctrl->renderer,
+            renderer,
             ctrl->indicator_color_dark->r,
             ctrl->indicator_color_dark->g,
             ctrl->indicator_color_dark->b,
             ctrl->indicator_color->a * 180 / 255);
 
     SDL_RenderDrawLineF(
-            ctrl->renderer,
+            renderer,
             fx1+2.0,
             fy1,
             fx2+2.0,
             fy2);
 }
 
+void menu_ctrl_draw_indicator(menu_ctrl *ctrl, double xc, double yc, double angle) {
+    menu_ctrl_draw_indicator_lines(ctrl, ctrl->renderer, xc, yc, SDL_BLENDMODE_BLEND);
+}
+
+static SDL_Rect menu_ctrl_light_rect(menu_ctrl *ctrl) {
+    double w = ctrl->w;
+    double h = ctrl->h;
+    double xo = ctrl->center.x - 0.5 * ctrl->w;
+    double yo = 0;
+    SDL_Rect dst_rect = {xo + ctrl->light_img_x, yo + ctrl->light_img_y, w, h};
+    return dst_rect;
+}
+
 void menu_ctrl_apply_light(menu_ctrl *ctrl) {
     if (ctrl->light_texture) {
-        double w = ctrl->w;
-        double h = ctrl->h;
-        double xo = ctrl->center.x - 0.5 * ctrl->w;
-        double yo = 0;
-        const SDL_Rect dst_rect = {xo + ctrl->light_img_x, yo + ctrl->light_img_y, w, h};
+        const SDL_Rect dst_rect = menu_ctrl_light_rect(ctrl);
         SDL_RenderCopy(ctrl->renderer,ctrl->light_texture,NULL,&dst_rect);
     }
 }
 
+/**
+ * Folds the light into the indicator pixels. Drawing the indicator and
+ * then the light gives dst * k + c' per channel. With a k equal for all
+ * channels this is the same as blending c = c' / (1 - k) with alpha 1 - k.
+ * Returns 0 for lights which brighten (multiply by more than 1), these
+ * can't be expressed as blending.
+ **/
+static int menu_ctrl_fold_light(menu_ctrl *ctrl, SDL_Surface *overlay) {
+    SDL_Surface *light = NULL;
+
+    if (ctrl->light_surface) {
+        light = SDL_CreateRGBSurfaceWithFormat(0, overlay->w, overlay->h, 32, DEFAULT_SDL_PIXELFORMAT);
+        if (!light) {
+            log_error(MENU_CTX, "Could not create light surface: %s\n", SDL_GetError());
+            return 0;
+        }
+        SDL_Rect dst_rect = menu_ctrl_light_rect(ctrl);
+        SDL_SetSurfaceBlendMode(ctrl->light_surface, SDL_BLENDMODE_NONE);
+        SDL_BlitScaled(ctrl->light_surface, NULL, light, &dst_rect);
+
+        if (ctrl->light_blend == SDL_BLENDMODE_MUL) {
+            for (int y = 0; y < light->h; y++) {
+                Uint32 *l = (Uint32 *) ((Uint8 *) light->pixels + light->pitch * y);
+                for (int x = 0; x < light->w; x++) {
+                    Uint8 lr, lg, lb, la;
+                    SDL_GetRGBA(l[x], light->format, &lr, &lg, &lb, &la);
+                    if (lr > la || lg > la || lb > la) {
+                        SDL_FreeSurface(light);
+                        return 0;
+                    }
+                }
+            }
+        }
+    }
+
+    for (int y = 0; y < overlay->h; y++) {
+        Uint32 *o = (Uint32 *) ((Uint8 *) overlay->pixels + overlay->pitch * y);
+        Uint32 *l = light ? (Uint32 *) ((Uint8 *) light->pixels + light->pitch * y) : NULL;
+
+        for (int x = 0; x < overlay->w; x++) {
+            Uint8 ir, ig, ib, ia, lr = 0, lg = 0, lb = 0, la = 0;
+            SDL_GetRGBA(o[x], overlay->format, &ir, &ig, &ib, &ia);
+            if (l) {
+                SDL_GetRGBA(l[x], light->format, &lr, &lg, &lb, &la);
+            }
+
+            double ic[3] = {ir / 255.0, ig / 255.0, ib / 255.0};
+            double lc[3] = {lr / 255.0, lg / 255.0, lb / 255.0};
+            double i_a = ia / 255.0;
+            double l_a = la / 255.0;
+            double k;
+            double c[3];
+
+            if (ctrl->light_blend == SDL_BLENDMODE_MUL) {
+                /* dst * (l + 1 - la), the light is grey */
+                double f = lc[0] + 1.0 - l_a;
+                k = (1.0 - i_a) * f;
+                for (int ch = 0; ch < 3; ch++) {
+                    c[ch] = ic[ch] * i_a * (lc[ch] + 1.0 - l_a);
+                }
+            } else {
+                /* Blended light images, opaque ones have la = 1 */
+                k = (1.0 - i_a) * (1.0 - l_a);
+                for (int ch = 0; ch < 3; ch++) {
+                    c[ch] = ic[ch] * i_a * (1.0 - l_a) + lc[ch] * l_a;
+                }
+            }
+
+            double a = 1.0 - k;
+            if (a <= 0.0) {
+                o[x] = 0;
+                continue;
+            }
+
+            o[x] = SDL_MapRGBA(overlay->format,
+                               to_Uint8(255.0 * fmin(c[0] / a, 1.0)),
+                               to_Uint8(255.0 * fmin(c[1] / a, 1.0)),
+                               to_Uint8(255.0 * fmin(c[2] / a, 1.0)),
+                               to_Uint8(255.0 * a));
+        }
+    }
+
+    if (light) {
+        SDL_FreeSurface(light);
+    }
+
+    return 1;
+}
+
+/**
+ * Renders the indicator with a software renderer, folds the light into it
+ * and uploads the part which is not transparent
+ **/
+static void menu_ctrl_update_overlay(menu_ctrl *ctrl) {
+    ctrl->overlay_dirty = 0;
+    ctrl->overlay_failed = 0;
+
+    if (ctrl->overlay) {
+        SDL_DestroyTexture(ctrl->overlay);
+        ctrl->overlay = NULL;
+    }
+
+    if (ctrl->light_texture) {
+        SDL_DestroyTexture(ctrl->light_texture);
+        ctrl->light_texture = NULL;
+    }
+
+    SDL_Surface *overlay = SDL_CreateRGBSurfaceWithFormat(0, ctrl->w, ctrl->h, 32, DEFAULT_SDL_PIXELFORMAT);
+    SDL_Renderer *renderer = overlay ? SDL_CreateSoftwareRenderer(overlay) : NULL;
+
+    if (!renderer) {
+        log_error(MENU_CTX, "Could not create overlay renderer: %s\n", SDL_GetError());
+        ctrl->overlay_failed = 1;
+    } else {
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        /* The lines keep their own alpha, they are blended when the overlay is drawn */
+        menu_ctrl_draw_indicator_lines(ctrl, renderer, ctrl->center.x, ctrl->center.y, SDL_BLENDMODE_NONE);
+        SDL_RenderPresent(renderer);
+        SDL_DestroyRenderer(renderer);
+    }
+
+    if (!ctrl->overlay_failed && !menu_ctrl_fold_light(ctrl, overlay) && ctrl->light_surface) {
+        log_info(MENU_CTX, "Light can't be folded into the overlay, applying it separately\n");
+        ctrl->light_texture = SDL_CreateTextureFromSurface(ctrl->renderer, ctrl->light_surface);
+        SDL_SetTextureBlendMode(ctrl->light_texture, ctrl->light_blend);
+    }
+
+    if (ctrl->overlay_failed) {
+        if (ctrl->light_surface) {
+            ctrl->light_texture = SDL_CreateTextureFromSurface(ctrl->renderer, ctrl->light_surface);
+            SDL_SetTextureBlendMode(ctrl->light_texture, ctrl->light_blend);
+        }
+        if (overlay) {
+            SDL_FreeSurface(overlay);
+        }
+        return;
+    }
+
+    /* Only upload the bounding box of the visible pixels */
+    int min_x = overlay->w, min_y = overlay->h, max_x = -1, max_y = -1;
+    for (int y = 0; y < overlay->h; y++) {
+        Uint32 *o = (Uint32 *) ((Uint8 *) overlay->pixels + overlay->pitch * y);
+        for (int x = 0; x < overlay->w; x++) {
+            if (o[x] & overlay->format->Amask) {
+                min_x = x < min_x ? x : min_x;
+                max_x = x > max_x ? x : max_x;
+                min_y = y < min_y ? y : min_y;
+                max_y = y > max_y ? y : max_y;
+            }
+        }
+    }
+
+    if (max_x >= min_x && max_y >= min_y) {
+        ctrl->overlay_rect.x = min_x;
+        ctrl->overlay_rect.y = min_y;
+        ctrl->overlay_rect.w = max_x - min_x + 1;
+        ctrl->overlay_rect.h = max_y - min_y + 1;
+
+        ctrl->overlay = SDL_CreateTexture(ctrl->renderer, DEFAULT_SDL_PIXELFORMAT, SDL_TEXTUREACCESS_STATIC,
+                                          ctrl->overlay_rect.w, ctrl->overlay_rect.h);
+        if (!ctrl->overlay) {
+            log_error(MENU_CTX, "Could not create overlay texture: %s\n", SDL_GetError());
+            ctrl->overlay_failed = 1;
+        } else {
+            SDL_SetTextureBlendMode(ctrl->overlay, SDL_BLENDMODE_BLEND);
+            SDL_UpdateTexture(ctrl->overlay, NULL,
+                              (Uint8 *) overlay->pixels + overlay->pitch * min_y + 4 * min_x,
+                              overlay->pitch);
+        }
+    }
+
+    if (ctrl->overlay_failed && ctrl->light_surface && !ctrl->light_texture) {
+        ctrl->light_texture = SDL_CreateTextureFromSurface(ctrl->renderer, ctrl->light_surface);
+        SDL_SetTextureBlendMode(ctrl->light_texture, ctrl->light_blend);
+    }
+
+    SDL_FreeSurface(overlay);
+}
+
+/**
+ * Draws the indicator and the light. Both only depend on the angle offset,
+ * the indicator color and the light, so they are composed into one cached
+ * texture which is rebuilt when one of them changes (overlay_dirty).
+ **/
+void menu_ctrl_draw_overlay(menu_ctrl *ctrl) {
+    Uint64 phase_start = frame_profiler_now();
+    if (ctrl->overlay_dirty) {
+        menu_ctrl_update_overlay(ctrl);
+    }
+
+    if (ctrl->overlay) {
+        SDL_RenderCopy(ctrl->renderer, ctrl->overlay, NULL, &ctrl->overlay_rect);
+    } else if (ctrl->overlay_failed) {
+        menu_ctrl_draw_indicator(ctrl, ctrl->center.x, ctrl->center.y, 0.0);
+    }
+    frame_profiler_add(FRAME_PHASE_INDICATOR, phase_start);
+
+    phase_start = frame_profiler_now();
+    menu_ctrl_apply_light(ctrl);
+    frame_profiler_add(FRAME_PHASE_LIGHT, phase_start);
+}
+
 void menu_ctrl_set_radii(menu_ctrl *ctrl, int radius_labels, int radius_scales_start, int radius_scales_end) {
 
     if (ctrl->root) {
@@ -544,8 +950,8 @@ static int menu_ctrl_set_color_component(SDL_Color **target,
         return 0;
     }
 
-    for (int root = 0; root < ctrl->n_roots; root++) {
-        menu_rebuild_glyphs(ctrl->root[root]);
+    if (ctrl->current) {
+        ctrl->current->dirty = 1;
     }
 
     ctrl->style_version++;
@@ -573,6 +979,7 @@ void menu_ctrl_set_angle_offset(menu_ctrl *ctrl, double a) {
         return;
     }
     ctrl->angle_offset = a;
+    ctrl->overlay_dirty = 1;
     menu_ctrl_draw(ctrl);
 }
 
@@ -592,9 +999,77 @@ menu *menu_ctrl_get_current_transient(menu_ctrl *ctrl) {
     return ctrl ? ctrl->current_transient : NULL;
 }
 
+/**
+ * Renders the active menu into ctrl->snapshot unless it is still up to
+ * date, returns 0 if there is no snapshot to draw an overlay on
+ **/
+static int menu_ctrl_update_snapshot(menu_ctrl *ctrl) {
+    menu *under = ctrl->active;
+
+    if (ctrl->snapshot && ctrl->snapshot_menu == under && !under->dirty) {
+        return 1;
+    }
+
+    int w, h;
+    if (SDL_GetRendererOutputSize(ctrl->renderer, &w, &h) != 0) {
+        log_warning(MENU_CTX, "Could not get the output size, drawing overlays plain: %s\n", SDL_GetError());
+        ctrl->snapshot_failed = 1;
+        return 0;
+    }
+
+    if (ctrl->snapshot) {
+        int tw, th;
+        SDL_QueryTexture(ctrl->snapshot, NULL, NULL, &tw, &th);
+        if (tw != w || th != h) {
+            SDL_DestroyTexture(ctrl->snapshot);
+            ctrl->snapshot = NULL;
+        }
+    }
+
+    if (!ctrl->snapshot) {
+        ctrl->snapshot = SDL_CreateTexture(ctrl->renderer, DEFAULT_SDL_PIXELFORMAT, SDL_TEXTUREACCESS_TARGET, w, h);
+        if (!ctrl->snapshot) {
+            log_warning(MENU_CTX, "Could not create snapshot texture, drawing overlays plain: %s\n", SDL_GetError());
+            ctrl->snapshot_failed = 1;
+            return 0;
+        }
+    }
+
+    SDL_Texture *target = SDL_GetRenderTarget(ctrl->renderer);
+    SDL_SetRenderTarget(ctrl->renderer, ctrl->snapshot);
+    under->dirty = 1;
+    menu_draw_unlit(under);
+    SDL_SetRenderTarget(ctrl->renderer, target);
+    ctrl->snapshot_menu = under;
+
+    return 1;
+}
+
 int menu_ctrl_draw(menu_ctrl *ctrl) {
-    if (ctrl->current) {
-        return menu_draw(ctrl->current, 1, 1);
+    if (ctrl->fade_from && ctrl->current) {
+        ctrl->fade_from->dirty = 1;
+        ctrl->current->dirty = 1;
+        menu_draw(ctrl->fade_from, 1, 0);
+        return menu_draw(ctrl->current, 0, 1);
+    }
+
+    menu *current = ctrl->current;
+    if (current && current->overlay && current->transient
+        && ctrl->active && ctrl->active != current && !ctrl->snapshot_failed) {
+        if (!current->dirty && !ctrl->active->dirty) {
+            return 0;
+        }
+        if (menu_ctrl_update_snapshot(ctrl)) {
+            current->dirty = 1;
+            return menu_draw_over(current, ctrl->snapshot);
+        }
+    }
+
+    /* Whatever the active menu does next, it is not in the snapshot */
+    ctrl->snapshot_menu = NULL;
+
+    if (current) {
+        return menu_draw(current, 1, 1);
     }
 
     return 0;
@@ -640,16 +1115,18 @@ int menu_ctrl_set_style(menu_ctrl *ctrl, char *background, char *scale, char *in
 
     free_and_set_null((void **) &ctrl->indicator_color_dark);
     ctrl->indicator_color_dark = color_between(ctrl->indicator_color, &black, 0.85);
+    ctrl->overlay_dirty = 1;
+    ctrl->snapshot_menu = NULL;
 
     if (ctrl->bg_image) {
-        SDL_DestroyTexture(ctrl->bg_image);
+        asset_cache_release_texture(ctrl->bg_image);
         ctrl->bg_image = NULL;
     }
     free_and_set_null((void **) &ctrl->bg_image_path);
 
     if (bgImagePath) {
         ctrl->bg_image_path = my_copystr(bgImagePath);
-        ctrl->bg_image = IMG_LoadTexture(ctrl->renderer,bgImagePath);
+        ctrl->bg_image = asset_cache_load_texture(ctrl->renderer,bgImagePath);
         if (!ctrl->bg_image) {
             log_error(MENU_CTX, "Could not load background image %s: %s\n", bgImagePath, SDL_GetError());
             free_and_set_null((void **) &ctrl->bg_image_path);
@@ -658,6 +1135,12 @@ int menu_ctrl_set_style(menu_ctrl *ctrl, char *background, char *scale, char *in
         ctrl->bg_image = NULL;
     }
 
+    /*
+     * Colors are applied when drawing, the glyphs only
+     * have to be rebuilt if bump mapping is switched
+     */
+    int rebuild_glyphs = ctrl->font_bumpmap != font_bumpmap;
+
     ctrl->font_bumpmap = font_bumpmap;
     ctrl->shadow_offset = shadow_offset;
     ctrl->shadow_alpha = shadow_alpha;
@@ -670,8 +1153,10 @@ int menu_ctrl_set_style(menu_ctrl *ctrl, char *background, char *scale, char *in
     html_print_color("Selected", ctrl->selected_color);
     html_print_color("Activated", ctrl->activated_color);
 
-    for (int r = 0; r < ctrl->n_roots; r++) {
-        menu_rebuild_glyphs(ctrl->root[r]);
+    if (rebuild_glyphs) {
+        for (int r = 0; r < ctrl->n_roots; r++) {
+            menu_invalidate_glyphs(ctrl->root[r]);
+        }
     }
 
     //    int draw_res = menu_ctrl_draw(ctrl);
@@ -714,32 +1199,57 @@ int menu_ctrl_apply_theme(menu_ctrl *ctrl, theme *theme) {
 
 void menu_ctrl_set_light(
     menu_ctrl *ctrl, double light_x, double light_y, double radius, double alpha) {
-    if (ctrl->light_texture) {
-        SDL_DestroyTexture(ctrl->light_texture);
+    if (ctrl->light_surface) {
+        SDL_FreeSurface(ctrl->light_surface);
     }
     ctrl->light_x = light_x;
     ctrl->light_y = light_y;
 
-    ctrl->light_texture = new_light_texture(ctrl->renderer, ctrl->w, ctrl->h, light_x, light_y, radius, alpha);
+    ctrl->light_surface = new_light_surface(ctrl->w, ctrl->h, light_x, light_y, radius, alpha);
+    ctrl->light_blend = SDL_BLENDMODE_MUL;
+    ctrl->overlay_dirty = 1;
 
     for (int r = 0; r < ctrl->n_roots; r++) {
-        menu_rebuild_glyphs(ctrl->root[r]);
+        menu_invalidate_glyphs(ctrl->root[r]);
     }
 
     menu_ctrl_draw(ctrl);
 }
 
 void menu_ctrl_set_light_img(menu_ctrl *ctrl, const char *path, int x, int y) {
-    if (ctrl->light_texture) {
-        SDL_DestroyTexture(ctrl->light_texture);
+    if (ctrl->light_surface) {
+        SDL_FreeSurface(ctrl->light_surface);
+        ctrl->light_surface = NULL;
     }
 
     ctrl->light_img_x = x;
     ctrl->light_img_y = y;
-    ctrl->light_texture = IMG_LoadTexture(ctrl->renderer, path);
+    ctrl->overlay_dirty = 1;
+
+    SDL_Surface *image = asset_cache_load_surface(path);
+    if (!image) {
+        log_error(MENU_CTX, "Could not load light image %s: %s\n", path, IMG_GetError());
+        return;
+    }
+
+    /* Like IMG_LoadTexture: blended, if the image has transparency */
+    Uint32 key;
+    int transparent = SDL_ISPIXELFORMAT_ALPHA(image->format->format) || SDL_GetColorKey(image, &key) == 0;
+    ctrl->light_blend = transparent ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE;
+    ctrl->light_surface = SDL_ConvertSurfaceFormat(image, DEFAULT_SDL_PIXELFORMAT, 0);
+    asset_cache_release_surface(image);
 
 }
 
+void menu_ctrl_set_turn_acceleration(menu_ctrl *ctrl, const int acceleration) {
+    ctrl->turn_acceleration = acceleration;
+    if (ctrl->turn_acceleration < 0) {
+        ctrl->turn_acceleration = 0;
+    } else if (ctrl->turn_acceleration > 10) {
+        ctrl->turn_acceleration = 10;
+    }
+}
+
 void menu_ctrl_set_warp_speed(menu_ctrl *ctrl, const int warp_speed) {
     ctrl->warp_speed = warp_speed;
     if (ctrl->warp_speed < 0) {
@@ -751,6 +1261,82 @@ void menu_ctrl_set_warp_speed(menu_ctrl *ctrl, const int warp_speed) {
     }
 }
 
+/**
+ * Decoded images nobody shows anymore are kept up to size_kb, so
+ * switching back to them doesn't decode them again
+ **/
+void menu_ctrl_set_asset_cache(menu_ctrl *ctrl, int size_kb) {
+    (void) ctrl;
+    asset_cache_set_budget(size_kb > 0 ? (size_t) size_kb * 1024 : 0);
+}
+
+/**
+ * Per pixel bump mapping caches lit glyphs every angle_step degrees,
+ * using up to size_kb of texture memory (0 disables the cache)
+ **/
+void menu_ctrl_set_bumpmap_cache(menu_ctrl *ctrl, int angle_step, int size_kb) {
+    glyph_obj_set_bumpmap_cache(angle_step, size_kb > 0 ? (size_t) size_kb * 1024 : 0);
+    if (ctrl->current) {
+        ctrl->current->dirty = 1;
+    }
+}
+
+/**
+ * Arc labels compose each label line once and draw it with a single
+ * rotated copy. Lines with bump mapping or animated icons are still
+ * drawn glyph by glyph.
+ **/
+void menu_ctrl_set_arc_labels(menu_ctrl *ctrl, int arc_labels) {
+    ctrl->arc_labels = arc_labels;
+    if (ctrl->current) {
+        ctrl->current->dirty = 1;
+    }
+}
+
+/**
+ * While idle the loop sleeps until the next event, a wakeup or the next
+ * call of the call back, which is called every interval_ms
+ **/
+void menu_ctrl_set_callback_interval(menu_ctrl *ctrl, int interval_ms) {
+    ctrl->callback_interval = interval_ms > 0 ? interval_ms : CALLBACK_INTERVAL_DEFAULT;
+}
+
+/**
+ * Wakes menu_ctrl_loop, which then calls the call back. May be called
+ * from any thread, wakeups are coalesced until the loop has seen them.
+ **/
+void menu_ctrl_wakeup(menu_ctrl *ctrl) {
+    if (!ctrl || ctrl->wakeup_event == (Uint32) -1) {
+        return;
+    }
+
+    if (SDL_AtomicCAS(&ctrl->wakeup_pending, 0, 1)) {
+        SDL_Event e;
+        SDL_zero(e);
+        e.type = ctrl->wakeup_event;
+        if (SDL_PushEvent(&e) != 1) {
+            log_warning(MENU_CTX, "Failed to push wakeup event: %s\n", SDL_GetError());
+            SDL_AtomicSet(&ctrl->wakeup_pending, 0);
+        }
+    }
+}
+
+#ifdef RASPBERRY
+static void menu_ctrl_encoder_notify(void *data) {
+    menu_ctrl_wakeup((menu_ctrl *) data);
+}
+#endif
+
+/**
+ * Records how long each phase of a frame takes and logs percentiles
+ * every dump_seconds (0 disables it). SIGUSR1 enables the profiler or
+ * logs a report at any time.
+ **/
+void menu_ctrl_set_frame_profiler(menu_ctrl *ctrl, int dump_seconds) {
+    (void) ctrl;
+    frame_profiler_enable(dump_seconds > 0, dump_seconds);
+}
+
 void menu_ctrl_set_sdl_event_callback(menu_ctrl *ctrl, menu_sdl_event_callback *callback) {
     ctrl->sdl_event_callback = callback;
 }
@@ -802,7 +1388,16 @@ menu_ctrl *menu_ctrl_new(int w, int h, int x_offset, int y_offset, int radius_la
     ctrl->n_o_items_on_scale = 4;
     ctrl->segments_per_item = 3;
     ctrl->light_texture = NULL;
+    ctrl->overlay_dirty = 1;
     ctrl->warp_speed = 10;
+    ctrl->turn_acceleration = 5;
+    ctrl->turn_pending = 0;
+    ctrl->turn_direction = 0;
+    ctrl->turn_velocity = 0;
+    ctrl->turn_last_ticks = 0;
+    ctrl->item_epoch = 1;
+    ctrl->wakeup_event = (Uint32) -1;
+    ctrl->callback_interval = CALLBACK_INTERVAL_DEFAULT;
 
     ctrl->w = w;
     ctrl->h = h > 0 ? h : to_int(0.65 * w);
@@ -844,6 +1439,11 @@ menu_ctrl *menu_ctrl_new(int w, int h, int x_offset, int y_offset, int radius_la
         return 0;
     }
 
+    ctrl->wakeup_event = SDL_RegisterEvents(1);
+    if (ctrl->wakeup_event == (Uint32) -1) {
+        log_warning(MENU_CTX, "Failed to register wakeup event, falling back to polling\n");
+    }
+
     if (font) {
         log_config(MENU_CTX, "Trying to open font %s\n", font);
         ctrl->font = my_OpenTTF_Font(font, font_size);
@@ -940,6 +1540,16 @@ menu_ctrl *menu_ctrl_new(int w, int h, int x_offset, int y_offset, int radius_la
              (rendererInfo.flags & SDL_RENDERER_PRESENTVSYNC) != 0,
              (rendererInfo.flags & SDL_RENDERER_TARGETTEXTURE) != 0);
 
+    ctrl->glyph_atlas = glyph_atlas_new(ctrl->renderer);
+    asset_cache_init(ASSET_CACHE_DEFAULT_BYTES);
+
+    int n_raster_threads = SDL_GetCPUCount() - 1;
+    if (n_raster_threads > RASTER_THREADS_MAX) {
+        n_raster_threads = RASTER_THREADS_MAX;
+    }
+    ctrl->raster_pool = raster_pool_new(n_raster_threads > 0 ? n_raster_threads : 1);
+    ctrl->glyphs_pending = 0;
+
 #ifdef RASPBERRY
     menu_ctrl_set_style (ctrl, "#08081e", "#c8c8c8", "#ff0000", "#525239", "#c8c864", "#c8c864", 0, 1, 0, 0, 0, NULL, 0, NULL, 0);
 #else
@@ -957,25 +1567,83 @@ menu_ctrl *menu_ctrl_new(int w, int h, int x_offset, int y_offset, int radius_la
     return ctrl;
 }
 
+/**
+ * Applies the turn ticks queued while processing the events of a frame
+ * as one move, followed by a single TURN_LEFT or TURN_RIGHT. Ticks of a
+ * fast spin turn more than one segment each, depending on
+ * turn_acceleration. Returns 1, if the menu was turned.
+ **/
+static int menu_ctrl_flush_turns(menu_ctrl *ctrl) {
+    int ticks = ctrl->turn_pending;
+    ctrl->turn_pending = 0;
+    if (ticks == 0 || !ctrl->current) {
+        return 0;
+    }
+
+    Uint32 now = SDL_GetTicks();
+    Uint32 elapsed = now - ctrl->turn_last_ticks;
+    int direction = ticks > 0 ? 1 : -1;
+
+    if (elapsed > TURN_SPIN_PAUSE_MS || direction != ctrl->turn_direction) {
+        ctrl->turn_velocity = 0;
+    } else {
+        double velocity = abs(ticks) * 1000.0 / (elapsed > 0 ? elapsed : 1);
+        ctrl->turn_velocity = ctrl->turn_velocity > 0 ? 0.5 * (ctrl->turn_velocity + velocity) : velocity;
+    }
+    ctrl->turn_last_ticks = now;
+    ctrl->turn_direction = direction;
+
+    double factor = 1.0;
+    if (ctrl->turn_acceleration > 0 && ctrl->turn_velocity > TURN_ACCEL_TICKS_PER_SECOND) {
+        factor = 1.0 + 0.5 * ctrl->turn_acceleration * (ctrl->turn_velocity / TURN_ACCEL_TICKS_PER_SECOND - 1.0);
+        if (factor > TURN_ACCEL_MAX_FACTOR) {
+            factor = TURN_ACCEL_MAX_FACTOR;
+        }
+    }
+
+    int segments = to_int(abs(ticks) * factor);
+    log_debug(MENU_CTX, "Turning %d segments for %d ticks at %.1f ticks/s\n", direction * segments, ticks, ctrl->turn_velocity);
+    __menu_turn_by(ctrl->current, direction * segments);
+    menu_action(direction > 0 ? TURN_RIGHT : TURN_LEFT, ctrl, ctrl->current);
+
+    return 1;
+}
+
+static int menu_ctrl_is_turn_event(const SDL_Event *e) {
+    if (e->type == SDL_MOUSEWHEEL) {
+        return 1;
+    }
+    if (e->type == SDL_MOUSEBUTTONUP) {
+        return e->button.state == SDL_RELEASED && (e->button.button == 4 || e->button.button == 5);
+    }
+    return 0;
+}
+
 int menu_ctrl_process_events(menu_ctrl *ctrl) {
     int redraw = 0;
 
 #ifdef RASPBERRY
     int he = next_event ();
+    if (he) {
+        /* Input applies to where running animations would end */
+        menu_animation_queue_skip(&ctrl->animations);
+    }
     while (he) {
         ctrl->warping = 1;
         log_config (MENU_CTX, "Event: %d\n", he);
+        if (he != BUTTON_A_TURNED_LEFT && he != BUTTON_A_TURNED_RIGHT) {
+            /* Other events see the position of the turns before them */
+            menu_ctrl_flush_turns(ctrl);
+        }
         if (he == BUTTON_A_TURNED_LEFT) {
-            __menu_turn_left (ctrl->current, 0);
-            menu_action (TURN_LEFT, ctrl, ctrl->current);
+            ctrl->turn_pending--;
             redraw = 1;
         } else if (he == BUTTON_A_TURNED_RIGHT) {
-            __menu_turn_right (ctrl->current, 0);
-            menu_action (TURN_RIGHT, ctrl, ctrl->current);
+            ctrl->turn_pending++;
             redraw = 1;
         } else if (he == BUTTON_A_PRESSED) {
-            if (ctrl->current && ctrl->current->current_id >= 0 && ctrl->current->item) {
-                menu_item *item = ctrl->current->item[ctrl->current->current_id];
+            if (ctrl->current && ctrl->current->current_id >= 0 && ctrl->current->max_id >= 0) {
+                menu_item *item = menu_get_item(ctrl->current, ctrl->current->current_id);
                 menu_item_action (ACTIVATE, ctrl, item);
                 redraw = 1;
             } else {
@@ -990,8 +1658,8 @@ int menu_ctrl_process_events(menu_ctrl *ctrl) {
         } else if (he == BUTTON_B_TURNED_RIGHT) {
             menu_action(TURN_RIGHT_1, ctrl, ctrl->current);
         } else if (he == BUTTON_B_PRESSED) {
-            if (ctrl->current && ctrl->current->current_id >= 0 && ctrl->current->item) {
-                menu_item *item = ctrl->current->item[ctrl->current->current_id];
+            if (ctrl->current && ctrl->current->current_id >= 0 && ctrl->current->max_id >= 0) {
+                menu_item *item = menu_get_item(ctrl->current, ctrl->current->current_id);
                 menu_item_action (ACTIVATE_1, ctrl, item);
                 redraw = 1;
             } else {
@@ -1009,15 +1677,28 @@ int menu_ctrl_process_events(menu_ctrl *ctrl) {
 
         while (SDL_PollEvent(&e)) {
             log_debug(MENU_CTX, "Caught event %03x\n", e.type);
-            if (e.type == SDL_QUIT) {
+            if (e.type == ctrl->wakeup_event) {
+                SDL_AtomicSet(&ctrl->wakeup_pending, 0);
+                ctrl->woken = 1;
+                continue;
+            } else if (e.type == SDL_QUIT) {
                 return -1;
-            } else if (e.type == SDL_MOUSEBUTTONUP) {
+            }
+
+            if (e.type == SDL_MOUSEBUTTONUP || e.type == SDL_MOUSEWHEEL || e.type == SDL_KEYUP) {
+                menu_animation_queue_skip(&ctrl->animations);
+            }
+
+            if (!menu_ctrl_is_turn_event(&e)) {
+                menu_ctrl_flush_turns(ctrl);
+            }
+
+            if (e.type == SDL_MOUSEBUTTONUP) {
                 SDL_MouseButtonEvent *b = (SDL_MouseButtonEvent *) &e;
                 if (b->state == SDL_RELEASED) {
                     if (b->button == 1) {
                         if (ctrl->current->current_id >= 0) {
-                            menu_item *item =
-                                ctrl->current->item[ctrl->current->current_id];
+                            menu_item *item = menu_get_current_item(ctrl->current);
                             menu_item_action(ACTIVATE, ctrl, item);
                             redraw = 1;
                         } else {
@@ -1027,24 +1708,18 @@ int menu_ctrl_process_events(menu_ctrl *ctrl) {
                         menu_action(HOLD, ctrl, ctrl->current);
                         redraw = 1;
                     } else if (b->button == 4) {
-                        __menu_turn_left(ctrl->current,0);
-                        menu_action(TURN_LEFT, ctrl, ctrl->current);
+                        ctrl->turn_pending--;
                         redraw = 1;
                     } else if (b->button == 5) {
-                        __menu_turn_right(ctrl->current,0);
-                        menu_action(TURN_RIGHT, ctrl, ctrl->current);
+                        ctrl->turn_pending++;
                         redraw = 1;
                     }
                 }
             } else if (e.type == SDL_MOUSEWHEEL) {
                 SDL_MouseWheelEvent *w = (SDL_MouseWheelEvent *) &e;
-                if (w->y > 0) {
-                    __menu_turn_left(ctrl->current,0);
-                    menu_action(TURN_LEFT, ctrl, ctrl->current);
-                    redraw = 1;
-                } else if (w->y < 0) {
-                    __menu_turn_right(ctrl->current,0);
-                    menu_action(TURN_RIGHT, ctrl, ctrl->current);
+                if (w->y != 0) {
+                    /* Up turns left */
+                    ctrl->turn_pending -= w->y;
                     redraw = 1;
                 }
             } else if (e.type == SDL_KEYUP) {
@@ -1063,6 +1738,8 @@ int menu_ctrl_process_events(menu_ctrl *ctrl) {
             }
         }
 
+        menu_ctrl_flush_turns(ctrl);
+
         return redraw;
 }
 
@@ -1070,6 +1747,9 @@ void menu_ctrl_free(menu_ctrl *ctrl) {
     if (ctrl) {
         log_info(MENU_CTX, "Freeing menu ctrl %p\n", ctrl);
 
+        menu_animation_queue_clear(&ctrl->animations);
+        ctrl->fade_from = NULL;
+
 #ifdef MENU_WEB
         menu_web_free(ctrl->web);
         ctrl->web = NULL;
@@ -1098,6 +1778,47 @@ void menu_ctrl_free(menu_ctrl *ctrl) {
             ctrl->root = NULL;
         }
 
+        /* The menus have cancelled their jobs, the fonts may go after this */
+        raster_pool_free(ctrl->raster_pool);
+        ctrl->raster_pool = NULL;
+
+        glyph_atlas_free(ctrl->glyph_atlas);
+        ctrl->glyph_atlas = NULL;
+
+        if (ctrl->scale_texture) {
+            SDL_DestroyTexture(ctrl->scale_texture);
+            ctrl->scale_texture = NULL;
+        }
+
+        if (ctrl->snapshot) {
+            SDL_DestroyTexture(ctrl->snapshot);
+            ctrl->snapshot = NULL;
+        }
+        ctrl->snapshot_menu = NULL;
+
+        if (ctrl->overlay) {
+            SDL_DestroyTexture(ctrl->overlay);
+            ctrl->overlay = NULL;
+        }
+
+        if (ctrl->light_texture) {
+            SDL_DestroyTexture(ctrl->light_texture);
+            ctrl->light_texture = NULL;
+        }
+
+        if (ctrl->light_surface) {
+            SDL_FreeSurface(ctrl->light_surface);
+            ctrl->light_surface = NULL;
+        }
+
+        if (ctrl->bg_image) {
+            asset_cache_release_texture(ctrl->bg_image);
+            ctrl->bg_image = NULL;
+        }
+
+        /* The menus and glyphs are gone, nobody uses the images anymore */
+        asset_cache_free();
+
         if (ctrl->renderer) {
             SDL_DestroyRenderer(ctrl->renderer);
             ctrl->renderer = NULL;
@@ -1109,11 +1830,11 @@ void menu_ctrl_free(menu_ctrl *ctrl) {
         }
 
         if (ctrl->font) {
-            TTF_CloseFont(ctrl->font);
+            my_CloseTTF_Font(ctrl->font);
         }
 
         if (ctrl->font2) {
-            TTF_CloseFont(ctrl->font2);
+            my_CloseTTF_Font(ctrl->font2);
         }
 
         free_and_set_null((void **) &ctrl->font_path);
@@ -1136,7 +1857,9 @@ void menu_ctrl_quit(menu_ctrl *ctrl) {
 
 int menu_ctrl_loop(menu_ctrl *ctrl) {
     log_info(MENU_CTX, "START: menu_ctrl_loop\n");
+    frame_profiler_install_signal();
 #ifdef RASPBERRY
+    set_encoder_notify(menu_ctrl_encoder_notify, ctrl);
     setup_encoder ();
 #endif
 
@@ -1144,22 +1867,74 @@ int menu_ctrl_loop(menu_ctrl *ctrl) {
 
     SDL_ShowWindow(ctrl->display);
 
+    Uint32 next_call_back = SDL_GetTicks();
+
     while (1) {
+        if (++ctrl->item_epoch == 0) {
+            ctrl->item_epoch = 1;
+        }
         int res = menu_ctrl_process_events(ctrl);
 #ifdef MENU_WEB
         menu_web_poll(ctrl->web, 0);
 #endif
         log_trace(MENU_CTX, "events result: %d\n", res);
+        frame_profiler_poll();
         if (res == -1) {
             break;
-        } else if (res == 0) {
+        } else if (res == 0 && (ctrl->woken || SDL_TICKS_PASSED(SDL_GetTicks(), next_call_back))) {
+            ctrl->woken = 0;
             if (ctrl->call_back) {
+                Uint64 call_back_start = frame_profiler_now();
                 ctrl->call_back(ctrl);
+                frame_profiler_record(FRAME_PHASE_CALLBACK, call_back_start);
+            }
+            next_call_back = SDL_GetTicks() + ctrl->callback_interval;
+        }
+
+        Uint32 frame_start = SDL_GetTicks();
+        if (ctrl->animation_due && SDL_TICKS_PASSED(frame_start, ctrl->animation_due)) {
+            ctrl->animation_due = 0;
+            if (ctrl->current) {
+                ctrl->current->dirty = 1;
             }
-            SDL_Delay(20);
         }
-        menu_ctrl_draw(ctrl);
+        int animating = menu_ctrl_animate(ctrl);
+        Uint32 animation_due = glyph_obj_take_animation_due();
+        if (animation_due) {
+            ctrl->animation_due = animation_due;
+        }
+
+        if (res == 0) {
+            /* Without a wakeup event nobody can wake us, keep polling */
+            int timeout = ctrl->wakeup_event == (Uint32) -1 ? 20 : ctrl->callback_interval;
+            Uint32 now = SDL_GetTicks();
+            if (animating) {
+                Uint32 frame_passed = now - frame_start;
+                timeout = frame_passed < MENU_ANIMATION_FRAME_MS ? MENU_ANIMATION_FRAME_MS - frame_passed : 0;
+            }
+            if (SDL_TICKS_PASSED(now, next_call_back)) {
+                timeout = 0;
+            } else if ((Sint32) (next_call_back - now) < timeout) {
+                timeout = next_call_back - now;
+            }
+            if (ctrl->animation_due) {
+                if (SDL_TICKS_PASSED(now, ctrl->animation_due)) {
+                    timeout = 0;
+                } else if ((Sint32) (ctrl->animation_due - now) < timeout) {
+                    timeout = ctrl->animation_due - now;
+                }
+            }
+#ifdef MENU_WEB
+            if (ctrl->web && timeout > MENU_WEB_POLL_INTERVAL_MS) {
+                timeout = MENU_WEB_POLL_INTERVAL_MS;
+            }
+#endif
+            SDL_WaitEventTimeout(NULL, timeout);
+        }
     }
+#ifdef RASPBERRY
+    set_encoder_notify(NULL, NULL);
+#endif
     log_info(MENU_CTX, "END: menu_ctrl_loop\n");
     return 0;
 }
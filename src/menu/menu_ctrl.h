@@ -56,7 +56,7 @@ typedef struct theme
     int bg_cp_colors;
     char **fg_color_palette;
     int fg_cp_colors;
-    int font_bumpmap;
+    int font_bumpmap; /* 0 = off, 1 = per pixel, 2 = linear (cheap, needs custom blend modes) */
     int shadow_offset;
     u_int8_t shadow_alpha;
 } theme;
@@ -90,6 +90,22 @@ void menu_ctrl_set_radii(menu_ctrl *ctrl,
                          int radius_scales_start,
                          int radius_scales_end);
 int menu_ctrl_apply_theme(menu_ctrl *ctrl, theme *theme);
+int menu_ctrl_set_style(menu_ctrl *ctrl,
+                        char *background,
+                        char *scale,
+                        char *indicator,
+                        char *def,
+                        char *selected,
+                        char *activated,
+                        char *bgImagePath,
+                        int draw_scales,
+                        int font_bumpmap,
+                        int shadow_offset,
+                        Uint8 shadow_alpha,
+                        char **bg_color_palette,
+                        int bg_cp_colors,
+                        char **fg_color_palette,
+                        int fg_cp_colors);
 int menu_ctrl_set_bg_color_rgb(menu_ctrl *ctrl, u_int8_t r, u_int8_t g, u_int8_t b);
 int menu_ctrl_set_default_color_rgb(menu_ctrl *ctrl, u_int8_t r, u_int8_t g, u_int8_t b);
 int menu_ctrl_set_active_color_rgb(menu_ctrl *ctrl, u_int8_t r, u_int8_t g, u_int8_t b);
@@ -100,8 +116,17 @@ void menu_ctrl_set_light_img(menu_ctrl *ctrl, const char *path, int x, int y);
 void menu_ctrl_set_offset(menu_ctrl *ctrl, int x_offset, int y_offset);
 void menu_ctrl_set_angle_offset(menu_ctrl *ctrl, double a);
 void menu_ctrl_set_warp_speed(menu_ctrl *ctrl, int warp_speed);
+void menu_ctrl_set_turn_acceleration(menu_ctrl *ctrl, int acceleration);
+void menu_ctrl_set_bumpmap_cache(menu_ctrl *ctrl, int angle_step, int size_kb);
+void menu_ctrl_set_asset_cache(menu_ctrl *ctrl, int size_kb);
+void menu_ctrl_set_arc_labels(menu_ctrl *ctrl, int arc_labels);
+void menu_ctrl_set_callback_interval(menu_ctrl *ctrl, int interval_ms);
+void menu_ctrl_set_frame_profiler(menu_ctrl *ctrl, int dump_seconds);
+void menu_ctrl_wakeup(menu_ctrl *ctrl);
 void menu_ctrl_set_active(menu_ctrl *ctrl, menu *active);
 int menu_ctrl_draw(menu_ctrl *ctrl);
+int menu_ctrl_animate(menu_ctrl *ctrl);
+void menu_ctrl_finish_animations(menu_ctrl *ctrl);
 item_action *menu_ctrl_get_item_action(menu_ctrl *ctrl);
 void hsv_to_rgb(double h, double s, double v, u_int8_t *r, u_int8_t *g, u_int8_t *b);
 void color_temp_to_rgb(double temp, u_int8_t *r, u_int8_t *g, u_int8_t *b, double value);
@@ -28,6 +28,10 @@ extern "C" {
 
 #include <SDL2/SDL_ttf.h>
 
+#include "glyph_atlas.h"
+#include "menu_animation.h"
+#include "raster_pool.h"
+
 #ifdef MENU_WEB
 #include "web/menu_web.h"
 #endif
@@ -47,6 +51,11 @@ struct menu_ctrl {
     menu *current_transient;
     menu *active;
     int warp_speed; // 0-10
+    int turn_acceleration; /* 0-10, how much fast spins speed the dial up, 0 turns one segment per tick */
+    int turn_pending; /* Turn ticks of this frame not applied yet, right is positive */
+    int turn_direction; /* Of the current spin */
+    double turn_velocity; /* Smoothed ticks per second of the current spin */
+    Uint32 turn_last_ticks; /* When the last ticks were applied */
     double offset;
     int no_of_scales;
     int segments_per_item; /* The number of segments left and right that belong to a menu item */
@@ -70,6 +79,7 @@ struct menu_ctrl {
     SDL_Color *indicator_color_light; /* The color of the vertical indicator line */
     SDL_Color *indicator_color_dark; /* The color of the vertical indicator line */
     int font_bumpmap; /* Apply bumpmap effect to font */
+    int arc_labels; /* Draw each label line as one pre-rendered texture */
     int shadow_offset; /* The offset of the drop shadow (0 -> no shadow) */
     Uint8 shadow_alpha; /* The alpha of the drop shadow */
     Uint8 indicator_alpha;
@@ -78,15 +88,42 @@ struct menu_ctrl {
     unsigned int style_version;
     double bg_segment;
     theme *theme;
-    SDL_Texture *light_texture;
+    SDL_Texture *light_texture; /* Only used, if the light can't be folded into the overlay */
+    SDL_Surface *light_surface;
+    SDL_BlendMode light_blend; /* How the light is applied to the screen */
     int light_img_x;
     int light_img_y;
+    SDL_Texture *overlay; /* Indicator and light, see menu_ctrl_draw_overlay */
+    SDL_Rect overlay_rect;
+    int overlay_dirty;
+    int overlay_failed;
     menu_callback *call_back;
     item_action *action;
     int warping;
+    menu_animation_queue animations; /* Fades and warps, run by menu_ctrl_loop */
+    menu *fade_from; /* The menu fading out while current fades in */
     SDL_Window *display;
     SDL_Renderer *renderer;
+    glyph_atlas *glyph_atlas; /* Shared by all labels, owned by the ctrl */
+    raster_pool *raster_pool; /* Renders labels off the render thread, NULL to render them in place */
+    int glyphs_pending; /* The last frame missed labels that are still being rendered */
+    Uint32 animation_due; /* When the next frame of an animated icon is due, 0 if none is shown */
+    Uint32 item_epoch; /* Advanced by each round of menu_ctrl_loop, items of virtual menus handed out before may be rebound */
+    SDL_Texture *scale_texture; /* The scale ring at angle 0, see menu_draw_scales */
+    int scale_texture_valid;
+    SDL_Texture *snapshot; /* The last frame of snapshot_menu, drawn under overlay menus */
+    menu *snapshot_menu;
+    int snapshot_failed;
+    int scale_texture_r; /* The key of scale_texture */
+    int scale_texture_R;
+    int scale_texture_n;
+    SDL_Color scale_texture_color;
+    unsigned int scale_texture_version;
     int loop;
+    Uint32 wakeup_event; /* Pushed by menu_ctrl_wakeup, (Uint32) -1 if none could be registered */
+    SDL_atomic_t wakeup_pending; /* Set while a wakeup event is queued */
+    int woken; /* A wakeup event was seen since the last call_back */
+    int callback_interval; /* Milliseconds between two calls of call_back while idle */
     /**
      * User data
     **/
@@ -100,6 +137,8 @@ struct menu_ctrl {
 void menu_ctrl_draw_indicator(menu_ctrl *ctrl, double xc, double yc, double angle);
 int menu_ctrl_clear(menu_ctrl *ctrl, double angle, SDL_Color *background_color, SDL_Texture *bg_image);
 void menu_ctrl_apply_light(menu_ctrl *ctrl);
+void menu_ctrl_draw_overlay(menu_ctrl *ctrl);
+void menu_ctrl_forget_menu(menu_ctrl *ctrl, menu *m);
 #ifdef __cplusplus
 }
 #endif
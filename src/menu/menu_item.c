@@ -50,12 +50,6 @@ void menu_item_action(menu_event evt, menu_ctrl *ctrl, menu_item *item) {
     }
 }
 
-void menu_item_update_cnt_rad(menu_item *item, SDL_Point center, int radius) {
-    text_obj_update_cnt_rad(item->label_default, center, radius, item->line, item->menu->n_o_lines);
-    text_obj_update_cnt_rad(item->label_active, center, radius, item->line, item->menu->n_o_lines);
-    text_obj_update_cnt_rad(item->label_current, center, radius, item->line, item->menu->n_o_lines);
-}
-
 int menu_item_draw(menu_item *item, menu_item_state st, double angle) {
 
     if (!item->visible) {
@@ -69,17 +63,19 @@ int menu_item_draw(menu_item *item, menu_item_state st, double angle) {
               st,
               angle);
 
-    text_obj *label = item->label_default;
+    menu *m = item->menu;
+    SDL_Color color = m->default_color != NULL ? *m->default_color : *m->ctrl->default_color;
     if (st == ACTIVE) {
-        label = item->label_active;
+        color = m->default_color != NULL ? *m->default_color : *m->ctrl->activated_color;
     } else if (st == SELECTED) {
-        label = item->label_current;
+        color = m->selected_color != NULL ? *m->selected_color : *m->ctrl->selected_color;
     }
 
-    if (label) {
+    if (item->label_obj) {
         text_obj_draw(item->menu->ctrl->renderer,
                       NULL,
-                      label,
+                      item->label_obj,
+                      color,
                       item->menu->radius_labels,
                       item->menu->ctrl->center.x,
                       item->menu->ctrl->center.y,
@@ -87,6 +83,7 @@ int menu_item_draw(menu_item *item, menu_item_state st, double angle) {
                       item->menu->ctrl->light_x,
                       item->menu->ctrl->light_y,
                       item->menu->ctrl->font_bumpmap,
+                      item->menu->ctrl->arc_labels,
                       item->menu->ctrl->shadow_offset,
                       item->menu->ctrl->shadow_alpha);
     } else {
@@ -198,115 +195,231 @@ void *menu_item_get_object(menu_item *item) {
     return (void *) item->user_data;
 }
 
-void menu_item_rebuild_glyphs(menu_item *item) {
-
-    menu *m = item->menu;
-
-    if (item->label_default) {
-        text_obj_free(item->label_default);
-        item->label_default = NULL;
+/**
+ * Marks the rendered label as outdated. It is still drawn until the new
+ * one is ready.
+ **/
+void menu_item_invalidate_glyphs(menu_item *item) {
+    if (item->raster_job) {
+        raster_job_cancel(item->raster_job);
+        item->raster_job = NULL;
     }
+    item->glyphs_valid = 0;
+}
 
-    if (item->label_current) {
-        text_obj_free(item->label_current);
-        item->label_current = NULL;
+/**
+ * Drops the rendered label, it is built again when the item comes close
+ * to the selected item
+ **/
+void menu_item_release_glyphs(menu_item *item) {
+    menu_item_invalidate_glyphs(item);
+    if (item->label_obj) {
+        text_obj_free(item->label_obj);
+        item->label_obj = NULL;
     }
+}
 
-    if (item->label_active) {
-        text_obj_free(item->label_active);
-        item->label_active = NULL;
-    }
+/**
+ * The fonts of the label, returns 0 if there is text but no font
+ **/
+static int menu_item_get_fonts(menu_item *item, TTF_Font **font, TTF_Font **font2) {
+    menu *m = item->menu;
 
-    TTF_Font *font = item->font;
-    if (!font) {
-        font = m->font;
+    *font = item->font;
+    if (!*font) {
+        *font = m->font;
     }
-    if (!font) {
-        font = m->ctrl->font;
+    if (!*font) {
+        *font = m->ctrl->font;
     }
 
-    TTF_Font *font2 = item->font2;
-    if (!font2) {
-        font2 = m->font2;
+    *font2 = item->font2;
+    if (!*font2) {
+        *font2 = m->font2;
     }
-    if (!font2) {
-        font2 = m->ctrl->font2;
+    if (!*font2) {
+        *font2 = m->ctrl->font2;
     }
-    if (!font2) {
-        font2 = font;
+    if (!*font2) {
+        *font2 = *font;
     }
 
-    if (!font && item->label && item->label[0] != '\0') {
+    if (!*font && item->label && item->label[0] != '\0') {
         log_error(MENU_CTX,
                   "Skipping glyph rebuild for label [%s]: no font available\n",
                   item->label);
+        return 0;
+    }
+
+    return 1;
+}
+
+static void menu_item_set_label_obj(menu_item *item, text_obj *label_obj) {
+    if (item->label_obj) {
+        text_obj_free(item->label_obj);
+    }
+    item->label_obj = label_obj;
+    item->glyphs_valid = 1;
+}
+
+/**
+ * Renders the label unless it is up to date already
+ **/
+void menu_item_build_glyphs(menu_item *item) {
+
+    if (item->glyphs_valid) {
+        return;
+    }
+
+    menu *m = item->menu;
+    TTF_Font *font, *font2;
+
+    menu_item_invalidate_glyphs(item);
+
+    if (!menu_item_get_fonts(item, &font, &font2)) {
+        menu_item_set_label_obj(item, NULL);
         return;
     }
 
     SDL_Renderer *renderer = m->ctrl->renderer;
 
     if (renderer) {
-        text_obj *label_default = text_obj_new(renderer,
-                                               item->label,
-                                               item->icon,
-                                               font,
-                                               font2,
-                                               m->default_color != NULL ? *m->default_color
-                                                                        : *m->ctrl->default_color,
-                                               m->ctrl->center,
-                                               m->ctrl->radius_labels,
-                                               item->line,
-                                               m->n_o_lines,
-                                               item->menu->ctrl->light_x,
-                                               item->menu->ctrl->light_y,
-                                               item->menu->ctrl->font_bumpmap);
-        text_obj *label_current = text_obj_new(renderer,
-                                               item->label,
-                                               item->icon,
-                                               font,
-                                               font2,
-                                               m->selected_color != NULL ? *m->selected_color
-                                                                         : *m->ctrl->selected_color,
-                                               m->ctrl->center,
-                                               m->ctrl->radius_labels,
-                                               item->line,
-                                               m->n_o_lines,
-                                               item->menu->ctrl->light_x,
-                                               item->menu->ctrl->light_y,
-                                               item->menu->ctrl->font_bumpmap);
-        text_obj *label_active = text_obj_new(renderer,
-                                              item->label,
-                                              item->icon,
-                                              font,
-                                              font2,
-                                              m->default_color != NULL ? *m->default_color
-                                                                       : *m->ctrl->activated_color,
-                                              m->ctrl->center,
-                                              m->ctrl->radius_labels,
-                                              item->line,
-                                              m->n_o_lines,
-                                              item->menu->ctrl->light_x,
-                                              item->menu->ctrl->light_y,
-                                              item->menu->ctrl->font_bumpmap);
-
-        text_obj *label_default_old = item->label_default;
-        text_obj *label_current_old = item->label_current;
-        text_obj *label_active_old = item->label_active;
-
-        item->label_default = label_default;
-        item->label_current = label_current;
-        item->label_active = label_active;
-
-        if (label_default_old) {
-            text_obj_free(label_default_old);
+        menu_item_set_label_obj(item,
+                                text_obj_new(renderer,
+                                             m->ctrl->glyph_atlas,
+                                             item->label,
+                                             item->icon,
+                                             font,
+                                             font2,
+                                             m->ctrl->center,
+                                             m->radius_labels,
+                                             item->line,
+                                             m->n_o_lines,
+                                             item->menu->ctrl->light_x,
+                                             item->menu->ctrl->light_y,
+                                             item->menu->ctrl->font_bumpmap));
+    } else {
+        item->glyphs_valid = 1;
+    }
+}
+
+typedef struct menu_item_raster_args {
+    char *label;
+    char *icon;
+    TTF_Font *font;
+    TTF_Font *font2;
+    int bump_map;
+} menu_item_raster_args;
+
+static void *menu_item_rasterize(void *data, raster_job *job) {
+    menu_item_raster_args *args = (menu_item_raster_args *) data;
+    return text_obj_rasterize(args->label, args->icon, args->font, args->font2, args->bump_map, job);
+}
+
+static void menu_item_free_raster_args(void *data) {
+    menu_item_raster_args *args = (menu_item_raster_args *) data;
+    free(args->label);
+    free(args->icon);
+    free(args);
+}
+
+static void menu_item_free_raster(void *raster) {
+    text_obj_raster_free((text_obj_raster *) raster);
+}
+
+/**
+ * Rasterizes the label on the calling thread, when there are no raster
+ * workers or a job could not be queued
+ **/
+static int menu_item_prepare_glyphs_now(menu_item *item, int upload) {
+    if (upload) {
+        menu_item_build_glyphs(item);
+    }
+    return item->glyphs_valid;
+}
+
+/**
+ * Brings the label up to date without blocking: queues the glyphs on a
+ * raster worker and, if upload is set, creates the textures once they
+ * are rendered. Without workers the label is built right here, if upload
+ * is set. Returns 1, if the label is up to date.
+ **/
+int menu_item_prepare_glyphs(menu_item *item, int upload) {
+    if (item->glyphs_valid) {
+        return 1;
+    }
+
+    menu *m = item->menu;
+    menu_ctrl *ctrl = m->ctrl;
+
+    if (!ctrl->raster_pool || !ctrl->renderer) {
+        return menu_item_prepare_glyphs_now(item, upload);
+    }
+
+    if (!item->raster_job) {
+        TTF_Font *font, *font2;
+        if (!menu_item_get_fonts(item, &font, &font2)) {
+            menu_item_set_label_obj(item, NULL);
+            return 1;
         }
-        if (label_current_old) {
-            text_obj_free(label_current_old);
+
+        menu_item_raster_args *args = malloc(sizeof(menu_item_raster_args));
+        if (!args) {
+            log_error(MENU_CTX, "menu_item_prepare_glyphs: malloc failed\n");
+            return menu_item_prepare_glyphs_now(item, upload);
         }
-        if (label_active_old) {
-            text_obj_free(label_active_old);
+        args->label = item->label ? my_copystr(item->label) : NULL;
+        args->icon = item->icon ? my_copystr(item->icon) : NULL;
+        args->font = font;
+        args->font2 = font2;
+        args->bump_map = ctrl->font_bumpmap;
+        item->raster_job = raster_pool_submit(ctrl->raster_pool,
+                                              menu_item_rasterize,
+                                              args,
+                                              menu_item_free_raster_args,
+                                              menu_item_free_raster);
+        if (!item->raster_job) {
+            return menu_item_prepare_glyphs_now(item, upload);
         }
+        return 0;
+    }
+
+    if (!upload || !raster_job_done(item->raster_job)) {
+        return 0;
     }
+
+    text_obj_raster *raster = (text_obj_raster *) raster_job_take(item->raster_job);
+    item->raster_job = NULL;
+
+    menu_item_set_label_obj(item,
+                            text_obj_upload(ctrl->renderer,
+                                            ctrl->glyph_atlas,
+                                            raster,
+                                            ctrl->center,
+                                            m->radius_labels,
+                                            item->line,
+                                            m->n_o_lines));
+    return 1;
+}
+
+/**
+ * Brings a label that is up to date otherwise to the new text in place.
+ * The glyphs of unchanged characters are kept, so clocks and volume
+ * labels don't create textures on every change.
+ **/
+static int menu_item_update_glyphs(menu_item *item) {
+    TTF_Font *font, *font2;
+
+    if (!item->glyphs_valid || !item->label_obj || item->icon
+        || !item->label || item->label[0] == '\0') {
+        return 0;
+    }
+
+    if (!menu_item_get_fonts(item, &font, &font2)) {
+        return 0;
+    }
+
+    return text_obj_update(item->menu->ctrl->renderer, item->label_obj, item->label, font, font2);
 }
 
 int menu_item_set_label(menu_item *item, const char *label) {
@@ -323,7 +436,9 @@ int menu_item_set_label(menu_item *item, const char *label) {
 
         item->label = my_copystr(llabel);
 
-        menu_item_rebuild_glyphs(item);
+        if (!menu_item_update_glyphs(item)) {
+            menu_item_invalidate_glyphs(item);
+        }
 
         item->menu->dirty = 1;
         ret_value = 1;
@@ -343,7 +458,7 @@ int menu_item_set_icon(menu_item *item, const char *icon) {
 
         item->icon = icon ? my_copystr(icon) : NULL;
 
-        menu_item_rebuild_glyphs(item);
+        menu_item_invalidate_glyphs(item);
 
         item->menu->dirty = 1;
         return 1;
@@ -354,8 +469,7 @@ int menu_item_set_icon(menu_item *item, const char *icon) {
 
 }
 
-menu_item *menu_item_new(menu *m, const char *label, const char *icon, const void *object, int object_type,
-                         const char *font, int font_size, item_action *action, const char *font_2nd_line, int font_size_2nd_line) {
+static menu_item *menu_item_alloc(menu *m, int id, const void *object, int object_type, item_action *action) {
 
     menu_item *item = malloc(sizeof(menu_item));
     item->unicode_label = NULL;
@@ -368,32 +482,81 @@ menu_item *menu_item_new(menu *m, const char *label, const char *icon, const voi
     item->menu = m;
     item->action = action;
     item->visible = 1;
+    item->id = id;
+    item->line = id >= 0 ? (id % m->n_o_lines) + 1 - m->n_o_lines : 0;
+    item->font = NULL;
+    item->font_path = NULL;
+    item->font_size = 0;
+    item->font2 = NULL;
+    item->font2_path = NULL;
+    item->font_size2 = 0;
+    item->num_label_chars = 0;
+    item->num_label_chars2 = 0;
+    item->label_obj = NULL;
+    item->glyphs_valid = 0;
+    item->raster_job = NULL;
+    item->key = NULL;
+
+    return item;
+
+}
+
+/**
+ * An item that is not in the item list of its menu yet, see menu_item_bind
+ **/
+menu_item *menu_item_new_unbound(menu *m, int object_type, item_action *action) {
+    return menu_item_alloc(m, -1, NULL, object_type, action);
+}
+
+/**
+ * Binds an item to the position id of its menu. The label it showed at
+ * another position is dropped at once, so it never shows up at the wrong
+ * line.
+ **/
+void menu_item_bind(menu_item *item, int id, const char *label, const char *icon, const void *object) {
+    /* Binding happens while drawing, it is no reason to draw again */
+    int dirty = item->menu->dirty;
+    int moved = item->id != id;
+    if (moved) {
+        int line = (id % item->menu->n_o_lines) + 1 - item->menu->n_o_lines;
+        if (line != item->line) {
+            menu_item_release_glyphs(item);
+        }
+        item->id = id;
+        item->line = line;
+        item->visible = 1;
+    }
+    item->user_data = object;
+    if ((menu_item_set_label(item, label) | menu_item_set_icon(item, icon)) && moved) {
+        menu_item_release_glyphs(item);
+    }
+    item->menu->dirty = dirty;
+}
+
+menu_item *menu_item_new(menu *m, const char *label, const char *icon, const void *object, int object_type,
+                         const char *font, int font_size, item_action *action, const char *font_2nd_line, int font_size_2nd_line) {
+
+    if (m->source) {
+        log_error(MENU_CTX, "menu_item_new: the entries of a virtual menu come from its data source\n");
+        return NULL;
+    }
+
     m->max_id++;
-    item->id = m->max_id;
+    menu_item *item = menu_item_alloc(m, m->max_id, object, object_type, action);
 
     if (m->current_id < 0) {
         m->current_id = 0;
     }
 
-    item->line = (item->id % m->n_o_lines) + 1 - m->n_o_lines;
-
     if (m->item) {
         m->item = realloc(m->item, (Uint32) (m->max_id + 1) * sizeof(menu_item *));
     } else {
         m->item = malloc((Uint32) (m->max_id + 1) * sizeof(menu_item *));
     }
     m->item[m->max_id] = item;
-    item->font = NULL;
-    item->font_path = NULL;
+    m->n_slots = m->max_id + 1;
     item->font_size = font_size;
-    item->font2 = NULL;
-    item->font2_path = NULL;
     item->font_size2 = font_size_2nd_line;
-    item->num_label_chars = 0;
-    item->num_label_chars2 = 0;
-    item->label_active = NULL;
-    item->label_current = NULL;
-    item->label_default = NULL;
 
     /* Initialize fonts */
 
@@ -444,24 +607,24 @@ void menu_item_free(menu_item *item) {
     if (item) {
         log_config(MENU_CTX, "Freeing menu item %s\n", item->label);
 
-        if (item->menu && item->menu->ctrl) {
+        /* The objects of virtual menus belong to their data source */
+        if (item->menu && item->menu->ctrl && !item->menu->source) {
             menu_item_action(DISPOSE, item->menu->ctrl, item);
         }
 
         free_and_set_null((void **) &item->unicode_label);
         free_and_set_null((void **) &item->unicode_label2);
         free_and_set_null((void **) &item->label);
+        free_and_set_null((void **) &item->key);
 
-        text_obj_free(item->label_active);
-        text_obj_free(item->label_current);
-        text_obj_free(item->label_default);
+        menu_item_release_glyphs(item);
 
         if (item->font) {
-            TTF_CloseFont(item->font);
+            glyph_atlas_close_font(item->menu->ctrl->glyph_atlas, item->font);
         }
 
         if (item->font2) {
-            TTF_CloseFont(item->font2);
+            glyph_atlas_close_font(item->menu->ctrl->glyph_atlas, item->font2);
         }
 
         free_and_set_null((void **) &item->font_path);
@@ -514,6 +677,7 @@ void menu_item_show(menu_item *item) {
     menu *m = (menu *) item->menu;
     menu_ctrl *ctrl = (menu_ctrl *) m->ctrl;
     if (m != ctrl->current) {
+        menu_animation_queue_skip(&ctrl->animations);
         ctrl->warping = 1;
         ctrl->current = m;
         if (m->transient) {
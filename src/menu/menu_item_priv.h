@@ -44,9 +44,9 @@ typedef struct menu_item {
     menu *menu;
     int line; // The line (0 = default, >0 = above, <0 = below)
 
-    text_obj *label_default;
-    text_obj *label_active;
-    text_obj *label_current;
+    text_obj *label_obj; /* The rendered label, colored depending on the item state when drawn */
+    int glyphs_valid; /* label_obj matches label, icon and style; built lazily when the item gets near the scale */
+    raster_job *raster_job; /* Renders the new label on a raster worker, NULL if none is pending */
 
     item_action *action;
     int w2;
@@ -57,11 +57,17 @@ typedef struct menu_item {
     **/
     int object_type;
     const void *user_data;
+    char *key; /* Matches the item with the entries passed to menu_sync, NULL for other items */
+    Uint32 pin_epoch; /* Virtual menus: handed out in this item_epoch of the ctrl, not rebound before the next */
 } menu_item;
 
-void menu_item_update_cnt_rad(menu_item *item, SDL_Point center, int radius);
+menu_item *menu_item_new_unbound(menu *m, int object_type, item_action *action);
+void menu_item_bind(menu_item *item, int id, const char *label, const char *icon, const void *object);
 int menu_item_draw(menu_item *item, menu_item_state st, double angle);
-void menu_item_rebuild_glyphs(menu_item *item);
+void menu_item_build_glyphs(menu_item *item);
+int menu_item_prepare_glyphs(menu_item *item, int upload);
+void menu_item_invalidate_glyphs(menu_item *item);
+void menu_item_release_glyphs(menu_item *item);
 void menu_item_action(menu_event evt, menu_ctrl *ctrl, menu_item *item);
 
 #endif // MENU_ITEM_PRIV_H
@@ -22,10 +22,21 @@
 #include "../base/logging.h"
 #include "../base/util.h"
 #include "../util/sdl_util.h"
+#include "asset_cache.h"
+#include "frame_profiler.h"
 #include "menu_ctrl_priv.h"
 #include "menu_item_priv.h"
 #include "menu_menu_priv.h"
 
+/* Items beyond either edge of the scale (per line) whose labels are kept ready */
+#define GLYPH_LOOKAHEAD_ITEMS 4
+/* Time per frame for turning rendered labels into textures */
+#define GLYPH_UPLOAD_BUDGET_MS 4
+/* Alpha of the background color laid over the frame under an overlay menu */
+#define OVERLAY_DIM_ALPHA 160
+/* Smallest key table of menu_sync, always a power of two */
+#define MENU_SYNC_MIN_BUCKETS 16
+
 int menu_get_max_id(menu *m) {
     return m->max_id;
 }
@@ -89,11 +100,16 @@ const SDL_Color *menu_get_effective_scale_color(menu *m) {
                                : (m && m->ctrl ? m->ctrl->scale_color : NULL);
 }
 
+static menu_item *menu_get_virtual_item(menu *m, int id);
+
 menu_item *menu_get_item(menu *m, int id) {
+    if (m->source) {
+        return menu_get_virtual_item(m, id);
+    }
     return m->item[id];
 }
 
-int menu_draw_scale(menu *m, double xc, double yc, double r, double R, double angle, unsigned char alpha, int lines) {
+int menu_draw_scale(menu *m, double xc, double yc, double r, double R, double angle, unsigned char alpha, int lines, int w, int h) {
 
     double a = M_PI * angle / 180.0;
     double cos_a = cos(a);
@@ -108,13 +124,13 @@ int menu_draw_scale(menu *m, double xc, double yc, double r, double R, double an
      * Decide whether we have to draw
      */
     int doDraw = 1;
-    if (fx1 > ctrl->w && fx2 > ctrl->w) {
+    if (fx1 > w && fx2 > w) {
         doDraw = 0;
     } else if (fx1 < 0 && fx2 < 0) {
         doDraw = 0;
-    } else if (fy1 > ctrl->h && fx2 > ctrl->h) {
+    } else if (fy1 > h && fy2 > h) {
         doDraw = 0;
-    } else if (fy1 < 0 && fx2 < 0) {
+    } else if (fy1 < 0 && fy2 < 0) {
         doDraw = 0;
     }
 
@@ -145,7 +161,7 @@ int menu_draw_scale(menu *m, double xc, double yc, double r, double R, double an
     return 0;
 }
 
-int menu_draw_scales(menu *m, double xc, double yc, double angle) {
+static void menu_draw_scale_lines(menu *m, double xc, double yc, double angle, int w, int h) {
 
     menu_ctrl *ctrl = m->ctrl;
 
@@ -160,14 +176,14 @@ int menu_draw_scales(menu *m, double xc, double yc, double angle) {
 
     for (int s = 0; s < ctrl->no_of_scales; s++) {
 
-        menu_draw_scale(m, xc, yc, fr-20, fR, a, 255, 0);
+        menu_draw_scale(m, xc, yc, fr-20, fR, a, 255, 0, w, h);
 
         a += angle_step;
 
         int sd;
         for (sd = 0; sd < no_of_mini_scales; sd++) {
 
-            menu_draw_scale(m,xc,yc,fr,fR,a, 255, 0);
+            menu_draw_scale(m,xc,yc,fr,fR,a, 255, 0, w, h);
 
             a += angle_step;
 
@@ -175,44 +191,306 @@ int menu_draw_scales(menu *m, double xc, double yc, double angle) {
 
     }
 
-    return 0;
+}
+
+/**
+ * Renders the scale ring at angle 0 into ctrl->scale_texture. The texture
+ * is shared by all menus and rebuilt when the radii, the number of scales,
+ * the scale color or the style change.
+ **/
+static void menu_update_scale_texture(menu *m) {
+    menu_ctrl *ctrl = m->ctrl;
+    const SDL_Color *color = menu_get_effective_scale_color(m);
+    int r = m->radius_scales_start;
+    int R = m->radius_scales_end;
+
+    if (ctrl->scale_texture_valid
+        && ctrl->scale_texture_r == r
+        && ctrl->scale_texture_R == R
+        && ctrl->scale_texture_n == ctrl->no_of_scales
+        && ctrl->scale_texture_version == ctrl->style_version
+        && ctrl->scale_texture_color.r == color->r
+        && ctrl->scale_texture_color.g == color->g
+        && ctrl->scale_texture_color.b == color->b) {
+        return;
+    }
+
+    if (ctrl->scale_texture) {
+        SDL_DestroyTexture(ctrl->scale_texture);
+        ctrl->scale_texture = NULL;
+    }
 
+    /* Even if the texture can't be created, don't retry every frame */
+    ctrl->scale_texture_valid = 1;
+    ctrl->scale_texture_r = r;
+    ctrl->scale_texture_R = R;
+    ctrl->scale_texture_n = ctrl->no_of_scales;
+    ctrl->scale_texture_version = ctrl->style_version;
+    ctrl->scale_texture_color = *color;
+
+    int size = 2 * (R > r ? R : r) + 2;
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(ctrl->renderer, &info) == 0
+        && ((info.max_texture_width > 0 && size > info.max_texture_width)
+            || (info.max_texture_height > 0 && size > info.max_texture_height))) {
+        log_info(MENU_CTX, "Scale ring of %dpx exceeds the texture size, drawing lines\n", size);
+        return;
+    }
+
+    ctrl->scale_texture = SDL_CreateTexture(ctrl->renderer, DEFAULT_SDL_PIXELFORMAT, SDL_TEXTUREACCESS_TARGET, size, size);
+    if (!ctrl->scale_texture) {
+        log_warning(MENU_CTX, "Could not create scale texture, drawing lines: %s\n", SDL_GetError());
+        return;
+    }
+    SDL_SetTextureBlendMode(ctrl->scale_texture, SDL_BLENDMODE_BLEND);
+
+    SDL_Texture *target = SDL_GetRenderTarget(ctrl->renderer);
+    SDL_SetRenderTarget(ctrl->renderer, ctrl->scale_texture);
+    SDL_SetRenderDrawBlendMode(ctrl->renderer, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(ctrl->renderer, color->r, color->g, color->b, 0);
+    SDL_RenderClear(ctrl->renderer);
+    menu_draw_scale_lines(m, 0.5 * size, 0.5 * size, 0.0, size, size);
+    SDL_SetRenderTarget(ctrl->renderer, target);
 }
 
-int menu_draw(menu *m, int clear, int render) {
+/**
+ * The scale ring only changes with the style, so it is rendered once
+ * and rotated with the menu angle
+ **/
+int menu_draw_scales(menu *m, double xc, double yc, double angle) {
 
+    menu_ctrl *ctrl = m->ctrl;
 
-    if (!m) {
+    menu_update_scale_texture(m);
+
+    if (!ctrl->scale_texture) {
+        menu_draw_scale_lines(m, xc, yc, angle, ctrl->w, ctrl->h);
         return 0;
     }
 
-    if (!m->dirty) {
-        return 0;
+    int size;
+    SDL_QueryTexture(ctrl->scale_texture, NULL, NULL, &size, NULL);
+
+    /* The scales go counterclockwise with the angle, SDL rotates clockwise */
+    SDL_FRect dst = {xc - 0.5 * size, yc - 0.5 * size, size, size};
+    SDL_RenderCopyExF(ctrl->renderer, ctrl->scale_texture, NULL, &dst, -angle, NULL, SDL_FLIP_NONE);
+
+    return 0;
+
+}
+
+/**
+ * Items within this distance of current_id get their labels prepared
+ **/
+static int menu_glyph_reach(menu *m) {
+    return m->n_o_items_on_scale / 2 + GLYPH_LOOKAHEAD_ITEMS * m->n_o_lines;
+}
+
+/**
+ * Distance between two item ids on the circular scale
+ **/
+static int menu_item_distance(menu *m, int a, int b) {
+    int n = m->max_id + 1;
+    int d = abs(a - b) % n;
+    return d < n - d ? d : n - d;
+}
+
+static int menu_virtual_item_pinned(menu *m, menu_item *item) {
+    return item->pin_epoch == m->ctrl->item_epoch || (item->id >= 0 && item->id == m->current_id);
+}
+
+/**
+ * Brings the pool of a virtual menu to n_slots. Shrinking only frees
+ * items that are not pinned, so the pool may stay bigger until they are.
+ **/
+static int menu_resize_virtual_pool(menu *m, int n_slots) {
+    if (n_slots > m->n_slots) {
+        menu_item **items = realloc(m->item, n_slots * sizeof(menu_item *));
+        if (!items) {
+            log_error(MENU_CTX, "menu_resize_virtual_pool: realloc failed\n");
+            return 0;
+        }
+        memset(items + m->n_slots, 0, (n_slots - m->n_slots) * sizeof(menu_item *));
+        m->item = items;
+        m->n_slots = n_slots;
+        return 1;
     }
 
-    m->dirty = 0;
+    int n = 0;
+    int excess = m->n_slots - n_slots;
+    for (int i = 0; i < m->n_slots; i++) {
+        menu_item *item = m->item[i];
+        if (excess > 0 && (!item || !menu_virtual_item_pinned(m, item))) {
+            menu_item_free(item);
+            excess--;
+            continue;
+        }
+        m->item[n++] = item;
+    }
+    if (n < m->n_slots) {
+        m->n_slots = n;
+        m->glyph_center = -1;
+    }
+    return 1;
+}
 
-    log_debug(MENU_CTX, "START: menu_draw\n");
-    Uint32 render_start_ticks = SDL_GetTicks();
+/**
+ * Items of a virtual menu come from a pool big enough for every entry
+ * within 2 * reach of current_id plus one for lookups further away, e.g.
+ * from the web interface. An entry that has no item yet takes the unbound
+ * one or the one farthest from current_id.
+ *
+ * The current item and the items handed out during this round of the
+ * menu loop are pinned: they are not rebound, the pool grows for them.
+ * Callers must not keep items of virtual menus beyond the event they
+ * handle, but look them up again by id.
+ **/
+static menu_item *menu_get_virtual_item(menu *m, int id) {
+    if (id < 0 || id > m->max_id) {
+        return NULL;
+    }
 
-    menu_ctrl *ctrl = (menu_ctrl *) m->ctrl;
+    int n_slots = 4 * menu_glyph_reach(m) + 2;
+    if (m->n_slots != n_slots) {
+        menu_resize_virtual_pool(m, n_slots);
+    }
 
-    double xc = ctrl->center.x;
-    double yc = ctrl->center.y;
+    int center = m->current_id >= 0 ? m->current_id : 0;
+    int victim = -1;
+    int victim_distance = -1;
+    for (int i = 0; i < m->n_slots; i++) {
+        menu_item *item = m->item[i];
+        if (item && item->id == id) {
+            victim = i;
+            victim_distance = 0;
+            break;
+        }
+        if (item && menu_virtual_item_pinned(m, item)) {
+            continue;
+        }
+        int distance = !item || item->id < 0 ? m->max_id + 1 : menu_item_distance(m, item->id, center);
+        if (distance > victim_distance) {
+            victim = i;
+            victim_distance = distance;
+        }
+    }
 
-    double angle = ctrl->angle_offset + m->segment * 360.0 / (m->n_o_items_on_scale*(2.0*m->segments_per_item+1));
-    log_debug(MENU_CTX,"segment: %f, angle: %f\n", m->segment, angle);
-    if (clear) {
-        double bg_angle = ctrl->angle_offset + ctrl->bg_segment * 360.0 / (m->n_o_items_on_scale*(2.0*m->segments_per_item+1));
-        menu_ctrl_clear(ctrl, bg_angle, ctrl->background_color, m->bg_image);
+    if (victim < 0) {
+        /* All items are pinned */
+        if (!menu_resize_virtual_pool(m, m->n_slots + 1)) {
+            return NULL;
+        }
+        victim = m->n_slots - 1;
     }
 
-    if (ctrl->draw_scales) {
-        menu_draw_scales(m, xc, yc, angle);
+    if (!m->item[victim]) {
+        m->item[victim] = menu_item_new_unbound(m, m->source_object_type, m->action);
+    }
+
+    menu_item *item = m->item[victim];
+    item->pin_epoch = m->ctrl->item_epoch;
+    menu_item_bind(item,
+                   id,
+                   m->source->label_at(m->source_data, id),
+                   m->source->icon_at ? m->source->icon_at(m->source_data, id) : NULL,
+                   m->source->object_at ? m->source->object_at(m->source_data, id) : NULL);
+    return item;
+}
+
+/**
+ * Prepares the labels of the items around current_id, nearest first, and
+ * drops the labels of items that have moved far away, so that only a
+ * window of items holds glyphs regardless of the menu size. All items
+ * holding glyphs are within 2 * reach of glyph_center, so only that range
+ * has to be looked at when the window moves.
+ *
+ * The glyphs are rendered by the raster workers; creating their textures
+ * is limited to GLYPH_UPLOAD_BUDGET_MS per frame. Returns 1, if labels
+ * in the window are still missing.
+ **/
+static int menu_update_glyph_window(menu *m) {
+    if (m->max_id < 0 || m->current_id < 0) {
+        return 0;
+    }
+
+    int reach = menu_glyph_reach(m);
+    int n = m->max_id + 1;
+
+    if (m->source) {
+        /* The pool is small, just look at all of it */
+        for (int i = 0; i < m->n_slots; i++) {
+            menu_item *item = m->item[i];
+            if (item && item->id >= 0 && menu_item_distance(m, item->id, m->current_id) > 2 * reach) {
+                menu_item_release_glyphs(item);
+            }
+        }
+        if (2 * reach + 1 >= n) {
+            reach = n / 2;
+        }
+    } else if (2 * reach + 1 >= n) {
+        reach = n / 2;
+    } else if (m->glyph_center != m->current_id || m->glyph_max_id != m->max_id) {
+        if (m->glyph_center < 0 || m->glyph_max_id != m->max_id) {
+            /* Items were added or removed, the old window is meaningless */
+            for (int i = 0; i <= m->max_id; i++) {
+                if (menu_item_distance(m, i, m->current_id) > 2 * reach) {
+                    menu_item_release_glyphs(m->item[i]);
+                }
+            }
+        } else {
+            for (int d = -2 * reach; d <= 2 * reach; d++) {
+                int i = ((m->glyph_center + d) % n + n) % n;
+                if (menu_item_distance(m, i, m->current_id) > 2 * reach) {
+                    menu_item_release_glyphs(m->item[i]);
+                }
+            }
+        }
     }
+    m->glyph_center = m->current_id;
+    m->glyph_max_id = m->max_id;
+
+    Uint64 deadline = SDL_GetPerformanceCounter()
+                      + GLYPH_UPLOAD_BUDGET_MS * SDL_GetPerformanceFrequency() / 1000;
+    int uploads = 0;
+    int pending = 0;
+
+    /* 0, 1, -1, 2, -2, ... */
+    for (int k = 0; k <= 2 * reach && k < n; k++) {
+        int d = k % 2 ? (k + 1) / 2 : -(k / 2);
+        menu_item *item = menu_get_item(m, ((m->current_id + d) % n + n) % n);
+        int upload = uploads == 0 || SDL_GetPerformanceCounter() < deadline;
+
+        if (item->glyphs_valid) {
+            continue;
+        }
+
+        if (menu_item_prepare_glyphs(item, upload)) {
+            uploads++;
+        } else {
+            pending = 1;
+        }
+    }
+
+    return pending;
+}
+
+/**
+ * The angle of the selected item
+ **/
+static double menu_angle(menu *m) {
+    return m->ctrl->angle_offset + m->segment * 360.0 / (m->n_o_items_on_scale*(2.0*m->segments_per_item+1));
+}
+
+/**
+ * Draws the labels of m around angle, the angle of the selected item
+ **/
+static void menu_draw_items(menu *m, double angle) {
+    menu_ctrl *ctrl = (menu_ctrl *) m->ctrl;
 
     if (m->max_id >= 0) {
 
+        int glyphs_pending = menu_update_glyph_window(m);
+
         int i;
         int count_drawn_items = (ctrl->warping && !m->draw_only_active) ? 0.5 * m->n_o_items_on_scale : 0;
 
@@ -245,18 +523,68 @@ int menu_draw(menu *m, int clear, int render) {
                 item_angle += 360.0;
             }
 
-            menu_item_draw(m->item[current_item],st,item_angle);
+            menu_item_draw(menu_get_item(m, current_item),st,item_angle);
+
+        }
+
+        glyph_atlas_flush(ctrl->glyph_atlas);
 
+        /* Draw again, as soon as more labels are ready */
+        if (glyphs_pending) {
+            m->dirty = 1;
+            ctrl->glyphs_pending = 1;
         }
     }
+}
+
+static int menu_draw_frame(menu *m, int clear, int render, int lit) {
+    if (!m) {
+        return 0;
+    }
+
+    if (!m->dirty) {
+        return 0;
+    }
+
+    m->dirty = 0;
+
+    log_debug(MENU_CTX, "START: menu_draw\n");
+    Uint32 render_start_ticks = SDL_GetTicks();
+
+    menu_ctrl *ctrl = (menu_ctrl *) m->ctrl;
+
+    double xc = ctrl->center.x;
+    double yc = ctrl->center.y;
+
+    double angle = menu_angle(m);
+    log_debug(MENU_CTX,"segment: %f, angle: %f\n", m->segment, angle);
+    frame_profiler_frame_begin();
+    Uint64 phase_start = frame_profiler_now();
+    if (clear) {
+        double bg_angle = ctrl->angle_offset + ctrl->bg_segment * 360.0 / (m->n_o_items_on_scale*(2.0*m->segments_per_item+1));
+        menu_ctrl_clear(ctrl, bg_angle, ctrl->background_color, m->bg_image);
+    }
+    frame_profiler_add(FRAME_PHASE_CLEAR, phase_start);
 
-    menu_ctrl_draw_indicator(ctrl, xc, yc, angle);
+    phase_start = frame_profiler_now();
+    if (ctrl->draw_scales) {
+        menu_draw_scales(m, xc, yc, angle);
+    }
+    frame_profiler_add(FRAME_PHASE_SCALES, phase_start);
 
-    menu_ctrl_apply_light(ctrl);
+    phase_start = frame_profiler_now();
+    menu_draw_items(m, angle);
+    frame_profiler_add(FRAME_PHASE_ITEMS, phase_start);
 
+    if (lit) {
+        menu_ctrl_draw_overlay(ctrl);
+    }
 
     if (render) {
+        phase_start = frame_profiler_now();
         SDL_RenderPresent(ctrl->renderer);
+        frame_profiler_add(FRAME_PHASE_PRESENT, phase_start);
+        frame_profiler_frame_end();
     }
 
     Uint32 render_passed_ticks = SDL_GetTicks()-render_start_ticks;
@@ -267,19 +595,84 @@ int menu_draw(menu *m, int clear, int render) {
     return 1;
 }
 
+int menu_draw(menu *m, int clear, int render) {
+    return menu_draw_frame(m, clear, render, 1);
+}
+
+/**
+ * Draws m without the indicator and the light and doesn't present it,
+ * for the frame menu_draw_over draws on
+ **/
+int menu_draw_unlit(menu *m) {
+    return menu_draw_frame(m, 1, 0, 0);
+}
+
+/**
+ * Draws the labels of m over under, an unlit frame of another menu
+ * dimmed with the background color. The menu's own bg_image, e.g. the
+ * backdrop of the volume menu, goes between the two. The indicator and
+ * the light go on top, as with menu_draw.
+ **/
+int menu_draw_over(menu *m, SDL_Texture *under) {
+    if (!m || !m->dirty) {
+        return 0;
+    }
+
+    m->dirty = 0;
+
+    menu_ctrl *ctrl = (menu_ctrl *) m->ctrl;
+
+    frame_profiler_frame_begin();
+    Uint64 phase_start = frame_profiler_now();
+    SDL_RenderCopy(ctrl->renderer, under, NULL, NULL);
+    if (ctrl->background_color) {
+        SDL_BlendMode blend_mode;
+        SDL_GetRenderDrawBlendMode(ctrl->renderer, &blend_mode);
+        SDL_SetRenderDrawBlendMode(ctrl->renderer, SDL_BLENDMODE_BLEND);
+        SDL_SetRenderDrawColor(ctrl->renderer,
+                               ctrl->background_color->r,
+                               ctrl->background_color->g,
+                               ctrl->background_color->b,
+                               OVERLAY_DIM_ALPHA);
+        SDL_RenderFillRect(ctrl->renderer, NULL);
+        SDL_SetRenderDrawBlendMode(ctrl->renderer, blend_mode);
+    }
+    if (m->bg_image) {
+        double bg_angle = ctrl->angle_offset + ctrl->bg_segment * 360.0 / (m->n_o_items_on_scale*(2.0*m->segments_per_item+1));
+        menu_ctrl_clear(ctrl, bg_angle, NULL, m->bg_image);
+    }
+    frame_profiler_add(FRAME_PHASE_CLEAR, phase_start);
+
+    phase_start = frame_profiler_now();
+    menu_draw_items(m, menu_angle(m));
+    frame_profiler_add(FRAME_PHASE_ITEMS, phase_start);
+
+    menu_ctrl_draw_overlay(ctrl);
+
+    phase_start = frame_profiler_now();
+    SDL_RenderPresent(ctrl->renderer);
+    frame_profiler_add(FRAME_PHASE_PRESENT, phase_start);
+    frame_profiler_frame_end();
+
+    return 1;
+}
+
 int menu_clear(menu *m) {
     log_config(MENU_CTX, "Start clear_menu, max_id=%d\n", m->max_id);
-    int id = m->max_id;
-    while (id >= 0) {
-        log_config(MENU_CTX, "%d\n",id);
-        menu_item_free(m->item[id]);
-        m->item[id] = 0;
-        id--;
+    int slot = m->n_slots - 1;
+    while (slot >= 0) {
+        log_config(MENU_CTX, "%d\n",slot);
+        menu_item_free(m->item[slot]);
+        m->item[slot] = 0;
+        slot--;
     }
 
+    m->n_slots = 0;
     m->max_id = -1;
     m->active_id = -1;
     m->current_id = 0;
+    m->glyph_center = -1;
+    m->glyph_max_id = -1;
 
     m->segment = 0;
 
@@ -287,6 +680,131 @@ int menu_clear(menu *m) {
     return 0;
 }
 
+static Uint32 menu_sync_hash(const char *key) {
+    Uint32 h = 2166136261u;
+    for (const unsigned char *c = (const unsigned char *) key; *c; c++) {
+        h = (h ^ *c) * 16777619u;
+    }
+    return h;
+}
+
+/**
+ * Makes the items of m match entries. Existing items are matched by key
+ * and keep their rendered labels and sub menus, so only new, removed,
+ * moved or relabelled items cost anything. The selected and the active
+ * item stay selected and active wherever they move. An item whose
+ * object is replaced gets DISPOSE for the old one first.
+ * Returns 1, if anything changed.
+ **/
+int menu_sync(menu *m, const menu_sync_entry *entries, int n_entries) {
+    if (!m) {
+        return 0;
+    }
+    if (m->source) {
+        log_error(MENU_CTX, "menu_sync: virtual menus are reloaded with menu_reload\n");
+        return 0;
+    }
+    if (n_entries < 0 || !entries) {
+        n_entries = 0;
+    }
+
+    /* The existing items by key, chained by their index */
+    int n_buckets = MENU_SYNC_MIN_BUCKETS;
+    while (n_buckets < 2 * m->n_slots) {
+        n_buckets *= 2;
+    }
+    int *bucket = malloc(n_buckets * sizeof(int));
+    int *next = malloc((m->n_slots + 1) * sizeof(int));
+    for (int b = 0; b < n_buckets; b++) {
+        bucket[b] = -1;
+    }
+    for (int i = m->n_slots - 1; i >= 0; i--) {
+        next[i] = -1;
+        if (m->item[i] && m->item[i]->key) {
+            Uint32 b = menu_sync_hash(m->item[i]->key) & (n_buckets - 1);
+            next[i] = bucket[b];
+            bucket[b] = i;
+        }
+    }
+
+    menu_item *current = m->current_id >= 0 && m->current_id <= m->max_id ? m->item[m->current_id] : NULL;
+    menu_item *active = m->active_id >= 0 && m->active_id <= m->max_id ? m->item[m->active_id] : NULL;
+    int current_id = -1;
+    int active_id = -1;
+    int changed = n_entries != m->max_id + 1;
+
+    menu_item **items = n_entries > 0 ? malloc(n_entries * sizeof(menu_item *)) : NULL;
+    for (int i = 0; i < n_entries; i++) {
+        const menu_sync_entry *e = &entries[i];
+        menu_item *item = NULL;
+
+        if (e->key) {
+            for (int j = bucket[menu_sync_hash(e->key) & (n_buckets - 1)]; j >= 0; j = next[j]) {
+                if (m->item[j] && !strcmp(m->item[j]->key, e->key)) {
+                    item = m->item[j];
+                    m->item[j] = NULL;
+                    break;
+                }
+            }
+        }
+
+        if (item) {
+            if (item->user_data != e->object) {
+                menu_item_action(DISPOSE, m->ctrl, item);
+            }
+            item->object_type = e->object_type;
+            item->action = e->action;
+            changed |= item->id != i || my_strcmp(item->label, e->label ? e->label : "") || my_strcmp(item->icon, e->icon);
+        } else {
+            item = menu_item_new_unbound(m, e->object_type, e->action);
+            item->key = e->key ? my_copystr(e->key) : NULL;
+            changed = 1;
+        }
+
+        menu_item_bind(item, i, e->label, e->icon, e->object);
+        items[i] = item;
+
+        if (item == current) {
+            current_id = i;
+        }
+        if (item == active) {
+            active_id = i;
+        }
+    }
+
+    /* Whatever was not matched is gone */
+    for (int j = 0; j < m->n_slots; j++) {
+        if (m->item[j]) {
+            menu_item_free(m->item[j]);
+            changed = 1;
+        }
+    }
+
+    free(bucket);
+    free(next);
+    free(m->item);
+    m->item = items;
+    m->n_slots = n_entries;
+    m->max_id = n_entries - 1;
+
+    if (current_id < 0) {
+        m->segment = 0;
+        current_id = m->current_id < 0 ? 0 : m->current_id;
+        if (current_id > m->max_id) {
+            current_id = m->max_id;
+        }
+    }
+    m->current_id = current_id;
+    m->active_id = active_id;
+
+    if (changed) {
+        m->glyph_center = -1;
+        m->dirty = 1;
+    }
+
+    return changed;
+}
+
 menu *menu_new(
     menu_ctrl *ctrl,
     int lines,
@@ -312,6 +830,12 @@ menu *menu_new(
 
     m->parent = m;
     m->item = NULL;
+    m->n_slots = 0;
+    m->source = NULL;
+    m->source_data = NULL;
+    m->source_object_type = 0;
+    m->glyph_center = -1;
+    m->glyph_max_id = -1;
     m->segment = 0;
     m->label = NULL;
     m->bg_image = NULL;
@@ -324,6 +848,7 @@ menu *menu_new(
 
     m->transient = 0;
     m->draw_only_active = 0;
+    m->overlay = 0;
     m->n_o_lines = lines;
     m->n_o_items_on_scale = lines * ctrl->n_o_items_on_scale;
     m->segments_per_item = ctrl->segments_per_item;
@@ -364,12 +889,17 @@ void menu_free(menu *m) {
         } else {
             log_config(MENU_CTX, "Freeing menu %p\n", m);
         }
-        for (int i = 0; i <= m->max_id; i++) {
+        menu_ctrl_forget_menu(m->ctrl, m);
+        for (int i = 0; i < m->n_slots; i++) {
             menu_item_free(m->item[i]);
             m->item[i] = NULL;
         }
 
         free(m->item);
+        if (m->source && m->source->free_data) {
+            m->source->free_data(m->source_data);
+        }
+        free(m->source);
         free_and_set_null((void **) &m->label);
         free_and_set_null((void **) &m->default_color);
         free_and_set_null((void **) &m->selected_color);
@@ -378,13 +908,13 @@ void menu_free(menu *m) {
         free_and_set_null((void **) &m->bg_image_path);
 
         if (m->bg_image) {
-            SDL_DestroyTexture(m->bg_image);
+            asset_cache_release_texture(m->bg_image);
         }
         if (m->font) {
-            TTF_CloseFont(m->font);
+            glyph_atlas_close_font(m->ctrl->glyph_atlas, m->font);
         }
         if (m->font2) {
-            TTF_CloseFont(m->font2);
+            glyph_atlas_close_font(m->ctrl->glyph_atlas, m->font2);
         }
 
         free_and_set_null((void **) &m->font_path);
@@ -394,6 +924,87 @@ void menu_free(menu *m) {
     }
 }
 
+/**
+ * A menu whose entries are read from source. It holds menu items only
+ * for the entries around the selected one, so its size does not matter.
+ * All items get object_type and action; their objects are borrowed from
+ * the source and never disposed.
+ **/
+menu *menu_new_virtual(
+    menu_ctrl *ctrl,
+    int lines,
+    const char *font,
+    int font_size,
+    const menu_data_source *source,
+    void *source_data,
+    int object_type,
+    item_action *action
+    ) {
+    if (!source || !source->count || !source->label_at) {
+        log_error(MENU_CTX, "menu_new_virtual: data source needs count and label_at\n");
+        return NULL;
+    }
+
+    menu *m = menu_new(ctrl, lines, font, font_size, action, NULL, 0);
+    m->source = malloc(sizeof(menu_data_source));
+    *m->source = *source;
+    m->source_data = source_data;
+    m->source_object_type = object_type;
+    menu_reload(m);
+
+    return m;
+}
+
+/**
+ * Reads the entries of a virtual menu again, after the data source
+ * changed
+ **/
+void menu_reload(menu *m) {
+    if (!m || !m->source) {
+        return;
+    }
+
+    for (int i = 0; i < m->n_slots; i++) {
+        if (m->item[i]) {
+            menu_item_release_glyphs(m->item[i]);
+            m->item[i]->id = -1;
+        }
+    }
+
+    int count = m->source->count(m->source_data);
+    m->max_id = count > 0 ? count - 1 : -1;
+    if (m->max_id < 0) {
+        m->current_id = -1;
+    } else if (m->current_id < 0) {
+        m->current_id = 0;
+    } else if (m->current_id > m->max_id) {
+        m->current_id = m->max_id;
+    }
+    if (m->active_id > m->max_id) {
+        m->active_id = -1;
+    }
+    m->glyph_center = -1;
+    m->dirty = 1;
+}
+
+/**
+ * The data source of a virtual menu, NULL for other menus. Lets callers
+ * walk all entries without binding a menu item to each of them.
+ **/
+const menu_data_source *menu_get_data_source(menu *m, void **source_data) {
+    if (!m || !m->source) {
+        return NULL;
+    }
+    if (source_data) {
+        *source_data = m->source_data;
+    }
+    return m->source;
+}
+
+int menu_get_source_object_type(menu *m) {
+    return m && m->source ? m->source_object_type : UNKNOWN_OBJECT_TYPE;
+}
+
 menu *menu_new_root(
     menu_ctrl *ctrl,
     int lines,
@@ -419,6 +1030,9 @@ menu *menu_get_parent(menu *menu) {
 menu_item *menu_add_sub_menu(menu *m, const char *label, menu *sub_menu, item_action *action) {
 
     menu_item *item = menu_item_new(m, label, NULL, NULL, UNKNOWN_OBJECT_TYPE, NULL, -1, action, NULL, -1);
+    if (!item) {
+        return NULL;
+    }
     item->sub_menu = sub_menu;
     sub_menu->parent = m;
 
@@ -437,9 +1051,11 @@ menu_item *menu_add_sub_menu(menu *m, const char *label, menu *sub_menu, item_ac
 
 menu_item *menu_new_sub_menu(menu *m, const char *label, item_action *action) {
 
-    menu *sub_menu = menu_new(m->ctrl, 1, NULL, 0, NULL, NULL, 0);
     menu_item *item = menu_item_new(m, label, NULL, NULL, UNKNOWN_OBJECT_TYPE, NULL, -1, action, NULL, -1);
-    item->sub_menu = sub_menu;
+    if (!item) {
+        return NULL;
+    }
+    item->sub_menu = menu_new(m->ctrl, 1, NULL, 0, NULL, NULL, 0);
 
     return item;
 
@@ -461,6 +1077,11 @@ void menu_set_current_id(menu *menu, int id) {
     }
 }
 
+void menu_set_overlay(menu *m, int overlay) {
+    m->overlay = overlay;
+    m->dirty = 1;
+}
+
 void menu_set_draw_only_active(menu *menu, int draw_only_active) {
     menu->draw_only_active = draw_only_active;
 }
@@ -475,22 +1096,23 @@ void menu_set_radius(menu *m, int radius_labels, int radius_scales_start, int ra
         m->radius_scales_end = radius_scales_end;
 
     int i = 0;
-    for (i = 0; i <= m->max_id; i++) {
+    for (i = 0; i < m->n_slots; i++) {
         if (m->item[i] && m->item[i]->sub_menu) {
             menu_set_radius((menu *) m->item[i]->sub_menu, radius_labels, radius_scales_start, radius_scales_end);
         }
     }
 }
 
-void menu_rebuild_glyphs(menu *m) {
-    for (int i = 0; i <= m->max_id; i++) {
+void menu_invalidate_glyphs(menu *m) {
+    for (int i = 0; i < m->n_slots; i++) {
         if (m->item[i]) {
             if (m->item[i]->sub_menu) {
-                menu_rebuild_glyphs((menu *) m->item[i]->sub_menu);
+                menu_invalidate_glyphs((menu *) m->item[i]->sub_menu);
             }
-            menu_item_rebuild_glyphs(m->item[i]);
+            menu_item_invalidate_glyphs(m->item[i]);
         }
     }
+    m->glyph_center = -1;
     m->dirty = 1;
 }
 
@@ -519,7 +1141,8 @@ int menu_set_colors(menu *m, SDL_Color *default_color, SDL_Color *selected_color
         m->selected_color = clone_color(selected_color);
     }
 
-    menu_rebuild_glyphs(m);
+    /* Labels are colored when drawn, no need to rebuild the glyphs */
+    m->dirty = 1;
     if (m->ctrl) {
         m->ctrl->style_version++;
     }
@@ -535,7 +1158,7 @@ int menu_set_bg_image(menu *m, const char *bg_image_path) {
     }
 
     if (m->bg_image) {
-        SDL_DestroyTexture(m->bg_image);
+        asset_cache_release_texture(m->bg_image);
         m->bg_image = NULL;
     }
 
@@ -543,7 +1166,7 @@ int menu_set_bg_image(menu *m, const char *bg_image_path) {
 
     if (bg_image_path) {
         m->bg_image_path = my_copystr(bg_image_path);
-        m->bg_image = IMG_LoadTexture(m->ctrl->renderer, bg_image_path);
+        m->bg_image = asset_cache_load_texture(m->ctrl->renderer, bg_image_path);
 
         if (!m->bg_image) {
             log_error(MENU_CTX,
@@ -644,5 +1267,5 @@ void menu_set_segments_per_item(menu *m, int segments) {
 }
 
 menu_item *menu_get_current_item(menu *m) {
-    return m && m->current_id >= 0 ? m->item[m->current_id] : NULL;
+    return m && m->current_id >= 0 && m->max_id >= 0 ? menu_get_item(m, m->current_id) : NULL;
 }
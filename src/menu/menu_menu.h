@@ -31,6 +31,21 @@ typedef struct menu_item menu_item;
 typedef struct menu menu;
 typedef int item_action(menu_event, menu *, menu_item *);
 
+/**
+ * The entries of a virtual menu. Only the entries around the selected one
+ * get menu items, which are reused as the menu turns. icon_at, object_at
+ * and free_data may be NULL. The returned strings and objects belong to
+ * the data source, they are copied or borrowed only while the entry is
+ * shown. free_data gets the data when the menu is freed.
+ **/
+typedef struct menu_data_source {
+    int (*count)(void *data);
+    const char *(*label_at)(void *data, int index);
+    const char *(*icon_at)(void *data, int index);
+    const void *(*object_at)(void *data, int index);
+    void (*free_data)(void *data);
+} menu_data_source;
+
 menu *menu_new(menu_ctrl *ctrl,
                int lines,
                const char *font,
@@ -38,6 +53,30 @@ menu *menu_new(menu_ctrl *ctrl,
                item_action *action,
                const char *font_2nd_line,
                int font_size_2nd_line);
+/**
+ * An entry passed to menu_sync. The menu takes ownership of object, as
+ * with menu_item_new. Entries without key always get a new item.
+ **/
+typedef struct menu_sync_entry {
+    const char *key;
+    const char *label;
+    const char *icon;
+    const void *object;
+    int object_type;
+    item_action *action;
+} menu_sync_entry;
+
+menu *menu_new_virtual(menu_ctrl *ctrl,
+                       int lines,
+                       const char *font,
+                       int font_size,
+                       const menu_data_source *source,
+                       void *source_data,
+                       int object_type,
+                       item_action *action);
+void menu_reload(menu *m);
+const menu_data_source *menu_get_data_source(menu *m, void **source_data);
+int menu_get_source_object_type(menu *m);
 menu *menu_new_root(menu_ctrl *ctrl,
                     int lines,
                     const char *font,
@@ -51,6 +90,7 @@ int menu_get_max_id(menu *m);
 menu_item *menu_get_item(menu *m, int id);
 int menu_open(menu *m);
 int menu_clear(menu *m);
+int menu_sync(menu *m, const menu_sync_entry *entries, int n_entries);
 void menu_turn_left(menu *m);
 void menu_turn_right(menu *m);
 void menu_free(menu *m);
@@ -73,6 +113,7 @@ void menu_set_no_items_on_scale(menu *m, int n);
 void menu_set_radius_labels(menu *m, int radius);
 void menu_set_segments_per_item(menu *m, int segments);
 void menu_set_draw_only_active(menu *menu, int draw_only_active);
+void menu_set_overlay(menu *m, int overlay);
 void menu_set_label(menu *m, const char *label);
 const char *menu_get_effective_background_path(menu *m);
 const char *menu_get_effective_font_path(menu *m);
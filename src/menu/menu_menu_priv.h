@@ -37,7 +37,13 @@ typedef struct menu {
     int segments_per_item; /* The number of segments left and right that belong to a menu item. Default is taken from menu_ctrl */
     int sticky; /* ignored in the menu framework, but can be used to indicate that a menu shall not fade after a certain time */
     double segment;
+    int glyph_center; /* current_id the window of items holding glyphs was built around, -1 if none */
+    int glyph_max_id; /* max_id when the glyph window was built */
     menu_item **item;
+    int n_slots; /* Entries of item: max_id + 1, or the size of the item pool of virtual menus */
+    menu_data_source *source; /* Virtual menus only, their items are bound to the entries around current_id */
+    void *source_data;
+    int source_object_type;
     menu *parent;
     menu_ctrl *ctrl;
     SDL_Texture *bg_image;
@@ -53,6 +59,7 @@ typedef struct menu {
     SDL_Color *selected_color; /* The default foregound color, if NULL, the default_color from menu_ctrl is taken */
     uint8_t transient;
     uint8_t draw_only_active;
+    uint8_t overlay; /* Transient menus only: drawn over the last frame of the active menu */
     item_action *action;
     /**
      * User data
@@ -61,7 +68,9 @@ typedef struct menu {
 } menu;
 
 void menu_set_radius(menu *m, int radius_labels, int radius_scales_start, int radius_scales_end);
-void menu_rebuild_glyphs(menu *m);
+void menu_invalidate_glyphs(menu *m);
 int menu_clear(menu *m);
+int menu_draw_unlit(menu *m);
+int menu_draw_over(menu *m, SDL_Texture *under);
 
 #endif // MENU_PRIV_H
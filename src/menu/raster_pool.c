@@ -0,0 +1,255 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "raster_pool.h"
+#include "../base/log_contexts.h"
+#include "../base/logging.h"
+#include <stdlib.h>
+
+typedef enum { RASTER_JOB_PENDING, RASTER_JOB_RUNNING, RASTER_JOB_READY } raster_job_state;
+
+struct raster_job {
+    raster_job_state state;
+    SDL_atomic_t cancelled;
+    raster_job_run *run;
+    void *args;
+    raster_job_free *free_args;
+    raster_job_free *free_result;
+    void *result;
+    raster_pool *pool;
+    struct raster_job *next;
+};
+
+struct raster_pool {
+    SDL_mutex *mutex;
+    SDL_cond *cond;
+    raster_job *head; /* Jobs are run in the order they were submitted */
+    raster_job *tail;
+    int quit;
+    int n_threads;
+    SDL_Thread **threads;
+};
+
+static void raster_job_destroy(raster_job *job) {
+    if (job->free_args && job->args) {
+        job->free_args(job->args);
+    }
+    if (job->free_result && job->result) {
+        job->free_result(job->result);
+    }
+    free(job);
+}
+
+static int raster_pool_worker(void *data) {
+    raster_pool *pool = (raster_pool *) data;
+
+    SDL_LockMutex(pool->mutex);
+    while (1) {
+        while (!pool->quit && !pool->head) {
+            SDL_CondWait(pool->cond, pool->mutex);
+        }
+        if (pool->quit) {
+            break;
+        }
+
+        raster_job *job = pool->head;
+        pool->head = job->next;
+        if (!pool->head) {
+            pool->tail = NULL;
+        }
+        job->next = NULL;
+        job->state = RASTER_JOB_RUNNING;
+        SDL_UnlockMutex(pool->mutex);
+
+        void *result = job->run(job->args, job);
+
+        SDL_LockMutex(pool->mutex);
+        job->result = result;
+        if (SDL_AtomicGet(&job->cancelled)) {
+            raster_job_destroy(job);
+        } else {
+            job->state = RASTER_JOB_READY;
+        }
+    }
+    SDL_UnlockMutex(pool->mutex);
+
+    return 0;
+}
+
+raster_pool *raster_pool_new(int n_threads) {
+    raster_pool *pool = calloc(1, sizeof(raster_pool));
+    pool->mutex = SDL_CreateMutex();
+    pool->cond = SDL_CreateCond();
+    if (!pool->mutex || !pool->cond) {
+        log_error(MENU_CTX, "Could not create raster pool lock: %s\n", SDL_GetError());
+        raster_pool_free(pool);
+        return NULL;
+    }
+
+    pool->threads = calloc(n_threads, sizeof(SDL_Thread *));
+    for (int t = 0; t < n_threads; t++) {
+        pool->threads[t] = SDL_CreateThread(raster_pool_worker, "raster", pool);
+        if (!pool->threads[t]) {
+            log_error(MENU_CTX, "Could not create raster thread: %s\n", SDL_GetError());
+            break;
+        }
+        pool->n_threads++;
+    }
+
+    if (pool->n_threads == 0) {
+        raster_pool_free(pool);
+        return NULL;
+    }
+
+    log_config(MENU_CTX, "Rasterizing labels with %d threads\n", pool->n_threads);
+
+    return pool;
+}
+
+/**
+ * Stops the workers. Jobs still running are finished first, jobs not
+ * taken or cancelled by then are dropped.
+ **/
+void raster_pool_free(raster_pool *pool) {
+    if (!pool) {
+        return;
+    }
+
+    if (pool->mutex) {
+        SDL_LockMutex(pool->mutex);
+        pool->quit = 1;
+        SDL_CondBroadcast(pool->cond);
+        SDL_UnlockMutex(pool->mutex);
+    }
+
+    for (int t = 0; t < pool->n_threads; t++) {
+        SDL_WaitThread(pool->threads[t], NULL);
+    }
+
+    while (pool->head) {
+        raster_job *job = pool->head;
+        pool->head = job->next;
+        raster_job_destroy(job);
+    }
+
+    free(pool->threads);
+    if (pool->cond) {
+        SDL_DestroyCond(pool->cond);
+    }
+    if (pool->mutex) {
+        SDL_DestroyMutex(pool->mutex);
+    }
+    free(pool);
+}
+
+/**
+ * Queues a job, the pool takes ownership of args. The job belongs to the
+ * caller until it is taken or cancelled. Returns NULL, with args freed,
+ * if the job could not be queued.
+ **/
+raster_job *raster_pool_submit(raster_pool *pool,
+                               raster_job_run *run,
+                               void *args,
+                               raster_job_free *free_args,
+                               raster_job_free *free_result) {
+    raster_job *job = calloc(1, sizeof(raster_job));
+    if (!job) {
+        log_error(MENU_CTX, "raster_pool_submit: calloc failed\n");
+        if (free_args) {
+            free_args(args);
+        }
+        return NULL;
+    }
+    job->state = RASTER_JOB_PENDING;
+    job->run = run;
+    job->args = args;
+    job->free_args = free_args;
+    job->free_result = free_result;
+    job->pool = pool;
+
+    SDL_LockMutex(pool->mutex);
+    if (pool->tail) {
+        pool->tail->next = job;
+    } else {
+        pool->head = job;
+    }
+    pool->tail = job;
+    SDL_CondSignal(pool->cond);
+    SDL_UnlockMutex(pool->mutex);
+
+    return job;
+}
+
+int raster_job_cancelled(raster_job *job) {
+    return job && SDL_AtomicGet(&job->cancelled);
+}
+
+int raster_job_done(raster_job *job) {
+    SDL_LockMutex(job->pool->mutex);
+    int done = job->state == RASTER_JOB_READY;
+    SDL_UnlockMutex(job->pool->mutex);
+    return done;
+}
+
+/**
+ * Hands the result of a finished job to the caller and frees the job
+ **/
+void *raster_job_take(raster_job *job) {
+    raster_pool *pool = job->pool;
+
+    SDL_LockMutex(pool->mutex);
+    void *result = job->result;
+    job->result = NULL;
+    raster_job_destroy(job);
+    SDL_UnlockMutex(pool->mutex);
+
+    return result;
+}
+
+/**
+ * Drops the job. A job that is running right now is freed by its worker
+ * when it returns; it sees raster_job_cancelled before its next TTF call,
+ * so fonts may be closed right after this.
+ **/
+void raster_job_cancel(raster_job *job) {
+    if (!job) {
+        return;
+    }
+
+    raster_pool *pool = job->pool;
+
+    SDL_LockMutex(pool->mutex);
+    SDL_AtomicSet(&job->cancelled, 1);
+    if (job->state == RASTER_JOB_PENDING) {
+        raster_job **j = &pool->head;
+        pool->tail = NULL;
+        while (*j) {
+            if (*j == job) {
+                *j = job->next;
+            } else {
+                pool->tail = *j;
+                j = &(*j)->next;
+            }
+        }
+        raster_job_destroy(job);
+    } else if (job->state == RASTER_JOB_READY) {
+        raster_job_destroy(job);
+    }
+    SDL_UnlockMutex(pool->mutex);
+}
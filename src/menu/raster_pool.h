@@ -0,0 +1,53 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef RASTER_POOL_H
+#define RASTER_POOL_H
+
+#include <SDL2/SDL.h>
+
+/**
+ * Worker threads producing surfaces and bump map data off the render
+ * thread. Textures are still created by the render thread when it takes
+ * the result of a finished job.
+ **/
+typedef struct raster_pool raster_pool;
+typedef struct raster_job raster_job;
+
+/**
+ * Runs on a worker thread and returns the result for the render thread.
+ * Should give up early once raster_job_cancelled is true.
+ **/
+typedef void *raster_job_run(void *args, raster_job *job);
+typedef void raster_job_free(void *data);
+
+raster_pool *raster_pool_new(int n_threads);
+void raster_pool_free(raster_pool *pool);
+
+raster_job *raster_pool_submit(raster_pool *pool,
+                               raster_job_run *run,
+                               void *args,
+                               raster_job_free *free_args,
+                               raster_job_free *free_result);
+int raster_job_cancelled(raster_job *job);
+int raster_job_done(raster_job *job);
+void *raster_job_take(raster_job *job);
+void raster_job_cancel(raster_job *job);
+
+#endif // RASTER_POOL_H
@@ -21,7 +21,12 @@
 #include "../base/log_contexts.h"
 #include "../base/logging.h"
 #include "../base/util.h"
+#include "../util/sdl_util.h"
+#include "asset_cache.h"
+#include "frame_profiler.h"
+#include "raster_pool.h"
 #include <SDL2/SDL_image.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -29,6 +34,8 @@
 #define M_2_X_PI 6.28318530718
 #define VISIBLE_ANGLE 72.0
 #define TEXT_OBJ_LABEL_LINE_SPACING 0.8
+/* Room for updated arc lines to grow a little without a new texture */
+#define TEXT_OBJ_ARC_SLACK 8
 
 static int text_obj_read_utf8_char(const char *txt, int *idx, Uint16 *out) {
     unsigned char c = (unsigned char) txt[(*idx)++];
@@ -145,19 +152,42 @@ static int text_obj_label_radius(const text_obj *obj, int base_radius, int label
     return base_radius + (int) offset;
 }
 
+static void text_obj_drop_arc_texture(text_obj_line *line) {
+    if (line->arc_texture) {
+        SDL_DestroyTexture(line->arc_texture);
+        line->arc_texture = NULL;
+    }
+    line->arc_stale = 0;
+    line->arc_failed = 0;
+}
+
+/**
+ * The line has to be composed again. Its texture is reused, if the new
+ * line still fits.
+ **/
+static void text_obj_invalidate_arc_texture(text_obj_line *line) {
+    line->arc_stale = line->arc_texture != NULL;
+    line->arc_failed = 0;
+}
+
 static void text_obj_free_line(text_obj_line *line) {
     if (!line) {
         return;
     }
 
+    text_obj_drop_arc_texture(line);
+
     if (line->glyphs_objs) {
         for (int g = 0; g < line->n_glyphs; g++) {
             glyph_obj_free(line->glyphs_objs[g]);
         }
         free(line->glyphs_objs);
     }
+    free(line->codes);
 
     line->glyphs_objs = NULL;
+    line->codes = NULL;
+    line->font = NULL;
     line->n_glyphs = 0;
     line->width = 0;
     line->height = 0;
@@ -172,28 +202,106 @@ void text_obj_free(text_obj *obj) {
     }
 }
 
-void text_obj_update_cnt_rad(text_obj *obj, SDL_Point center, int radius,
-                             int line, int n_lines) {
-    if (obj) {
-        int base_radius = radius + 0.8 * text_obj_line_height(obj) * (line + 0.5 * (n_lines - 1));
+static int text_obj_line_radius(const text_obj *obj, int radius, int label_line) {
+    int base_radius = radius + 0.8 * text_obj_line_height(obj) * (obj->line + 0.5 * (obj->n_menu_lines - 1));
+    return text_obj_label_radius(obj, base_radius, label_line);
+}
 
+/**
+ * Places the glyphs for the dial center and label radius. Only labels
+ * that are drawn are placed, when text_obj_draw finds they moved.
+ **/
+static void text_obj_layout(text_obj *obj, SDL_Point center, int radius) {
+    if (obj) {
         obj->n_lines = text_obj_count_lines(obj);
         for (int l = 0; l < obj->n_lines; l++) {
-            int line_radius = text_obj_label_radius(obj, base_radius, l);
+            int line_radius = text_obj_line_radius(obj, radius, l);
+            text_obj_drop_arc_texture(&obj->lines[l]);
             for (int g = 0; g < obj->lines[l].n_glyphs; g++) {
                 glyph_obj_update_cnt_rad(obj->lines[l].glyphs_objs[g], center, line_radius);
             }
         }
+        obj->layout_center = center;
+        obj->layout_radius = radius;
     }
 }
 
-static int text_obj_build_icon_line(text_obj *t,
-                                    SDL_Renderer *renderer,
-                                    const char *icon,
-                                    SDL_Point center,
-                                    int radius,
-                                    int bump_map) {
-    SDL_Surface *text_surface = IMG_Load(icon);
+/**
+ * The pixels of one glyph, rendered ahead. Atlas glyphs only carry their
+ * code, the atlas renders them itself the first time they are used.
+ **/
+typedef struct text_obj_glyph_raster {
+    Uint16 c;
+    SDL_Surface *surface;
+    bumpmap_data *bumpmap;
+    glyph_metrics metrics;
+} text_obj_glyph_raster;
+
+typedef struct text_obj_line_raster {
+    TTF_Font *font;
+    int n_glyphs;
+    int width;
+    int height;
+    text_obj_glyph_raster *glyphs;
+} text_obj_line_raster;
+
+struct text_obj_raster {
+    int bump_map;
+    int n_frames; /* Icon frames, more than one for animated icons */
+    SDL_Surface **frames;
+    int *delays; /* Of animated icons (ms) */
+    bumpmap_data **frame_bumpmaps;
+    int icon_width;
+    int icon_height;
+    text_obj_line_raster lines[TEXT_OBJ_MAX_LINES];
+};
+
+void text_obj_raster_free(text_obj_raster *raster) {
+    if (!raster) {
+        return;
+    }
+
+    for (int f = 0; f < raster->n_frames; f++) {
+        if (raster->frames[f]) {
+            asset_cache_release_surface(raster->frames[f]);
+        }
+        if (raster->frame_bumpmaps) {
+            bumpmap_data_free(raster->frame_bumpmaps[f]);
+        }
+    }
+    free(raster->frames);
+    free(raster->delays);
+    free(raster->frame_bumpmaps);
+
+    for (int l = 0; l < TEXT_OBJ_MAX_LINES; l++) {
+        text_obj_line_raster *line = &raster->lines[l];
+        for (int g = 0; g < line->n_glyphs && line->glyphs; g++) {
+            if (line->glyphs[g].surface) {
+                SDL_FreeSurface(line->glyphs[g].surface);
+            }
+            bumpmap_data_free(line->glyphs[g].bumpmap);
+        }
+        free(line->glyphs);
+    }
+
+    free(raster);
+}
+
+/**
+ * Takes the TTF lock unless the job has been cancelled, its fonts may be
+ * gone then
+ **/
+static int text_obj_lock_ttf(raster_job *job) {
+    my_LockTTF();
+    if (raster_job_cancelled(job)) {
+        my_UnlockTTF();
+        return 0;
+    }
+    return 1;
+}
+
+static int text_obj_rasterize_icon(text_obj_raster *raster, const char *icon) {
+    SDL_Surface *text_surface = asset_cache_load_surface(icon);
     if (text_surface == NULL) {
         log_error(MENU_CTX, "Could not create text surface for \"icon=[%s]\": %s\n",
                   icon,
@@ -201,60 +309,49 @@ static int text_obj_build_icon_line(text_obj *t,
         return 0;
     }
 
-    t->lines[0].n_glyphs = 1;
-    t->lines[0].glyphs_objs = calloc(1, sizeof(glyph_obj *));
-    t->lines[0].width = text_surface->w;
-    t->lines[0].height = text_surface->h;
+    raster->icon_width = text_surface->w;
+    raster->icon_height = text_surface->h;
 
-    IMG_Animation *animation = IMG_LoadAnimation(icon);
-    if (animation && animation->count > 1) {
-        t->lines[0].glyphs_objs[0] = glyph_obj_new_animated(renderer,
-                                                            animation->frames,
-                                                            animation->count,
-                                                            center,
-                                                            radius,
-                                                            bump_map);
-        free(animation->frames);
-        free(animation->delays);
-        free(animation);
-        SDL_FreeSurface(text_surface);
+    raster->n_frames = asset_cache_load_animation(icon, &raster->frames, &raster->delays);
+    if (raster->n_frames > 1) {
+        asset_cache_release_surface(text_surface);
     } else {
-        if (animation) {
-            IMG_FreeAnimation(animation);
-        }
-        t->lines[0].glyphs_objs[0] = glyph_obj_new_surface(renderer,
-                                                           text_surface,
-                                                           center,
-                                                           radius,
-                                                           bump_map);
+        raster->n_frames = 1;
+        raster->frames = calloc(1, sizeof(SDL_Surface *));
+        raster->frames[0] = text_surface;
     }
 
-    if (!t->lines[0].glyphs_objs[0]) {
-        log_error(MENU_CTX, "Could not create glyph object for icon %s\n", icon);
-        return 0;
+    /* Animated glyphs compute the bump map data of the frames they show */
+    if (raster->bump_map && raster->n_frames == 1) {
+        raster->frame_bumpmaps = calloc(raster->n_frames, sizeof(bumpmap_data *));
+        for (int f = 0; f < raster->n_frames; f++) {
+            raster->frame_bumpmaps[f] = bumpmap_data_new_from_surface(raster->frames[f]);
+        }
     }
 
     return 1;
 }
 
-static int text_obj_build_text_line(text_obj *t,
-                                    int line,
-                                    SDL_Renderer *renderer,
-                                    Uint16 *unicode_text,
-                                    Uint32 n_glyphs,
-                                    TTF_Font *font,
-                                    SDL_Color fg,
-                                    SDL_Point center,
-                                    int radius,
-                                    int bump_map,
-                                    const char *txt) {
+static int text_obj_rasterize_line(text_obj_raster *raster,
+                                   int line,
+                                   Uint16 *unicode_text,
+                                   Uint32 n_glyphs,
+                                   TTF_Font *font,
+                                   const char *txt,
+                                   raster_job *job) {
+    SDL_Color white = {255, 255, 255, 255};
+    text_obj_line_raster *l = &raster->lines[line];
     SDL_Surface *text_surface;
 
     if (n_glyphs == 0 || unicode_text == NULL) {
         return 1;
     }
 
-    text_surface = TTF_RenderUNICODE_Blended(font, unicode_text, fg);
+    if (!text_obj_lock_ttf(job)) {
+        return 0;
+    }
+    text_surface = TTF_RenderUNICODE_Blended(font, unicode_text, white);
+    my_UnlockTTF();
     if (text_surface == NULL) {
         log_error(MENU_CTX,
                   "Could not create glyph surface for %s (line = %d, unicode_length = %d): %s\n",
@@ -265,18 +362,184 @@ static int text_obj_build_text_line(text_obj *t,
         return 0;
     }
 
-    t->lines[line].n_glyphs = n_glyphs;
-    t->lines[line].glyphs_objs = calloc(n_glyphs, sizeof(glyph_obj *));
-    t->lines[line].width = text_surface->w;
-    t->lines[line].height = text_surface->h;
+    l->font = font;
+    l->n_glyphs = n_glyphs;
+    l->glyphs = calloc(n_glyphs, sizeof(text_obj_glyph_raster));
+    l->width = text_surface->w;
+    l->height = text_surface->h;
     log_debug(MENU_CTX, "SDL_FreeSurface(text_surface => %p) (line %d);\n", text_surface, line);
     SDL_FreeSurface(text_surface);
 
     for (Uint32 i = 0; i < n_glyphs; i++) {
-        t->lines[line].glyphs_objs[i]
-            = glyph_obj_new(renderer, unicode_text[i], font, fg, center, radius, bump_map);
+        text_obj_glyph_raster *g = &l->glyphs[i];
+        g->c = unicode_text[i];
+
+        /* Bump mapped glyphs need their own pixels */
+        if (!raster->bump_map) {
+            continue;
+        }
+
+        if (!text_obj_lock_ttf(job)) {
+            return 0;
+        }
+        g->surface = TTF_RenderGlyph_Blended(font, g->c, white);
+        TTF_GlyphMetrics(font, g->c, &g->metrics.minx, &g->metrics.maxx,
+                         &g->metrics.miny, &g->metrics.maxy, &g->metrics.advance);
+        my_UnlockTTF();
+
+        if (!g->surface) {
+            log_error(MENU_CTX, "Could not render glyph %c: %s\n", g->c, TTF_GetError());
+            return 0;
+        }
+        g->bumpmap = bumpmap_data_new_from_surface(g->surface);
+    }
+
+    return 1;
+}
+
+/**
+ * Renders everything of a label that doesn't need the renderer: the
+ * glyph pixels, their bump map data and icons. Safe to call from a
+ * raster worker (job may be NULL otherwise). Returns NULL on errors, if
+ * the job has been cancelled or if there is nothing to show.
+ **/
+text_obj_raster *text_obj_rasterize(const char *txt,
+                                    const char *icon,
+                                    TTF_Font *font,
+                                    TTF_Font *font_2nd_line,
+                                    int bump_map,
+                                    raster_job *job) {
+    if (!((txt && strlen(txt) > 0) || (icon && strlen(icon) > 0))) {
+        log_info(MENU_CTX, "No icon and not label provided\n");
+        return NULL;
+    }
+
+    Uint16 *unicode_lines[TEXT_OBJ_MAX_LINES] = {0};
+    Uint32 unicode_lengths[TEXT_OBJ_MAX_LINES] = {0};
+    text_obj_raster *raster = calloc(1, sizeof(text_obj_raster));
+    raster->bump_map = bump_map;
+
+    if (txt) {
+        text_obj_decode_lines(txt, unicode_lines, unicode_lengths);
+    }
+
+    if (icon) {
+        free(unicode_lines[TEXT_OBJ_MAX_LINES - 1]);
+        for (int i = TEXT_OBJ_MAX_LINES - 1; i > 1; i--) {
+            unicode_lines[i] = unicode_lines[i - 1];
+            unicode_lengths[i] = unicode_lengths[i - 1];
+        }
+        unicode_lines[1] = unicode_lines[0];
+        unicode_lengths[1] = unicode_lengths[0];
+        unicode_lines[0] = NULL;
+        unicode_lengths[0] = 0;
+
+        if (!text_obj_rasterize_icon(raster, icon)) {
+            text_obj_free_unicode_lines(unicode_lines);
+            text_obj_raster_free(raster);
+            return NULL;
+        }
+    }
+
+    for (int i = icon ? 1 : 0; i < TEXT_OBJ_MAX_LINES; i++) {
+        TTF_Font *line_font = i == 0 ? font : font_2nd_line;
+        if (!line_font) {
+            line_font = font;
+        }
+        if (!line_font && unicode_lengths[i] > 0) {
+            log_error(MENU_CTX, "Could not render text line %d for %s: no font available\n", i, txt);
+            text_obj_free_unicode_lines(unicode_lines);
+            text_obj_raster_free(raster);
+            return NULL;
+        }
+        if (!text_obj_rasterize_line(raster, i, unicode_lines[i], unicode_lengths[i], line_font, txt, job)) {
+            text_obj_free_unicode_lines(unicode_lines);
+            text_obj_raster_free(raster);
+            return NULL;
+        }
+    }
+
+    text_obj_free_unicode_lines(unicode_lines);
+
+    return raster;
+}
+
+static int text_obj_upload_icon(text_obj *t,
+                                SDL_Renderer *renderer,
+                                text_obj_raster *raster,
+                                SDL_Point center,
+                                int radius) {
+    t->lines[0].n_glyphs = 1;
+    t->lines[0].glyphs_objs = calloc(1, sizeof(glyph_obj *));
+    t->lines[0].width = raster->icon_width;
+    t->lines[0].height = raster->icon_height;
+
+    if (raster->n_frames > 1) {
+        t->lines[0].glyphs_objs[0] = glyph_obj_new_animated(renderer,
+                                                            raster->frames,
+                                                            raster->delays,
+                                                            raster->n_frames,
+                                                            center,
+                                                            radius,
+                                                            raster->bump_map);
+    } else {
+        t->lines[0].glyphs_objs[0] = glyph_obj_new_surface(renderer,
+                                                           raster->frames[0],
+                                                           raster->frame_bumpmaps ? raster->frame_bumpmaps[0] : NULL,
+                                                           center,
+                                                           radius,
+                                                           raster->bump_map);
+    }
+
+    /* The glyph owns the frames now */
+    free_and_set_null((void **) &raster->frames);
+    free_and_set_null((void **) &raster->frame_bumpmaps);
+    raster->n_frames = 0;
+
+    if (!t->lines[0].glyphs_objs[0]) {
+        log_error(MENU_CTX, "Could not create glyph object for icon\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+static int text_obj_upload_line(text_obj *t,
+                                int line,
+                                SDL_Renderer *renderer,
+                                text_obj_raster *raster,
+                                SDL_Point center,
+                                int radius) {
+    text_obj_line_raster *l = &raster->lines[line];
+
+    if (l->n_glyphs == 0) {
+        return 1;
+    }
+
+    t->lines[line].n_glyphs = l->n_glyphs;
+    t->lines[line].glyphs_objs = calloc(l->n_glyphs, sizeof(glyph_obj *));
+    t->lines[line].codes = calloc(l->n_glyphs, sizeof(Uint16));
+    t->lines[line].font = l->font;
+    t->lines[line].width = l->width;
+    t->lines[line].height = l->height;
+
+    for (int i = 0; i < l->n_glyphs; i++) {
+        text_obj_glyph_raster *g = &l->glyphs[i];
+        t->lines[line].codes[i] = g->c;
+        t->lines[line].glyphs_objs[i] = glyph_obj_new_rendered(renderer,
+                                                               t->atlas,
+                                                               g->c,
+                                                               l->font,
+                                                               g->surface,
+                                                               g->bumpmap,
+                                                               &g->metrics,
+                                                               center,
+                                                               radius,
+                                                               raster->bump_map);
+        g->surface = NULL;
+        g->bumpmap = NULL;
         if (!t->lines[line].glyphs_objs[i]) {
-            log_error(MENU_CTX, "Could not create glyph object for %c\n", unicode_text[i]);
+            log_error(MENU_CTX, "Could not create glyph object for %c\n", g->c);
             return 0;
         }
     }
@@ -284,12 +547,53 @@ static int text_obj_build_text_line(text_obj *t,
     return 1;
 }
 
+/**
+ * Creates the textures of a rasterized label, must run on the render
+ * thread. Frees the raster.
+ **/
+text_obj *text_obj_upload(SDL_Renderer *renderer,
+                          glyph_atlas *atlas,
+                          text_obj_raster *raster,
+                          SDL_Point center,
+                          int radius,
+                          int line,
+                          int n_lines) {
+    if (!raster) {
+        return NULL;
+    }
+
+    text_obj *t = calloc(1, sizeof(text_obj));
+    t->atlas = atlas;
+    t->bump_map = raster->bump_map;
+    t->icon = raster->n_frames > 0;
+
+    int ok = raster->n_frames == 0 || text_obj_upload_icon(t, renderer, raster, center, radius);
+
+    for (int i = 0; ok && i < TEXT_OBJ_MAX_LINES; i++) {
+        ok = text_obj_upload_line(t, i, renderer, raster, center, radius);
+    }
+
+    text_obj_raster_free(raster);
+
+    if (!ok) {
+        text_obj_free(t);
+        return NULL;
+    }
+
+    t->n_lines = text_obj_count_lines(t);
+    t->line = line;
+    t->n_menu_lines = n_lines;
+    text_obj_layout(t, center, radius);
+
+    return t;
+}
+
 text_obj *text_obj_new(SDL_Renderer *renderer,
+                       glyph_atlas *atlas,
                        char *txt,
                        char *icon,
                        TTF_Font *font,
                        TTF_Font *font_2nd_line,
-                       SDL_Color fg,
                        SDL_Point center,
                        int radius,
                        int line,
@@ -300,82 +604,352 @@ text_obj *text_obj_new(SDL_Renderer *renderer,
     (void) light_x;
     (void) light_y;
 
-    if ((txt && strlen(txt) > 0) || (icon && strlen(icon) > 0)) {
-        Uint16 *unicode_lines[TEXT_OBJ_MAX_LINES] = {0};
-        Uint32 unicode_lengths[TEXT_OBJ_MAX_LINES] = {0};
-        text_obj *t = calloc(1, sizeof(text_obj));
+    text_obj_raster *raster = text_obj_rasterize(txt, icon, font, font_2nd_line, bump_map, NULL);
+
+    return text_obj_upload(renderer, atlas, raster, center, radius, line, n_lines);
+}
 
-        if (txt) {
-            text_obj_decode_lines(txt, unicode_lines, unicode_lengths);
+/**
+ * The changed run of one line in text_obj_update: the old glyphs before
+ * and after it are kept, the glyphs in between are created anew
+ **/
+typedef struct text_obj_line_update {
+    int changed;
+    int prefix;
+    int suffix;
+    int n_new;
+    glyph_obj **new_glyphs;
+    TTF_Font *font;
+    int width;
+    int height;
+} text_obj_line_update;
+
+static void text_obj_free_line_updates(text_obj_line_update *updates) {
+    for (int l = 0; l < TEXT_OBJ_MAX_LINES; l++) {
+        for (int i = 0; i < updates[l].n_new && updates[l].new_glyphs; i++) {
+            glyph_obj_free(updates[l].new_glyphs[i]);
         }
+        free(updates[l].new_glyphs);
+        updates[l].new_glyphs = NULL;
+    }
+}
 
-        if (icon) {
-            free(unicode_lines[TEXT_OBJ_MAX_LINES - 1]);
-            for (int i = TEXT_OBJ_MAX_LINES - 1; i > 1; i--) {
-                unicode_lines[i] = unicode_lines[i - 1];
-                unicode_lengths[i] = unicode_lengths[i - 1];
-            }
-            unicode_lines[1] = unicode_lines[0];
-            unicode_lengths[1] = unicode_lengths[0];
-            unicode_lines[0] = NULL;
-            unicode_lengths[0] = 0;
-
-            if (!text_obj_build_icon_line(t, renderer, icon, center, radius, bump_map)) {
-                text_obj_free_unicode_lines(unicode_lines);
-                text_obj_free(t);
-                return NULL;
-            }
+/**
+ * Changes the text of a label in place. The glyphs of characters that are
+ * the same at the start and the end of each line are kept, only the run
+ * in between gets new glyphs. Returns 0 and leaves obj as it is, if the
+ * label can't be updated in place (icons, other fonts) and has to be
+ * built again.
+ **/
+int text_obj_update(SDL_Renderer *renderer,
+                    text_obj *obj,
+                    const char *txt,
+                    TTF_Font *font,
+                    TTF_Font *font_2nd_line) {
+    SDL_Color white = {255, 255, 255, 255};
+
+    if (!obj || obj->icon) {
+        return 0;
+    }
+
+    Uint16 *unicode_lines[TEXT_OBJ_MAX_LINES] = {0};
+    Uint32 unicode_lengths[TEXT_OBJ_MAX_LINES] = {0};
+    text_obj_line_update updates[TEXT_OBJ_MAX_LINES];
+    int ok = 1;
+
+    memset(updates, 0, sizeof(updates));
+
+    if (txt) {
+        text_obj_decode_lines(txt, unicode_lines, unicode_lengths);
+    }
+
+    for (int l = 0; ok && l < TEXT_OBJ_MAX_LINES; l++) {
+        text_obj_line *line = &obj->lines[l];
+        text_obj_line_update *u = &updates[l];
+        Uint16 *codes = unicode_lines[l];
+        int n = (int) unicode_lengths[l];
+        TTF_Font *line_font = l == 0 ? font : font_2nd_line;
+
+        if (!line_font) {
+            line_font = font;
         }
 
-        for (int i = icon ? 1 : 0; i < TEXT_OBJ_MAX_LINES; i++) {
-            TTF_Font *line_font = i == 0 ? font : font_2nd_line;
-            if (!line_font) {
-                line_font = font;
-            }
-            if (!line_font && unicode_lengths[i] > 0) {
-                log_error(MENU_CTX, "Could not render text line %d for %s: no font available\n", i, txt);
-                text_obj_free_unicode_lines(unicode_lines);
-                text_obj_free(t);
-                return NULL;
+        if (n > 0 && (!line_font || (line->n_glyphs > 0 && line->font != line_font))) {
+            ok = 0;
+            break;
+        }
+
+        while (u->prefix < n && u->prefix < line->n_glyphs
+               && codes[u->prefix] == line->codes[u->prefix]) {
+            u->prefix++;
+        }
+        while (u->suffix < n - u->prefix && u->suffix < line->n_glyphs - u->prefix
+               && codes[n - 1 - u->suffix] == line->codes[line->n_glyphs - 1 - u->suffix]) {
+            u->suffix++;
+        }
+
+        if (u->prefix == n && n == line->n_glyphs) {
+            continue;
+        }
+
+        u->changed = 1;
+        u->font = line_font;
+        u->n_new = n - u->prefix - u->suffix;
+        if (u->n_new > 0) {
+            u->new_glyphs = calloc(u->n_new, sizeof(glyph_obj *));
+        }
+        for (int i = 0; i < u->n_new; i++) {
+            u->new_glyphs[i] = glyph_obj_new(renderer,
+                                             obj->atlas,
+                                             codes[u->prefix + i],
+                                             line_font,
+                                             white,
+                                             obj->layout_center,
+                                             obj->layout_radius,
+                                             obj->bump_map);
+            if (!u->new_glyphs[i]) {
+                log_error(MENU_CTX, "Could not create glyph object for %c\n", codes[u->prefix + i]);
+                ok = 0;
+                break;
             }
-            if (!text_obj_build_text_line(t,
-                                          i,
-                                          renderer,
-                                          unicode_lines[i],
-                                          unicode_lengths[i],
-                                          line_font,
-                                          fg,
-                                          center,
-                                          radius,
-                                          bump_map,
-                                          txt)) {
-                text_obj_free_unicode_lines(unicode_lines);
-                text_obj_free(t);
-                return NULL;
+        }
+
+        if (ok && n > 0) {
+            my_LockTTF();
+            if (TTF_SizeUNICODE(line_font, codes, &u->width, &u->height) != 0) {
+                log_error(MENU_CTX, "Could not measure %s (line = %d): %s\n", txt, l, TTF_GetError());
+                ok = 0;
             }
+            my_UnlockTTF();
         }
+    }
 
-        t->n_lines = text_obj_count_lines(t);
-        text_obj_update_cnt_rad(t, center, radius, line, n_lines);
+    if (!ok) {
+        text_obj_free_line_updates(updates);
         text_obj_free_unicode_lines(unicode_lines);
+        return 0;
+    }
+
+    int n_lines = obj->n_lines;
+    int line_height = text_obj_line_height(obj);
+
+    for (int l = 0; l < TEXT_OBJ_MAX_LINES; l++) {
+        text_obj_line *line = &obj->lines[l];
+        text_obj_line_update *u = &updates[l];
+        int n = (int) unicode_lengths[l];
+
+        if (!u->changed) {
+            continue;
+        }
+
+        glyph_obj **glyphs = n > 0 ? calloc(n, sizeof(glyph_obj *)) : NULL;
+        for (int i = 0; i < u->prefix; i++) {
+            glyphs[i] = line->glyphs_objs[i];
+        }
+        for (int i = 0; i < u->n_new; i++) {
+            glyphs[u->prefix + i] = u->new_glyphs[i];
+        }
+        for (int i = 0; i < u->suffix; i++) {
+            glyphs[n - u->suffix + i] = line->glyphs_objs[line->n_glyphs - u->suffix + i];
+        }
+        for (int i = u->prefix; i < line->n_glyphs - u->suffix; i++) {
+            glyph_obj_free(line->glyphs_objs[i]);
+        }
 
-        return t;
+        free(line->glyphs_objs);
+        free(line->codes);
+        free(u->new_glyphs);
+        u->new_glyphs = NULL;
+
+        line->glyphs_objs = glyphs;
+        line->codes = unicode_lines[l];
+        unicode_lines[l] = NULL;
+        line->n_glyphs = n;
+        line->font = n > 0 ? u->font : NULL;
+        line->width = u->width;
+        line->height = u->height;
+        text_obj_invalidate_arc_texture(line);
+    }
 
+    text_obj_free_unicode_lines(unicode_lines);
+
+    if (text_obj_count_lines(obj) != n_lines || text_obj_line_height(obj) != line_height) {
+        text_obj_layout(obj, obj->layout_center, obj->layout_radius);
     } else {
-        log_info(MENU_CTX, "No icon and not label provided\n");
+        /* Only the new glyphs have to be placed */
+        for (int l = 0; l < n_lines; l++) {
+            int line_radius = text_obj_line_radius(obj, obj->layout_radius, l);
+            for (int i = 0; i < updates[l].n_new; i++) {
+                glyph_obj_update_cnt_rad(obj->lines[l].glyphs_objs[updates[l].prefix + i],
+                                         obj->layout_center,
+                                         line_radius);
+            }
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Within a line every glyph sits at a fixed angle offset from the label
+ * angle, so the whole line rotates rigidly around the dial center. It can
+ * be composed once at label angle 0 and drawn with a single rotated copy.
+ * Only lines of white masks qualify, bump mapped glyphs and animated
+ * icons change with the angle or over time.
+ **/
+static int text_obj_line_composable(const text_obj_line *line, int font_bumpmap) {
+    if (font_bumpmap || line->arc_failed || line->n_glyphs == 0) {
+        return 0;
+    }
+
+    for (int c = 0; c < line->n_glyphs; c++) {
+        glyph_obj *glyph_obj = line->glyphs_objs[c];
+        if (!glyph_obj || !glyph_obj->tinted || glyph_obj->animated) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int text_obj_compose_line(SDL_Renderer *renderer, glyph_atlas *atlas, text_obj_line *line) {
+    glyph_obj *first = line->glyphs_objs[0];
+    double center_x = first->dst_rect->x + first->rot_center->x;
+    double center_y = first->dst_rect->y + first->rot_center->y;
+    double min_x = center_x, min_y = center_y, max_x = center_x, max_y = center_y;
+    double advance = -0.5 * line->width;
+
+    /* The bounding box of all glyphs rotated to their offsets */
+    for (int c = 0; c < line->n_glyphs; c++) {
+        glyph_obj *glyph_obj = line->glyphs_objs[c];
+        SDL_Rect *r = glyph_obj->dst_rect;
+        double a = 360.0 * (advance + 0.5 * r->w) / (M_2_X_PI * glyph_obj->radius);
+        double s = sin(a * M_PI / 180.0);
+        double co = cos(a * M_PI / 180.0);
+
+        for (int k = 0; k < 4; k++) {
+            double x = r->x + (k % 2) * r->w - center_x;
+            double y = r->y + (k / 2) * r->h - center_y;
+            double x_rot = co * x - s * y + center_x;
+            double y_rot = s * x + co * y + center_y;
+            min_x = x_rot < min_x ? x_rot : min_x;
+            max_x = x_rot > max_x ? x_rot : max_x;
+            min_y = y_rot < min_y ? y_rot : min_y;
+            max_y = y_rot > max_y ? y_rot : max_y;
+        }
+
+        advance += glyph_obj->advance;
+    }
+
+    line->arc_rect.x = (int) floor(min_x) - 1;
+    line->arc_rect.y = (int) floor(min_y) - 1;
+    line->arc_rect.w = (int) ceil(max_x) + 1 - line->arc_rect.x;
+    line->arc_rect.h = (int) ceil(max_y) + 1 - line->arc_rect.y;
+    line->arc_center.x = (int) lround(center_x) - line->arc_rect.x;
+    line->arc_center.y = (int) lround(center_y) - line->arc_rect.y;
+
+    if (line->arc_texture) {
+        int w, h;
+        SDL_QueryTexture(line->arc_texture, NULL, NULL, &w, &h);
+        if (w < line->arc_rect.w || h < line->arc_rect.h
+            || w > line->arc_rect.w + 2 * TEXT_OBJ_ARC_SLACK || h > line->arc_rect.h + 2 * TEXT_OBJ_ARC_SLACK) {
+            text_obj_drop_arc_texture(line);
+        }
+    }
+    line->arc_stale = 0;
+
+    if (!line->arc_texture) {
+        line->arc_texture = SDL_CreateTexture(renderer, DEFAULT_SDL_PIXELFORMAT, SDL_TEXTUREACCESS_TARGET,
+                                              line->arc_rect.w + TEXT_OBJ_ARC_SLACK,
+                                              line->arc_rect.h + TEXT_OBJ_ARC_SLACK);
+    }
+    if (!line->arc_texture) {
+        log_warning(MENU_CTX, "Could not create arc label texture (%dx%d): %s\n",
+                    line->arc_rect.w + TEXT_OBJ_ARC_SLACK, line->arc_rect.h + TEXT_OBJ_ARC_SLACK, SDL_GetError());
+        line->arc_failed = 1;
+        return 0;
+    }
+    SDL_SetTextureBlendMode(line->arc_texture, SDL_BLENDMODE_BLEND);
+
+    glyph_atlas_flush(atlas);
+
+    SDL_Texture *target = SDL_GetRenderTarget(renderer);
+    SDL_BlendMode blend_mode;
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+    SDL_GetRenderDrawBlendMode(renderer, &blend_mode);
+    SDL_SetRenderTarget(renderer, line->arc_texture);
+
+    /* Transparent white, so that blending the white glyphs keeps them white */
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 0);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+    SDL_RenderClear(renderer);
+
+    SDL_Color white = {255, 255, 255, 255};
+    advance = -0.5 * line->width;
+
+    for (int c = 0; c < line->n_glyphs; c++) {
+        glyph_obj *glyph_obj = line->glyphs_objs[c];
+        SDL_Rect dst = *glyph_obj->dst_rect;
+        double a = 360.0 * (advance + 0.5 * dst.w) / (M_2_X_PI * glyph_obj->radius);
+
+        dst.x -= line->arc_rect.x;
+        dst.y -= line->arc_rect.y;
+
+        if (glyph_obj->atlas_entry) {
+            glyph_atlas_draw(atlas, glyph_obj->atlas_entry, &dst, a, glyph_obj->rot_center, white);
+        } else {
+            SDL_SetTextureColorMod(glyph_obj->texture, 255, 255, 255);
+            SDL_SetTextureAlphaMod(glyph_obj->texture, 255);
+            SDL_RenderCopyEx(renderer, glyph_obj->texture, NULL, &dst, a, glyph_obj->rot_center, SDL_FLIP_NONE);
+        }
+
+        advance += glyph_obj->advance;
+    }
+
+    glyph_atlas_flush(atlas);
+    SDL_SetRenderTarget(renderer, target);
+    SDL_SetRenderDrawColor(renderer, r, g, b, a);
+    SDL_SetRenderDrawBlendMode(renderer, blend_mode);
+
+    return 1;
+}
+
+static int text_obj_arc_line_visible(const text_obj_line *line, double angle) {
+    glyph_obj *middle = line->glyphs_objs[line->n_glyphs / 2];
+    double half_span = 180.0 * line->width / (M_2_X_PI * middle->radius);
+
+    return angle + half_span >= -VISIBLE_ANGLE && angle - half_span <= VISIBLE_ANGLE;
+}
+
+static void text_obj_draw_arc_line(SDL_Renderer *renderer,
+                                   glyph_atlas *atlas,
+                                   text_obj_line *line,
+                                   double angle,
+                                   SDL_Color color) {
+    if (!text_obj_arc_line_visible(line, angle)) {
+        return;
     }
 
-    return NULL;
+    glyph_atlas_flush(atlas);
+
+    SDL_SetTextureColorMod(line->arc_texture, color.r, color.g, color.b);
+    SDL_SetTextureAlphaMod(line->arc_texture, color.a);
+    /* The texture may be bigger, the line is at its top left */
+    SDL_Rect src = {0, 0, line->arc_rect.w, line->arc_rect.h};
+    SDL_RenderCopyEx(renderer, line->arc_texture, &src, &line->arc_rect, angle,
+                     &line->arc_center, SDL_FLIP_NONE);
 }
 
 static void text_obj_draw_line_shadow(SDL_Renderer *renderer,
+                                      glyph_atlas *atlas,
                                       text_obj_line *line,
                                       int center_x,
                                       int center_y,
                                       double angle,
+                                      SDL_Color color,
                                       double light_x,
                                       double light_y,
-                                      int font_bumpmap,
                                       int shadow_offset,
                                       int shadow_alpha) {
     double advance = -0.5 * line->width;
@@ -385,57 +959,63 @@ static void text_obj_draw_line_shadow(SDL_Renderer *renderer,
         double crc;
         double a;
         SDL_Texture *texture;
-
-        glyph_obj_animation_update(glyph_obj);
+        SDL_Rect shadow_dst_rec;
+        Uint8 orig_a, orig_r, orig_g, orig_b;
 
         crc = M_2_X_PI * glyph_obj->radius;
         a = angle + 360.0 * (advance + 0.5 * glyph_obj->dst_rect->w) / crc;
+        advance += glyph_obj->advance;
 
-        if (a != glyph_obj->current_angle) {
-            glyph_obj_update_bumpmap_texture(renderer, glyph_obj, center_x,
-                                             center_y, a, light_x, light_y);
+        if (a < -VISIBLE_ANGLE || a > VISIBLE_ANGLE) {
+            continue;
         }
 
-        texture = font_bumpmap ? glyph_obj->bumpmap_overlay : glyph_obj->texture;
+        glyph_obj_update_light_direction(glyph_obj, center_x, center_y, a, light_x, light_y);
+
+        if (glyph_obj_draw_shadow(renderer, atlas, glyph_obj, a, shadow_offset, shadow_alpha)) {
+            continue;
+        }
+
+        /* Animated glyphs stack shadow_offset unlit copies */
+        glyph_atlas_flush(atlas);
+
+        texture = glyph_obj->texture;
         if (!texture) {
             continue;
         }
 
-        if (a >= -VISIBLE_ANGLE && a <= VISIBLE_ANGLE) {
-            Uint8 orig_a, orig_r, orig_g, orig_b;
-            SDL_Rect shadow_dst_rec;
-            SDL_GetTextureAlphaMod(texture, &orig_a);
-            SDL_GetTextureColorMod(texture, &orig_r, &orig_g, &orig_b);
-            SDL_SetTextureColorMod(texture, 0, 0, 0);
-
-            shadow_dst_rec.w = glyph_obj->dst_rect->w;
-            shadow_dst_rec.h = glyph_obj->dst_rect->h;
-
-            for (int so = shadow_offset; so > 0; so--) {
-                int sa = (shadow_offset - so + 1) * shadow_alpha / (shadow_offset);
-                SDL_SetTextureAlphaMod(texture, sa);
-                shadow_dst_rec.x = glyph_obj->dst_rect->x + so * glyph_obj->shadow_dx;
-                shadow_dst_rec.y = glyph_obj->dst_rect->y + so * glyph_obj->shadow_dy;
-                SDL_RenderCopyEx(renderer, texture, NULL, &shadow_dst_rec, a,
-                                 glyph_obj->rot_center, SDL_FLIP_NONE);
-            }
+        SDL_GetTextureAlphaMod(texture, &orig_a);
+        SDL_GetTextureColorMod(texture, &orig_r, &orig_g, &orig_b);
+        SDL_SetTextureColorMod(texture, 0, 0, 0);
 
-            SDL_SetTextureAlphaMod(texture, orig_a);
-            SDL_SetTextureColorMod(texture, orig_r, orig_g, orig_b);
+        shadow_dst_rec.w = glyph_obj->dst_rect->w;
+        shadow_dst_rec.h = glyph_obj->dst_rect->h;
+
+        for (int so = shadow_offset; so > 0; so--) {
+            int sa = (shadow_offset - so + 1) * shadow_alpha / (shadow_offset);
+            SDL_SetTextureAlphaMod(texture, sa);
+            shadow_dst_rec.x = glyph_obj->dst_rect->x + so * glyph_obj->shadow_dx;
+            shadow_dst_rec.y = glyph_obj->dst_rect->y + so * glyph_obj->shadow_dy;
+            SDL_RenderCopyEx(renderer, texture, NULL, &shadow_dst_rec, a,
+                             glyph_obj->rot_center, SDL_FLIP_NONE);
         }
 
-        advance += glyph_obj->advance;
+        SDL_SetTextureAlphaMod(texture, orig_a);
+        SDL_SetTextureColorMod(texture, orig_r, orig_g, orig_b);
     }
 }
 
 static void text_obj_draw_line(SDL_Renderer *renderer,
+                               glyph_atlas *atlas,
                                text_obj_line *line,
                                int center_x,
                                int center_y,
                                double angle,
+                               SDL_Color color,
                                double light_x,
                                double light_y,
                                int font_bumpmap) {
+    SDL_Color white = {255, 255, 255, 255};
     double advance = -0.5 * line->width;
 
     for (int c = 0; c < line->n_glyphs; c++) {
@@ -444,18 +1024,26 @@ static void text_obj_draw_line(SDL_Renderer *renderer,
         double a = angle + 360.0 * (advance + 0.5 * glyph_obj->dst_rect->w) / crc;
 
         if (a >= -VISIBLE_ANGLE && a <= VISIBLE_ANGLE) {
-            if (font_bumpmap) {
+            SDL_Color glyph_color = glyph_obj->tinted ? color : white;
+            if (glyph_obj->atlas_entry) {
+                glyph_atlas_draw(atlas, glyph_obj->atlas_entry, glyph_obj->dst_rect, a,
+                                 glyph_obj->rot_center, glyph_color);
+            } else if (font_bumpmap && glyph_obj->bumpmap_gradients) {
+                glyph_atlas_flush(atlas);
+                glyph_obj_draw_linear_bumpmap(renderer, glyph_obj, center_x, center_y, a,
+                                              light_x, light_y, color);
+            } else if (font_bumpmap) {
                 SDL_Texture *texture;
-                if (a != glyph_obj->current_angle) {
-                    glyph_obj_update_bumpmap_texture(renderer, glyph_obj, center_x,
-                                                     center_y, a, light_x, light_y);
-                }
-
-                texture = glyph_obj->bumpmap_overlay;
+                glyph_atlas_flush(atlas);
+                texture = glyph_obj_get_bumpmap_texture(renderer, glyph_obj, center_x,
+                                                        center_y, a, light_x, light_y, color);
                 log_trace(MENU_CTX, "texture: %p\n", texture);
                 SDL_RenderCopyEx(renderer, texture, NULL, glyph_obj->dst_rect, a,
                                  glyph_obj->rot_center, SDL_FLIP_NONE);
             } else {
+                glyph_atlas_flush(atlas);
+                SDL_SetTextureColorMod(glyph_obj->texture, glyph_color.r, glyph_color.g, glyph_color.b);
+                SDL_SetTextureAlphaMod(glyph_obj->texture, glyph_color.a);
                 SDL_RenderCopyEx(renderer, glyph_obj->texture, NULL,
                                  glyph_obj->dst_rect, a, glyph_obj->rot_center,
                                  SDL_FLIP_NONE);
@@ -471,9 +1059,10 @@ static void text_obj_draw_line(SDL_Renderer *renderer,
 }
 
 void text_obj_draw(SDL_Renderer *renderer, SDL_Texture *target, text_obj *label,
-                   int radius, int center_x, int center_y, double angle,
-                   double light_x, double light_y, int font_bumpmap,
+                   SDL_Color color, int radius, int center_x, int center_y, double angle,
+                   double light_x, double light_y, int font_bumpmap, int arc_labels,
                    int shadow_offset, int shadow_alpha) {
+    int arc[TEXT_OBJ_MAX_LINES] = {0};
     double circumference = M_2_X_PI * radius;
 
     log_debug(MENU_CTX,
@@ -490,39 +1079,68 @@ void text_obj_draw(SDL_Renderer *renderer, SDL_Texture *target, text_obj *label,
         return;
     }
 
+    if (radius != label->layout_radius || center_x != label->layout_center.x
+        || center_y != label->layout_center.y) {
+        SDL_Point center = {center_x, center_y};
+        text_obj_layout(label, center, radius);
+    }
+
+    if (label->icon) {
+        glyph_obj_animation_update(renderer, label->lines[0].glyphs_objs[0], SDL_GetTicks());
+    }
+
     if (target != NULL) {
         SDL_SetRenderTarget(renderer, target);
     }
 
+    if (arc_labels) {
+        for (int l = 0; l < label->n_lines; l++) {
+            text_obj_line *line = &label->lines[l];
+            arc[l] = text_obj_line_composable(line, font_bumpmap)
+                     && ((line->arc_texture && !line->arc_stale)
+                         || text_obj_compose_line(renderer, label->atlas, line));
+        }
+    }
+
     if (shadow_offset > 0) {
+        Uint64 shadow_start = frame_profiler_now();
         for (int l = 0; l < label->n_lines; l++) {
             text_obj_draw_line_shadow(renderer,
+                                      label->atlas,
                                       &label->lines[l],
                                       center_x,
                                       center_y,
                                       angle,
+                                      color,
                                       light_x,
                                       light_y,
-                                      font_bumpmap,
                                       shadow_offset,
                                       shadow_alpha);
         }
+        frame_profiler_add(FRAME_PHASE_SHADOWS, shadow_start);
     } else {
         log_debug(MENU_CTX, "No shadow\n");
     }
 
     for (int l = 0; l < label->n_lines; l++) {
+        if (arc[l]) {
+            text_obj_draw_arc_line(renderer, label->atlas, &label->lines[l], angle, color);
+            continue;
+        }
         text_obj_draw_line(renderer,
+                           label->atlas,
                            &label->lines[l],
                            center_x,
                            center_y,
                            angle,
+                           color,
                            light_x,
                            light_y,
                            font_bumpmap);
     }
 
     if (target != NULL) {
+        glyph_atlas_flush(label->atlas);
         SDL_SetRenderTarget(renderer, NULL);
         SDL_RenderCopy(renderer, target, NULL, NULL);
     }
@@ -21,6 +21,7 @@
 #define TEXT_OBJ_H
 
 #include "glyph_obj.h"
+#include "raster_pool.h"
 
 #define TEXT_OBJ_MAX_LINES 3
 
@@ -30,24 +31,43 @@
 typedef struct text_obj_line {
     int n_glyphs;
     glyph_obj **glyphs_objs;
+    Uint16 *codes; /* The character of each glyph, NULL for icons */
+    TTF_Font *font;
     int width;
     int height;
+    SDL_Texture *arc_texture; /* The whole line composed at label angle 0 (arc labels) */
+    SDL_Rect arc_rect; /* The screen position of the line at label angle 0, the top left of arc_texture */
+    SDL_Point arc_center; /* The dial center relative to arc_rect */
+    int arc_stale; /* arc_texture is kept for the next compose, its content is outdated */
+    int arc_failed;
 } text_obj_line;
 
+/**
+* The pixels of a label rendered ahead, see text_obj_rasterize
+**/
+typedef struct text_obj_raster text_obj_raster;
+
 /**
 * Represents one text (menu item label)
 **/
 typedef struct text_obj {
+    glyph_atlas *atlas;
+    int bump_map;
+    int icon; /* The first line is an icon */
     int n_lines;
     text_obj_line lines[TEXT_OBJ_MAX_LINES];
+    int line; /* The menu line of the label and the number of menu lines */
+    int n_menu_lines;
+    SDL_Point layout_center; /* The glyphs are placed for this center and radius, see text_obj_draw */
+    int layout_radius;
 } text_obj;
 
 text_obj *text_obj_new(SDL_Renderer *renderer,
+                       glyph_atlas *atlas,
                        char *txt,
                        char *icon,
                        TTF_Font *font,
                        TTF_Font *font_2nd_line,
-                       SDL_Color fg,
                        SDL_Point center,
                        int radius,
                        int line,
@@ -55,8 +75,26 @@ text_obj *text_obj_new(SDL_Renderer *renderer,
                        int light_x,
                        int light_y,
                        int bump_map);
+text_obj_raster *text_obj_rasterize(const char *txt,
+                                    const char *icon,
+                                    TTF_Font *font,
+                                    TTF_Font *font_2nd_line,
+                                    int bump_map,
+                                    raster_job *job);
+void text_obj_raster_free(text_obj_raster *raster);
+text_obj *text_obj_upload(SDL_Renderer *renderer,
+                          glyph_atlas *atlas,
+                          text_obj_raster *raster,
+                          SDL_Point center,
+                          int radius,
+                          int line,
+                          int n_lines);
+int text_obj_update(SDL_Renderer *renderer,
+                    text_obj *obj,
+                    const char *txt,
+                    TTF_Font *font,
+                    TTF_Font *font_2nd_line);
 void text_obj_free(text_obj *obj);
-void text_obj_draw(SDL_Renderer *renderer, SDL_Texture *target, text_obj *label, int radius, int center_x, int center_y, double angle, double light_x, double light_y, int font_bumpmap, int shadow_offset, int shadow_alpha);
-void text_obj_update_cnt_rad(text_obj *obj, SDL_Point center, int radius, int line, int n_lines);
+void text_obj_draw(SDL_Renderer *renderer, SDL_Texture *target, text_obj *label, SDL_Color color, int radius, int center_x, int center_y, double angle, double light_x, double light_y, int font_bumpmap, int arc_labels, int shadow_offset, int shadow_alpha);
 
 #endif // TEXT_OBJ_H
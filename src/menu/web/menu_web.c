@@ -255,6 +255,14 @@ static void menu_web_append_item(menu_web_buffer *buf,
                                  unsigned long long revision,
                                  int *first);
 
+static void menu_web_append_virtual_entries(menu_web_buffer *buf,
+                                            menu *m,
+                                            const char *path,
+                                            menu *current,
+                                            unsigned long long revision,
+                                            int compact,
+                                            int *first);
+
 static void menu_web_append_menu_items(menu_web_buffer *buf,
                                        menu *m,
                                        const char *path,
@@ -262,6 +270,11 @@ static void menu_web_append_menu_items(menu_web_buffer *buf,
                                        unsigned long long revision) {
     int first = 1;
     menu_web_buffer_append(buf, "[");
+    if (menu_get_data_source(m, NULL)) {
+        menu_web_append_virtual_entries(buf, m, path, current, revision, 0, &first);
+        menu_web_buffer_append(buf, "]");
+        return;
+    }
     for (int i = 0; i <= menu_get_max_id(m); i++) {
         menu_item *item = menu_get_item(m, i);
         if (!item || !menu_item_get_visible(item)) {
@@ -275,8 +288,7 @@ static void menu_web_append_menu_items(menu_web_buffer *buf,
     menu_web_buffer_append(buf, "]");
 }
 
-static void menu_web_append_icon_url(menu_web_buffer *buf, menu_item *item, const char *path) {
-    const char *icon = menu_item_get_icon(item);
+static void menu_web_append_icon_path_url(menu_web_buffer *buf, const char *icon, const char *path) {
     char icon_url[320];
 
     if (icon && icon[0]) {
@@ -287,6 +299,10 @@ static void menu_web_append_icon_url(menu_web_buffer *buf, menu_item *item, cons
     }
 }
 
+static void menu_web_append_icon_url(menu_web_buffer *buf, menu_item *item, const char *path) {
+    menu_web_append_icon_path_url(buf, menu_item_get_icon(item), path);
+}
+
 static unsigned int menu_web_style_version(menu_ctrl *ctrl) {
     return ctrl ? ctrl->style_version : 0;
 }
@@ -366,10 +382,34 @@ static void menu_web_hash_item(unsigned long long *hash, menu_item *item) {
     }
 }
 
+/**
+ * Hashes the entries of a virtual menu like menu_web_hash_item would
+ * hash their items, without binding an item to each of them.
+ **/
+static void menu_web_hash_virtual_entries(unsigned long long *hash, menu *m) {
+    void *data = NULL;
+    const menu_data_source *source = menu_get_data_source(m, &data);
+
+    for (int i = 0; i <= menu_get_max_id(m); i++) {
+        const char *icon = source->icon_at ? source->icon_at(data, i) : NULL;
+        menu_web_hash_int(hash, 1);
+        menu_web_hash_int(hash, 1);
+        menu_web_hash_int(hash, i);
+        menu_web_hash_int(hash, menu_get_source_object_type(m));
+        menu_web_hash_int(hash, 0);
+        menu_web_hash_int(hash, icon ? 1 : 0);
+    }
+}
+
 static void menu_web_hash_menu(unsigned long long *hash, menu *m) {
     menu_web_hash_int(hash, menu_is_transient(m));
     menu_web_hash_int(hash, menu_get_max_id(m));
 
+    if (menu_get_data_source(m, NULL)) {
+        menu_web_hash_virtual_entries(hash, m);
+        return;
+    }
+
     for (int i = 0; i <= menu_get_max_id(m); i++) {
         menu_item *item = menu_get_item(m, i);
         menu_web_hash_int(hash, item ? 1 : 0);
@@ -405,10 +445,7 @@ static void menu_web_append_color(menu_web_buffer *buf, const SDL_Color *color)
     }
 }
 
-static const SDL_Color *menu_web_item_color(menu_item *item, menu *current) {
-    menu *m = menu_item_get_menu(item);
-    int id = menu_item_get_id(item);
-
+static const SDL_Color *menu_web_entry_color(menu *m, int id, menu *current) {
     if (menu_get_active_id(m) == id) {
         return menu_get_effective_active_color(m);
     }
@@ -418,6 +455,10 @@ static const SDL_Color *menu_web_item_color(menu_item *item, menu *current) {
     return menu_get_effective_default_color(m);
 }
 
+static const SDL_Color *menu_web_item_color(menu_item *item, menu *current) {
+    return menu_web_entry_color(menu_item_get_menu(item), menu_item_get_id(item), current);
+}
+
 static menu *menu_web_current_root(menu_ctrl *ctrl, int *index_out) {
     menu *first = NULL;
     menu *fallback = NULL;
@@ -495,6 +536,10 @@ static void menu_web_append_compact_menu(menu_web_buffer *buf,
                                          menu *current,
                                          unsigned int revision,
                                          int *first) {
+    if (menu_get_data_source(m, NULL)) {
+        menu_web_append_virtual_entries(buf, m, path, current, revision, 1, first);
+        return;
+    }
     for (int i = 0; i <= menu_get_max_id(m); i++) {
         menu_item *item = menu_get_item(m, i);
         char child_path[256];
@@ -513,6 +558,10 @@ static void menu_web_append_status_items(menu_web_buffer *buf,
                                          menu *current,
                                          unsigned int revision,
                                          int *first) {
+    if (menu_get_data_source(m, NULL)) {
+        menu_web_append_virtual_entries(buf, m, path, current, revision, 1, first);
+        return;
+    }
     for (int i = 0; i <= menu_get_max_id(m); i++) {
         menu_item *item = menu_get_item(m, i);
         menu *sub_menu;
@@ -740,6 +789,54 @@ static void menu_web_append_item(menu_web_buffer *buf,
     menu_web_buffer_append(buf, "}");
 }
 
+/**
+ * Appends the entries of a virtual menu straight from its data source.
+ * Binding an item to each of them would turn over the whole item pool
+ * on every request. The entries are leaves using the fonts of the menu.
+ **/
+static void menu_web_append_virtual_entries(menu_web_buffer *buf,
+                                            menu *m,
+                                            const char *path,
+                                            menu *current,
+                                            unsigned long long revision,
+                                            int compact,
+                                            int *first) {
+    void *data = NULL;
+    const menu_data_source *source = menu_get_data_source(m, &data);
+
+    for (int i = 0; i <= menu_get_max_id(m); i++) {
+        char child_path[256];
+
+        if (!*first) {
+            menu_web_buffer_append(buf, ",");
+        }
+        *first = 0;
+        snprintf(child_path, sizeof(child_path), "%s/%d", path, i);
+
+        menu_web_buffer_append(buf, "{\"path\":");
+        menu_web_buffer_append_json_string(buf, child_path);
+        menu_web_buffer_append(buf, ",\"label\":");
+        menu_web_buffer_append_json_string(buf, source->label_at(data, i));
+        menu_web_buffer_append(buf, ",\"icon\":");
+        menu_web_append_icon_path_url(buf, source->icon_at ? source->icon_at(data, i) : NULL, child_path);
+        menu_web_buffer_append(buf, ",\"font\":");
+        menu_web_append_menu_font_url(buf, m, child_path, revision);
+        menu_web_buffer_appendf(buf, ",\"font_size\":%d", menu_get_effective_font_size(m));
+        if (!compact) {
+            menu_web_buffer_appendf(buf, ",\"object_type\":%d", menu_get_source_object_type(m));
+        }
+        menu_web_buffer_appendf(buf,
+                                ",\"submenu\":false,\"current\":%s,\"active\":%s,\"color\":",
+                                m == current && menu_get_current_id(m) == i ? "true" : "false",
+                                menu_get_active_id(m) == i ? "true" : "false");
+        menu_web_append_color(buf, menu_web_entry_color(m, i, current));
+        if (!compact) {
+            menu_web_buffer_append(buf, ",\"children\":[]");
+        }
+        menu_web_buffer_append(buf, "}");
+    }
+}
+
 static char *menu_web_build_tree_json(menu_ctrl *ctrl) {
     menu_web_buffer buf = {0};
     menu *current = menu_ctrl_get_current(ctrl);
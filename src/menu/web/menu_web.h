@@ -20,6 +20,12 @@ extern "C" {
 
 typedef struct menu_web menu_web;
 
+/**
+ * The sockets are served by menu_web_poll on the thread running
+ * menu_ctrl_loop, which polls them at least this often while idle
+ **/
+#define MENU_WEB_POLL_INTERVAL_MS 50
+
 menu_web *menu_web_new(menu_ctrl *ctrl);
 void menu_web_poll(menu_web *web, int timeout_ms);
 void menu_web_free(menu_web *web);
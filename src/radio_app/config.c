@@ -60,6 +60,14 @@ void read_radio_config(
     config->light_img_x = get_config_value_int("light_image_x", 0);
     config->light_img_y = get_config_value_int("light_image_y", 0);
     config->warp_speed = get_config_value_int("warp_speed", 10);
+    config->turn_acceleration = get_config_value_int("turn_acceleration", 5);
+    config->transient_overlay = get_config_value_int("transient_overlay", 1);
+    config->bumpmap_cache_angle_step = get_config_value_int("bumpmap_cache_angle_step", 2);
+    config->bumpmap_cache_kb = get_config_value_int("bumpmap_cache_kb", 8192);
+    config->asset_cache_kb = get_config_value_int("asset_cache_kb", 16384);
+    config->arc_labels = get_config_value_int("arc_labels", 0);
+    config->callback_interval_ms = get_config_value_int("callback_interval_ms", 500);
+    config->frame_profiler_seconds = get_config_value_int("frame_profiler_seconds", 0);
     config->radio_radius_labels = get_config_value_int("radio_radius_labels", config->radius_labels);
     config->info_menu_item_seconds = get_config_value_int("info_menu_item_seconds",
                                                           INFO_MENU_ITEM_SECONDS);
@@ -52,6 +52,14 @@ typedef struct radio_config {
     int light_img_x;
     int light_img_y;
     int warp_speed;
+    int turn_acceleration;
+    int transient_overlay; /* Draw volume and messages over the active menu */
+    int bumpmap_cache_angle_step;
+    int bumpmap_cache_kb;
+    int asset_cache_kb;
+    int arc_labels;
+    int callback_interval_ms;
+    int frame_profiler_seconds;
     int alsa_enabled;
     char mixer_device[MAX_CONFIG_LINE_LENGTH];
     char alsa_mixer_name[MAX_CONFIG_LINE_LENGTH];
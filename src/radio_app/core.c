@@ -42,6 +42,12 @@ static struct radio_app *radio_app_new(
     return app;
 }
 
+/* Player and ALSA volume events are processed in menu_call_back */
+static void radio_app_player_event_notify(void *data) {
+    (void) data;
+    menu_ctrl_wakeup(app->ctrl);
+}
+
 static void radio_app_create_menu(
     const radio_config *config) {
     app->ctrl = menu_ctrl_new(config->w,
@@ -79,6 +85,16 @@ static void radio_app_create_menu(
     }
 
     menu_ctrl_set_warp_speed(app->ctrl, config->warp_speed);
+    menu_ctrl_set_turn_acceleration(app->ctrl, config->turn_acceleration);
+    menu_ctrl_set_bumpmap_cache(app->ctrl, config->bumpmap_cache_angle_step, config->bumpmap_cache_kb);
+    menu_ctrl_set_asset_cache(app->ctrl, config->asset_cache_kb);
+    menu_ctrl_set_arc_labels(app->ctrl, config->arc_labels);
+    menu_ctrl_set_callback_interval(app->ctrl, config->callback_interval_ms);
+    menu_ctrl_set_frame_profiler(app->ctrl, config->frame_profiler_seconds);
+    player_set_event_notify(radio_app_player_event_notify, NULL);
+#ifdef ALSA
+    alsa_set_event_notify(radio_app_player_event_notify, NULL);
+#endif
 
     /* Info Menu */
     init_info_menu(config);
@@ -88,6 +104,7 @@ static void radio_app_create_menu(
         = menu_new_root(app->ctrl, 1, config->info_font, config->info_font_size, NULL, 0);
     menu_set_label(app->message_menu, "Messages");
     menu_set_transient(app->message_menu, 1);
+    menu_set_overlay(app->message_menu, config->transient_overlay);
     menu_set_segments_per_item(app->message_menu, 1);
     app->message_menu_item = menu_item_new(
         app->message_menu, "", NULL, NULL, UNKNOWN_OBJECT_TYPE, NULL, 0, NULL, NULL, -1);
@@ -142,6 +159,7 @@ void radio_app_loop() {
 void radio_app_close() {
     menu_item_set_label(app->message_menu_item, "Bye");
     menu_item_warp_to(app->message_menu_item);
+    menu_ctrl_finish_animations(app->ctrl);
 
     log_info(MAIN_CTX, "Closing all\n");
     log_info(MAIN_CTX, "Stopping weather thread\n");
@@ -185,6 +203,10 @@ void radio_app_close() {
     log_info(MAIN_CTX, "Stopping audio\n");
     player_stop(app->radio_player);
     log_info(MAIN_CTX, "Audio stopped\n");
+    player_set_event_notify(NULL, NULL);
+#ifdef ALSA
+    alsa_set_event_notify(NULL, NULL);
+#endif
     radio_browser_menu_close();
     menu_ctrl_free(app->ctrl);
     if (app->radio_player) {
@@ -26,18 +26,22 @@
 
 void update_radio_menu(
     void) {
-    menu_clear(app->radio_menu);
-
     playlist *internet_radios = media_player_get_internet_radios();
     if (internet_radios != NULL) {
         menu_set_no_items_on_scale(app->radio_menu,
                                    RADIO_MENU_ITEMS_ON_SCALE_FACTOR
                                        * menu_ctrl_get_n_o_items_on_scale(app->ctrl));
+        menu_sync_entry *entries = calloc(internet_radios->n_songs + 1, sizeof(menu_sync_entry));
         unsigned int r = 0;
         for (r = 0; r < internet_radios->n_songs; r++) {
             song *s = internet_radios->songs[r];
-            menu_item_new(app->radio_menu, s->title, NULL, s, OBJ_TYPE_SONG, NULL, -1, NULL, NULL, -1);
+            entries[r].key = s->url ? s->url : s->title;
+            entries[r].label = s->title;
+            entries[r].object = s;
+            entries[r].object_type = OBJ_TYPE_SONG;
         }
+        menu_sync(app->radio_menu, entries, (int) internet_radios->n_songs);
+        free(entries);
 
         menu_item_set_sub_menu(app->radio_menu_item, app->radio_menu);
 
@@ -46,7 +50,8 @@ void update_radio_menu(
         free(internet_radios);
 
     } else {
-        menu_item_new(app->radio_menu, "No radio", NULL, NULL, 0, NULL, -1, NULL, NULL, -1);
+        menu_sync_entry no_radio = {.key = "", .label = "No radio"};
+        menu_sync(app->radio_menu, &no_radio, 1);
 
         log_error(MAIN_CTX, "create_menu: playlist is NULL\n");
     }
@@ -79,27 +79,39 @@ int item_action_update_network_menu(
     }
 
     menu *sub_menu = menu_item_get_sub_menu(item);
-    if (sub_menu) {
-        menu_clear(sub_menu);
+    if (!sub_menu) {
+        return 0;
     }
 
     network_interfaces *interfaces = get_network_interfaces();
+    int n = interfaces ? interfaces->n : 0;
+    menu_sync_entry *entries = calloc(n + 1, sizeof(menu_sync_entry));
+
+    for (int i = 0; i < n; i++) {
+        network_interface *interface = interfaces->interfaces[i];
+        interfaces->interfaces[i] = NULL;
+        entries[i].key = interface->ifname;
+        entries[i].label = interface->ifname;
+        entries[i].object = interface;
+        entries[i].object_type = UNKNOWN_OBJECT_TYPE;
+        entries[i].action = &item_action_update_interface_menu;
+    }
+    menu_sync(sub_menu, entries, n);
+    free(entries);
 
     if (interfaces) {
-        for (int i = 0; i < interfaces->n; i++) {
-            network_interface *interface = interfaces->interfaces[i];
-            interfaces->interfaces[i] = NULL;
+        free(interfaces->interfaces);
+        free(interfaces);
+    }
+
+    for (int i = 0; i <= menu_get_max_id(sub_menu); i++) {
+        menu_item *interface_item = menu_get_item(sub_menu, i);
+        if (!menu_item_get_sub_menu(interface_item)) {
             menu *interface_menu = menu_new(menu_get_ctrl(m), 1, NULL, 0, NULL, NULL, 0);
             menu_set_no_items_on_scale(interface_menu, 3);
-            menu_item *interface_item = menu_add_sub_menu(menu_item_get_sub_menu(item),
-                                                          interface->ifname,
-                                                          interface_menu,
-                                                          &item_action_update_interface_menu);
-            menu_item_set_user_data(interface_item, interface);
+            menu_set_label(interface_menu, menu_item_get_label(interface_item));
+            menu_item_set_sub_menu(interface_item, interface_menu);
         }
-
-        free(interfaces->interfaces);
-        free(interfaces);
     }
 
     return 0;
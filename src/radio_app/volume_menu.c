@@ -89,6 +89,7 @@ void init_mixer_menu(
         = menu_new_root(app->ctrl, 1, config->info_font, config->info_font_size, NULL, 0);
     menu_set_label(app->volume_menu, "Volume");
     menu_set_transient(app->volume_menu, 1);
+    menu_set_overlay(app->volume_menu, config->transient_overlay);
     menu_set_draw_only_active(app->volume_menu, 1);
 
     if (config->info_bg_image_path[0]) {
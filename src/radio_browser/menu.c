@@ -99,47 +99,110 @@ void radio_browser_play_station(radio_browser_station *station) {
     free(stream_url);
 }
 
-menu_item *radio_browser_add_station_item(menu *station_menu, radio_browser_station *station) {
-    char *label = radio_browser_station_label(station);
-    menu_item *station_item = menu_item_new(station_menu,
-                                            label,
-                                            NULL,
-                                            station,
-                                            OBJ_TYPE_RADIO_BROWSER_STATION,
-                                            NULL,
-                                            0,
-                                            &radio_browser_item_action,
-                                            NULL,
-                                            0);
-    menu_item_set_object_type(station_item, OBJ_TYPE_RADIO_BROWSER_STATION);
-    menu_item_set_user_data(station_item, station);
-    free(label);
-    return station_item;
+/**
+ * The stations of a station menu. Station lists can be long, so station
+ * menus are virtual menus reading from this instead of holding an item
+ * per station. An empty list shows a single "Keine Sender" entry.
+ **/
+typedef struct radio_browser_station_menu_data {
+    radio_browser_station **stations;
+    char **labels;
+    int n_stations;
+} radio_browser_station_menu_data;
+
+static int radio_browser_station_count(void *data) {
+    radio_browser_station_menu_data *d = data;
+    return d->n_stations > 0 ? d->n_stations : 1;
 }
 
-void radio_browser_fill_station_menu(menu *station_menu, radio_browser_station_list *list) {
+static const char *radio_browser_station_label_at(void *data, int index) {
+    radio_browser_station_menu_data *d = data;
+    return d->n_stations > 0 ? d->labels[index] : "Keine Sender";
+}
+
+static const void *radio_browser_station_object_at(void *data, int index) {
+    radio_browser_station_menu_data *d = data;
+    return d->n_stations > 0 ? d->stations[index] : NULL;
+}
+
+static void radio_browser_station_menu_data_clear(radio_browser_station_menu_data *d) {
+    for (int i = 0; i < d->n_stations; i++) {
+        radio_browser_station_free(d->stations[i]);
+        free(d->labels[i]);
+    }
+    free_and_set_null((void **) &d->stations);
+    free_and_set_null((void **) &d->labels);
+    d->n_stations = 0;
+}
+
+static void radio_browser_station_menu_data_free(void *data) {
+    radio_browser_station_menu_data_clear(data);
+    free(data);
+}
+
+static const menu_data_source radio_browser_station_source = {
+    .count = radio_browser_station_count,
+    .label_at = radio_browser_station_label_at,
+    .object_at = radio_browser_station_object_at,
+    .free_data = radio_browser_station_menu_data_free
+};
+
+static menu *radio_browser_station_menu_new(menu_ctrl *ctrl, const char *label) {
+    radio_browser_station_menu_data *data = calloc(1, sizeof(radio_browser_station_menu_data));
+    if (!data) {
+        log_error(MAIN_CTX, "Radio Browser: calloc failed\n");
+        return NULL;
+    }
+
+    menu *station_menu = menu_new_virtual(ctrl,
+                                          3,
+                                          radio_browser_config.font,
+                                          radio_browser_config.radio_browser_station_font_size,
+                                          &radio_browser_station_source,
+                                          data,
+                                          OBJ_TYPE_RADIO_BROWSER_STATION,
+                                          &radio_browser_item_action);
     if (!station_menu) {
-        return;
+        free(data);
+        return NULL;
     }
 
-    menu_clear(station_menu);
+    menu_set_label(station_menu, label);
     menu_set_no_items_on_scale(station_menu,
                                RADIO_MENU_ITEMS_ON_SCALE_FACTOR
-                                   * menu_ctrl_get_n_o_items_on_scale(menu_get_ctrl(station_menu)));
+                                   * menu_ctrl_get_n_o_items_on_scale(ctrl));
     menu_set_segments_per_item(station_menu, 1);
+    return station_menu;
+}
 
-    if (!list || list->n_stations == 0) {
-        menu_item_new(
-            station_menu, "Keine Sender", NULL, NULL, UNKNOWN_OBJECT_TYPE, NULL, 0, NULL, NULL, 0);
+void radio_browser_fill_station_menu(menu *station_menu, radio_browser_station_list *list) {
+    void *data = NULL;
+    if (!station_menu || !menu_get_data_source(station_menu, &data)) {
         return;
     }
 
-    for (unsigned int i = 0; i < list->n_stations; i++) {
-        radio_browser_station *station = radio_browser_station_clone(list->stations[i]);
-        if (station) {
-            radio_browser_add_station_item(station_menu, station);
+    radio_browser_station_menu_data *d = data;
+    radio_browser_station_menu_data_clear(d);
+
+    if (list && list->n_stations > 0) {
+        d->stations = calloc(list->n_stations, sizeof(radio_browser_station *));
+        d->labels = calloc(list->n_stations, sizeof(char *));
+        if (!d->stations || !d->labels) {
+            log_error(MAIN_CTX, "Radio Browser: calloc failed\n");
+            radio_browser_station_menu_data_clear(d);
+        } else {
+            for (unsigned int i = 0; i < list->n_stations; i++) {
+                radio_browser_station *station = radio_browser_station_clone(list->stations[i]);
+                if (station) {
+                    d->stations[d->n_stations] = station;
+                    d->labels[d->n_stations] = radio_browser_station_label(station);
+                    d->n_stations++;
+                }
+            }
         }
     }
+
+    menu_reload(station_menu);
 }
 
 void radio_browser_fill_entry_menu(menu *entry_menu,
@@ -149,42 +212,45 @@ void radio_browser_fill_entry_menu(menu *entry_menu,
         return;
     }
 
-    menu_clear(entry_menu);
     menu_set_no_items_on_scale(entry_menu,
                                RADIO_MENU_ITEMS_ON_SCALE_FACTOR
                                    * menu_ctrl_get_n_o_items_on_scale(menu_get_ctrl(entry_menu)));
     menu_set_segments_per_item(entry_menu, 1);
 
     if (!list || list->n_entries == 0) {
-        menu_item_new(
-            entry_menu, "Keine Treffer", NULL, NULL, UNKNOWN_OBJECT_TYPE, NULL, 0, NULL, NULL, 0);
+        menu_sync_entry none = {.key = "", .label = "Keine Treffer", .object_type = UNKNOWN_OBJECT_TYPE};
+        menu_sync(entry_menu, &none, 1);
         return;
     }
 
+    menu_sync_entry *entries = calloc(list->n_entries, sizeof(menu_sync_entry));
+    int n = 0;
     for (unsigned int i = 0; i < list->n_entries; i++) {
         radio_browser_entry *entry = radio_browser_entry_clone(list->entries[i]);
         if (!entry) {
             continue;
         }
-        menu *sub_menu = menu_new(menu_get_ctrl(entry_menu),
-                                  3,
-                                  radio_browser_config.font,
-                                  radio_browser_config.radio_browser_station_font_size,
-                                  &radio_browser_item_action,
-                                  NULL,
-                                  0);
-        menu_set_label(sub_menu, entry->label);
-        menu_set_no_items_on_scale(sub_menu,
-                                   RADIO_MENU_ITEMS_ON_SCALE_FACTOR
-                                       * menu_ctrl_get_n_o_items_on_scale(
-                                           menu_get_ctrl(entry_menu)));
-        menu_set_segments_per_item(sub_menu, 1);
-        menu_item *entry_item = menu_add_sub_menu(entry_menu,
-                                                  entry->label,
-                                                  sub_menu,
-                                                  &radio_browser_item_action);
-        menu_item_set_object_type(entry_item, object_type);
-        menu_item_set_user_data(entry_item, entry);
+        entries[n].key = entry->label;
+        entries[n].label = entry->label;
+        entries[n].object = entry;
+        entries[n].object_type = object_type;
+        entries[n].action = &radio_browser_item_action;
+        n++;
+    }
+    menu_sync(entry_menu, entries, n);
+    free(entries);
+
+    /* Entries that were there before keep their station menus */
+    for (int i = 0; i <= menu_get_max_id(entry_menu); i++) {
+        menu_item *entry_item = menu_get_item(entry_menu, i);
+        if (menu_item_get_sub_menu(entry_item)) {
+            continue;
+        }
+        menu *sub_menu = radio_browser_station_menu_new(menu_get_ctrl(entry_menu),
+                                                        menu_item_get_label(entry_item));
+        if (sub_menu) {
+            menu_item_set_sub_menu(entry_item, sub_menu);
+        }
     }
 }
 
@@ -223,10 +289,6 @@ int radio_browser_item_action(menu_event evt, menu *m, menu_item *item) {
             radio_browser_entry_free((radio_browser_entry *) menu_item_get_user_data(item));
             menu_item_set_user_data(item, NULL);
             break;
-        case OBJ_TYPE_RADIO_BROWSER_STATION:
-            radio_browser_station_free((radio_browser_station *) menu_item_get_user_data(item));
-            menu_item_set_user_data(item, NULL);
-            break;
         default:
             break;
         }
@@ -329,23 +391,14 @@ static menu *radio_browser_menu_new(menu_ctrl *ctrl,
     menu_set_no_items_on_scale(radio_browser_menu, 3);
     menu_set_segments_per_item(radio_browser_menu, 2);
 
-    menu *radio_browser_local_menu = menu_new(ctrl,
-                                              3,
-                                              radio_browser_config.font,
-                                              radio_browser_config.radio_browser_station_font_size,
-                                              &radio_browser_item_action,
-                                              NULL,
-                                              0);
-    menu_set_label(radio_browser_local_menu, "Lokal");
-    menu_set_no_items_on_scale(radio_browser_local_menu,
-                               RADIO_MENU_ITEMS_ON_SCALE_FACTOR
-                                   * menu_ctrl_get_n_o_items_on_scale(ctrl));
-    menu_set_segments_per_item(radio_browser_local_menu, 1);
-    menu_item *local_item = menu_add_sub_menu(radio_browser_menu,
-                                              "Lokal",
-                                              radio_browser_local_menu,
-                                              &radio_browser_item_action);
-    menu_item_set_object_type(local_item, OBJ_TYPE_RADIO_BROWSER_LOCAL);
+    menu *radio_browser_local_menu = radio_browser_station_menu_new(ctrl, "Lokal");
+    if (radio_browser_local_menu) {
+        menu_item *local_item = menu_add_sub_menu(radio_browser_menu,
+                                                  "Lokal",
+                                                  radio_browser_local_menu,
+                                                  &radio_browser_item_action);
+        menu_item_set_object_type(local_item, OBJ_TYPE_RADIO_BROWSER_LOCAL);
+    }
 
     menu *radio_browser_tag_menu = menu_new(ctrl, 3, NULL, 0, &radio_browser_item_action, NULL, 0);
     menu_set_label(radio_browser_tag_menu, "Kategorien");
@@ -34,6 +34,7 @@
 #include "../base/log_contexts.h"
 #include "../base/logging.h"
 #include <errno.h>
+#include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -73,6 +74,9 @@ void pi_renc_cancel(pi_renc_t *renc);
 static int queued_events;
 static int *event_queue;
 static int event_pointer;
+static encoder_notify *event_notify;
+static void *event_notify_data;
+static pthread_mutex_t event_notify_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 struct _pi_renc_s
 {
@@ -142,6 +146,21 @@ void enqueue_event(int event) {
     event_queue = new_queue;
     log_config(ENCODER_CTX, "enqueue_event: queued events: %d\n", queued_events);
     event_queue[queued_events++] = event;
+    pthread_mutex_lock(&event_notify_mutex);
+    if (event_notify) {
+        event_notify(event_notify_data);
+    }
+    pthread_mutex_unlock(&event_notify_mutex);
+}
+
+/**
+ * notify is called from the encoder thread after each queued event
+ **/
+void set_encoder_notify(encoder_notify *notify, void *data) {
+    pthread_mutex_lock(&event_notify_mutex);
+    event_notify_data = data;
+    event_notify = notify;
+    pthread_mutex_unlock(&event_notify_mutex);
 }
 
 static void push_button_timer_handler(union sigval sv) {
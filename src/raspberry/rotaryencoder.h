@@ -26,8 +26,11 @@
 #define BUTTON_B_TURNED_LEFT 21
 #define BUTTON_B_TURNED_RIGHT 22
 
+typedef void encoder_notify(void *data);
+
 void setup_encoder();
 int next_event();
+void set_encoder_notify(encoder_notify *notify, void *data);
 
 void print_binary(int binary);
 
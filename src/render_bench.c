@@ -0,0 +1,313 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * Headless rendering benchmark. Creates a menu_ctrl on SDL's dummy video
+ * driver with the software renderer, runs scripted dial scenarios and
+ * prints one JSON object per scenario and menu size.
+ *
+ * ve301-render-bench [-i items,...] [-l lines,...] [-s scenario,...]
+ *                    [-f frames] [-F font] [-w width]
+ *
+ * Scenarios: turn, warp, fade, turn_bumpmap, turn_shadow,
+ * turn_bumpmap_shadow
+ **/
+#include "base/log_contexts.h"
+#include "base/logging.h"
+#include "menu/menu.h"
+#include <SDL2/SDL.h>
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_VALUES 16
+#define DEFAULT_FRAMES 300
+
+/**
+ * Counts allocations by wrapping the allocator of glibc, including the
+ * ones made by SDL and its libraries
+ **/
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t n, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+static unsigned long allocations = 0;
+
+void *malloc(size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t n, size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(n, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+
+static unsigned long bench_allocations(void) {
+    return __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+}
+#define BENCH_COUNTS_ALLOCATIONS 1
+#else
+static unsigned long bench_allocations(void) {
+    return 0;
+}
+#define BENCH_COUNTS_ALLOCATIONS 0
+#endif
+
+typedef struct bench_options {
+    int items[MAX_VALUES];
+    int n_items;
+    int lines[MAX_VALUES];
+    int n_lines;
+    char *scenarios[MAX_VALUES];
+    int n_scenarios;
+    int frames;
+    const char *font;
+    int width;
+} bench_options;
+
+typedef struct bench_menu {
+    menu_ctrl *ctrl;
+    menu *root;
+    menu_item **items;
+    int n_items;
+    menu_item *sub_menu_item;
+    menu *sub_menu;
+} bench_menu;
+
+typedef struct bench_result {
+    int frames;
+    Uint64 ticks;
+    unsigned long allocations;
+} bench_result;
+
+static int parse_int_list(char *arg, int *values) {
+    int n = 0;
+    for (char *token = strtok(arg, ","); token && n < MAX_VALUES; token = strtok(NULL, ",")) {
+        values[n++] = atoi(token);
+    }
+    return n;
+}
+
+static int parse_string_list(char *arg, char **values) {
+    int n = 0;
+    for (char *token = strtok(arg, ","); token && n < MAX_VALUES; token = strtok(NULL, ",")) {
+        values[n++] = token;
+    }
+    return n;
+}
+
+static int set_effects(menu_ctrl *ctrl, int bumpmap, int shadow) {
+    return menu_ctrl_set_style(ctrl, "#08081e", "#c8c8c8", "#ff0000", "#525239", "#c8c864", "#c8c864",
+                               NULL, 1, bumpmap, shadow ? 3 : 0, 128, NULL, 0, NULL, 0);
+}
+
+static bench_menu *bench_menu_new(const bench_options *options, int n_items, int lines) {
+    bench_menu *b = calloc(1, sizeof(bench_menu));
+    char label[64];
+
+    b->ctrl = menu_ctrl_new(options->width, 0, 0, 0, 0.42 * options->width, 1,
+                            0.45 * options->width, 0.5 * options->width, 0.0,
+                            options->font, 36, 24, NULL, NULL);
+    if (!b->ctrl) {
+        free(b);
+        return NULL;
+    }
+
+    b->root = menu_new_root(b->ctrl, lines, NULL, 0, NULL, 0);
+    b->items = malloc(n_items * sizeof(menu_item *));
+    b->n_items = n_items;
+    for (int i = 0; i < n_items; i++) {
+        int len = snprintf(label, sizeof(label), "Station %d", i);
+        for (int l = 1; l < lines; l++) {
+            len += snprintf(label + len, sizeof(label) - len, "\nLine %d", l + 1);
+        }
+        b->items[i] = menu_item_new(b->root, label, NULL, NULL, UNKNOWN_OBJECT_TYPE, NULL, -1, NULL, NULL, -1);
+    }
+
+    b->sub_menu_item = menu_new_sub_menu(b->root, "Settings", NULL);
+    b->sub_menu = menu_item_get_sub_menu(b->sub_menu_item);
+    for (int i = 0; i < 10; i++) {
+        snprintf(label, sizeof(label), "Option %d", i);
+        menu_item_new(b->sub_menu, label, NULL, NULL, UNKNOWN_OBJECT_TYPE, NULL, -1, NULL, NULL, -1);
+    }
+
+    menu_ctrl_draw(b->ctrl);
+    return b;
+}
+
+static void bench_menu_free(bench_menu *b) {
+    menu_ctrl_free(b->ctrl);
+    free(b->items);
+    free(b);
+}
+
+static void bench_turn(bench_menu *b, int frames, bench_result *result) {
+    for (int f = 0; f < frames; f++) {
+        menu_turn_right(b->root);
+    }
+    result->frames += frames;
+}
+
+static void bench_warp(bench_menu *b, int frames, bench_result *result) {
+    int target = b->n_items / 2;
+    while (result->frames < frames) {
+        menu_item_warp_to(b->items[target]);
+        while (menu_ctrl_animate(b->ctrl)) {
+            result->frames++;
+        }
+        result->frames++;
+        target = target ? 0 : b->n_items / 2;
+    }
+}
+
+static void bench_fade(bench_menu *b, int frames, bench_result *result) {
+    int open = 1;
+    while (result->frames < frames) {
+        menu_open(open ? b->sub_menu : b->root);
+        while (menu_ctrl_animate(b->ctrl)) {
+            result->frames++;
+        }
+        result->frames++;
+        open = !open;
+    }
+}
+
+static int run_scenario(bench_menu *b, const char *scenario, int frames, bench_result *result) {
+    memset(result, 0, sizeof(bench_result));
+
+    int bumpmap = strstr(scenario, "bumpmap") != NULL;
+    int shadow = strstr(scenario, "shadow") != NULL;
+    set_effects(b->ctrl, bumpmap, shadow);
+    menu_item_show(b->items[0]);
+    menu_ctrl_draw(b->ctrl);
+
+    /* One turn around to fill the caches */
+    bench_turn(b, 8, result);
+    menu_ctrl_finish_animations(b->ctrl);
+    memset(result, 0, sizeof(bench_result));
+
+    unsigned long allocations_start = bench_allocations();
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    if (!strncmp(scenario, "turn", 4)) {
+        bench_turn(b, frames, result);
+    } else if (!strcmp(scenario, "warp")) {
+        bench_warp(b, frames, result);
+    } else if (!strcmp(scenario, "fade")) {
+        bench_fade(b, frames, result);
+    } else {
+        fprintf(stderr, "Unknown scenario %s\n", scenario);
+        return 0;
+    }
+
+    result->ticks = SDL_GetPerformanceCounter() - start;
+    result->allocations = bench_allocations() - allocations_start;
+
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    bench_options options = {{10, 500, 5000}, 3, {1, 2, 3}, 3, {0}, 0, DEFAULT_FRAMES, NULL, 480};
+    char default_scenarios[] = "turn,warp,fade,turn_bumpmap,turn_shadow,turn_bumpmap_shadow";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:l:s:f:F:w:")) != -1) {
+        switch (opt) {
+        case 'i':
+            options.n_items = parse_int_list(optarg, options.items);
+            break;
+        case 'l':
+            options.n_lines = parse_int_list(optarg, options.lines);
+            break;
+        case 's':
+            options.n_scenarios = parse_string_list(optarg, options.scenarios);
+            break;
+        case 'f':
+            options.frames = atoi(optarg);
+            break;
+        case 'F':
+            options.font = optarg;
+            break;
+        case 'w':
+            options.width = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr,
+                    "Usage: %s [-i items,...] [-l lines,...] [-s scenario,...] [-f frames] [-F font] [-w width]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+
+    if (!options.n_scenarios) {
+        options.n_scenarios = parse_string_list(default_scenarios, options.scenarios);
+    }
+
+    for (int c = 0; c < NUM_CTX; c++) {
+        set_log_level(c, 1);
+    }
+
+    /* Headless, unless the caller asks for something else */
+    setenv("SDL_VIDEODRIVER", "dummy", 0);
+    setenv("SDL_RENDER_DRIVER", "software", 0);
+
+    int failed = 0;
+    for (int i = 0; i < options.n_items; i++) {
+        for (int l = 0; l < options.n_lines; l++) {
+            bench_menu *b = bench_menu_new(&options, options.items[i], options.lines[l]);
+            if (!b) {
+                fprintf(stderr, "Could not create menu ctrl\n");
+                return 1;
+            }
+
+            for (int s = 0; s < options.n_scenarios; s++) {
+                bench_result result;
+                if (!run_scenario(b, options.scenarios[s], options.frames, &result)) {
+                    failed = 1;
+                    continue;
+                }
+
+                double ms = 1000.0 * result.ticks / SDL_GetPerformanceFrequency();
+                int frames = result.frames > 0 ? result.frames : 1;
+                printf("{\"scenario\":\"%s\",\"items\":%d,\"lines\":%d,\"frames\":%d,"
+                       "\"ms_per_frame\":%.3f,\"allocations_per_frame\":",
+                       options.scenarios[s], options.items[i], options.lines[l], result.frames,
+                       ms / frames);
+                if (BENCH_COUNTS_ALLOCATIONS) {
+                    printf("%.2f}\n", (double) result.allocations / frames);
+                } else {
+                    printf("null}\n");
+                }
+                fflush(stdout);
+            }
+
+            bench_menu_free(b);
+        }
+    }
+
+    return failed;
+}
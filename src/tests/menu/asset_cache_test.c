@@ -0,0 +1,170 @@
+/*
+ * VE301
+ *
+ * Copyright (C) 2024 LJunkie <christoph.pickart@gmx.de>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * VE301
+ *
+ * Standalone tests for the asset cache's handling of animations.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../../menu/asset_cache.h"
+#include "../test.h"
+
+/* 8x8 GIF, four frames of 100 ms each */
+static const unsigned char animation_gif[] = {
+    0x47, 0x49, 0x46, 0x38, 0x39, 0x61, 0x08, 0x00, 0x08, 0x00, 0x80, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0x21, 0xff, 0x0b, 0x4e, 0x45,
+    0x54, 0x53, 0x43, 0x41, 0x50, 0x45, 0x32, 0x2e, 0x30, 0x03, 0x01, 0x00,
+    0x00, 0x00, 0x21, 0xf9, 0x04, 0x04, 0x0a, 0x00, 0x00, 0x00, 0x2c, 0x00,
+    0x00, 0x00, 0x00, 0x08, 0x00, 0x08, 0x00, 0x00, 0x02, 0x25, 0x44, 0x88,
+    0x10, 0x21, 0x42, 0x84, 0x08, 0x11, 0x22, 0x44, 0x88, 0x10, 0x21, 0x42,
+    0x84, 0x08, 0x11, 0x22, 0x44, 0x88, 0x10, 0x21, 0x42, 0x84, 0x08, 0x11,
+    0x22, 0x44, 0x88, 0x10, 0x21, 0x42, 0x84, 0x08, 0x11, 0x22, 0x05, 0x00,
+    0x21, 0xf9, 0x04, 0x04, 0x0a, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00,
+    0x00, 0x08, 0x00, 0x08, 0x00, 0x00, 0x02, 0x25, 0x0c, 0x18, 0x30, 0x60,
+    0xc0, 0x80, 0x01, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x80, 0x01,
+    0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x80, 0x01, 0x03, 0x06, 0x0c,
+    0x18, 0x30, 0x60, 0xc0, 0x80, 0x01, 0x03, 0x06, 0x05, 0x00, 0x21, 0xf9,
+    0x04, 0x04, 0x0a, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 0x00, 0x08,
+    0x00, 0x08, 0x00, 0x00, 0x02, 0x25, 0x44, 0x88, 0x10, 0x21, 0x42, 0x84,
+    0x08, 0x11, 0x22, 0x44, 0x88, 0x10, 0x21, 0x42, 0x84, 0x08, 0x11, 0x22,
+    0x44, 0x88, 0x10, 0x21, 0x42, 0x84, 0x08, 0x11, 0x22, 0x44, 0x88, 0x10,
+    0x21, 0x42, 0x84, 0x08, 0x11, 0x22, 0x05, 0x00, 0x21, 0xf9, 0x04, 0x04,
+    0x0a, 0x00, 0x00, 0x00, 0x2c, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x08,
+    0x00, 0x00, 0x02, 0x25, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x80, 0x01, 0x03,
+    0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0, 0x80, 0x01, 0x03, 0x06, 0x0c, 0x18,
+    0x30, 0x60, 0xc0, 0x80, 0x01, 0x03, 0x06, 0x0c, 0x18, 0x30, 0x60, 0xc0,
+    0x80, 0x01, 0x03, 0x06, 0x05, 0x00, 0x3b,
+};
+
+#define ANIMATION_FRAMES 4
+#define ANIMATION_DELAY_MS 100
+
+static char animation_path[] = "/tmp/asset_cache_test_XXXXXX.gif";
+
+static int write_animation(void) {
+    int fd = mkstemps(animation_path, 4);
+    if (fd < 0) {
+        return 0;
+    }
+    ssize_t written = write(fd, animation_gif, sizeof(animation_gif));
+    close(fd);
+    return written == (ssize_t) sizeof(animation_gif);
+}
+
+static void release_frames(SDL_Surface **frames, int *delays, int n_frames) {
+    for (int f = 0; f < n_frames; f++) {
+        asset_cache_release_surface(frames[f]);
+    }
+    free(frames);
+    free(delays);
+}
+
+TEST(asset_cache_keeps_all_frames, "keeps every frame of an animation within the limit") {
+    SDL_Surface **frames = NULL;
+    int *delays = NULL;
+
+    asset_cache_init(0);
+    asset_cache_set_animation_limit(SIZE_MAX);
+
+    int n_frames = asset_cache_load_animation(animation_path, &frames, &delays);
+    ASSERT_MSG(n_frames == ANIMATION_FRAMES, "expected all frames of the animation");
+
+    size_t frame_bytes = (size_t) frames[0]->pitch * frames[0]->h;
+    ASSERT_MSG(asset_cache_get_bytes() == ANIMATION_FRAMES * frame_bytes,
+               "the cache should hold every frame");
+    for (int f = 0; f < n_frames; f++) {
+        ASSERT_MSG(delays[f] == ANIMATION_DELAY_MS, "frames should keep their delays");
+    }
+
+    release_frames(frames, delays, n_frames);
+    ASSERT_MSG(asset_cache_get_bytes() == 0, "unused frames beyond the budget should be freed");
+
+    asset_cache_free();
+    return 1;
+}
+
+TEST(asset_cache_frees_thinned_frames, "frees the frames dropped from a thinned animation") {
+    SDL_Surface **frames = NULL;
+    int *delays = NULL;
+
+    asset_cache_init(0);
+    asset_cache_set_animation_limit(SIZE_MAX);
+    int n_frames = asset_cache_load_animation(animation_path, &frames, &delays);
+    ASSERT_MSG(n_frames == ANIMATION_FRAMES, "expected all frames of the animation");
+    size_t frame_bytes = (size_t) frames[0]->pitch * frames[0]->h;
+    release_frames(frames, delays, n_frames);
+    asset_cache_free();
+
+    /* Half of the frames fit */
+    asset_cache_init(0);
+    asset_cache_set_animation_limit(2 * frame_bytes);
+
+    n_frames = asset_cache_load_animation(animation_path, &frames, &delays);
+    ASSERT_MSG(n_frames == ANIMATION_FRAMES / 2, "expected every second frame");
+    ASSERT_MSG(asset_cache_get_bytes() == n_frames * frame_bytes,
+               "the dropped frames should not be held by the cache");
+    for (int f = 0; f < n_frames; f++) {
+        ASSERT_MSG(delays[f] == 2 * ANIMATION_DELAY_MS,
+                   "kept frames should take the delays of the dropped ones");
+    }
+
+    /* While the kept frames are in use, nothing else of the animation is */
+    SDL_Surface **again = NULL;
+    int *again_delays = NULL;
+    int n_again = asset_cache_load_animation(animation_path, &again, &again_delays);
+    ASSERT_MSG(n_again == n_frames && again[0] == frames[0], "the thinned frames should be shared");
+    ASSERT_MSG(asset_cache_get_bytes() == n_frames * frame_bytes,
+               "sharing the animation should not decode it again");
+    release_frames(again, again_delays, n_again);
+
+    release_frames(frames, delays, n_frames);
+    ASSERT_MSG(asset_cache_get_bytes() == 0, "unused frames beyond the budget should be freed");
+
+    asset_cache_free();
+    asset_cache_set_animation_limit(ASSET_CACHE_MAX_ANIMATION_BYTES);
+    return 1;
+}
+
+static int run_tests(void);
+
+int main(void) {
+    if (!write_animation()) {
+        fprintf(stderr, "could not write %s\n", animation_path);
+        return 1;
+    }
+    int result = run_tests();
+    unlink(animation_path);
+    return result;
+}
+
+static int run_tests(void) {
+    static const ve301_test_case test_cases[] = {
+        TEST_CASE(asset_cache_keeps_all_frames,
+                  "keeps every frame of an animation within the limit"),
+        TEST_CASE(asset_cache_frees_thinned_frames,
+                  "frees the frames dropped from a thinned animation"),
+    };
+    return ve301_run_test_cases(test_cases, sizeof(test_cases) / sizeof(test_cases[0]));
+}
@@ -20,6 +20,12 @@
 #include "sdl_util.h"
 #include "../base/log_contexts.h"
 #include "../base/logging.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* FreeType is not thread safe, every TTF call goes through this lock */
+static pthread_mutex_t ttf_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 inline float Q_rsqrt( float number ) {
 
@@ -33,6 +39,32 @@ Uint8 get_alpha(Uint32 pixel, SDL_PixelFormat *format) {
     return a;
 }
 
+/**
+ * Open fonts shared by everybody asking for the same file and size
+ **/
+typedef struct font_registry_entry {
+    char *path;
+    int size;
+    TTF_Font *font;
+    int refs;
+    struct font_registry_entry *next;
+} font_registry_entry;
+
+static font_registry_entry *font_registry = NULL;
+
+static font_registry_entry **font_registry_find(TTF_Font *font) {
+    font_registry_entry **e = &font_registry;
+    while (*e && (*e)->font != font) {
+        e = &(*e)->next;
+    }
+    return e;
+}
+
+/**
+ * Returns the font of the given file and size, opened only once for all
+ * callers. Each call must be paired with my_CloseTTF_Font. Shared fonts
+ * must not be restyled.
+ **/
 TTF_Font *my_OpenTTF_Font(const char *path, const int size) {
     if (!path) {
         return NULL;
@@ -40,8 +72,75 @@ TTF_Font *my_OpenTTF_Font(const char *path, const int size) {
     if (size == 0) {
         return NULL;
     }
+
+    my_LockTTF();
+    for (font_registry_entry *e = font_registry; e; e = e->next) {
+        if (e->size == size && !strcmp(e->path, path)) {
+            e->refs++;
+            my_UnlockTTF();
+            log_debug(MENU_CTX, "Sharing font %s with size %d (%d users)\n", path, size, e->refs);
+            return e->font;
+        }
+    }
+
     log_config(MENU_CTX, "Opening font %s with size %d\n", path, size);
-    return TTF_OpenFont(path,size);
+    TTF_Font *font = TTF_OpenFont(path,size);
+    if (font) {
+        font_registry_entry *e = malloc(sizeof(font_registry_entry));
+        e->path = strdup(path);
+        e->size = size;
+        e->font = font;
+        e->refs = 1;
+        e->next = font_registry;
+        font_registry = e;
+    }
+    my_UnlockTTF();
+    return font;
+}
+
+/**
+ * Releases a font from my_OpenTTF_Font, it is closed with its last user
+ **/
+void my_CloseTTF_Font(TTF_Font *font) {
+    if (font) {
+        my_LockTTF();
+        font_registry_entry **e = font_registry_find(font);
+        font_registry_entry *entry = *e;
+        if (!entry) {
+            log_warning(MENU_CTX, "Closing font %p that has not been opened by my_OpenTTF_Font\n", font);
+            TTF_CloseFont(font);
+        } else if (--entry->refs <= 0) {
+            log_config(MENU_CTX, "Closing font %s with size %d\n", entry->path, entry->size);
+            *e = entry->next;
+            TTF_CloseFont(font);
+            free(entry->path);
+            free(entry);
+        }
+        my_UnlockTTF();
+    }
+}
+
+/**
+ * The number of users of a font from my_OpenTTF_Font
+ **/
+int my_TTF_FontRefs(TTF_Font *font) {
+    my_LockTTF();
+    font_registry_entry *entry = *font_registry_find(font);
+    int refs = entry ? entry->refs : 0;
+    my_UnlockTTF();
+    return refs;
+}
+
+/**
+ * Serializes the TTF calls of the render thread and the rasterization
+ * workers
+ **/
+void my_LockTTF(void) {
+    pthread_mutex_lock(&ttf_mutex);
+}
+
+void my_UnlockTTF(void) {
+    pthread_mutex_unlock(&ttf_mutex);
 }
 
 SDL_Color *html_to_color_and_alpha(char *c, unsigned char *alpha) {
@@ -111,16 +210,20 @@ SDL_Color *color_between(SDL_Color *from, SDL_Color *to, double t) {
     return NULL;
 }
 
-SDL_Texture *new_light_texture(SDL_Renderer *renderer, int w, int h, int light_x, int light_y, int radius, int alpha) {
-
-    SDL_Texture *light_texture = SDL_CreateTexture(renderer,DEFAULT_SDL_PIXELFORMAT,SDL_TEXTUREACCESS_STATIC,w,h);
-    SDL_SetTextureBlendMode(light_texture,SDL_BLENDMODE_MUL);
-    SDL_PixelFormat *format = SDL_AllocFormat(DEFAULT_SDL_PIXELFORMAT);
+/**
+ * A grey spot around (light_x, light_y), meant to be multiplied with the
+ * screen (SDL_BLENDMODE_MUL)
+ **/
+SDL_Surface *new_light_surface(int w, int h, int light_x, int light_y, int radius, int alpha) {
 
-    Uint32 pixels[w*h];
+    SDL_Surface *light_surface = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, DEFAULT_SDL_PIXELFORMAT);
+    if (!light_surface) {
+        log_error(SDL_CTX, "Could not create light surface: %s\n", SDL_GetError());
+        return NULL;
+    }
 
     for (int y = 0; y < h; y++) {
-        int o = w * y;
+        Uint32 *pixels = (Uint32 *) ((Uint8 *) light_surface->pixels + light_surface->pitch * y);
         int sq_y = (y - light_y)*(y - light_y);
         for (int x = 0; x < w; x++) {
 
@@ -129,21 +232,100 @@ SDL_Texture *new_light_texture(SDL_Renderer *renderer, int w, int h, int light_x
             if (l < 0.0) l = 0.0;
             if (l > 255.0) l = 255.0;
 
-            Uint32 pixel = alpha;
-            if (l >= 0.0) {
-                pixel = SDL_MapRGBA(format,l,l,l,alpha);
-            }
-            pixels[x+o] = pixel;
+            pixels[x] = SDL_MapRGBA(light_surface->format,l,l,l,alpha);
 
         }
     }
 
-    SDL_FreeFormat(format);
-    SDL_UpdateTexture(light_texture,NULL,pixels,4*w);
+    return light_surface;
+}
+
+SDL_Texture *new_light_texture(SDL_Renderer *renderer, int w, int h, int light_x, int light_y, int radius, int alpha) {
+
+    SDL_Surface *light_surface = new_light_surface(w, h, light_x, light_y, radius, alpha);
+    if (!light_surface) {
+        return NULL;
+    }
+
+    SDL_Texture *light_texture = SDL_CreateTextureFromSurface(renderer, light_surface);
+    SDL_FreeSurface(light_surface);
+    SDL_SetTextureBlendMode(light_texture,SDL_BLENDMODE_MUL);
 
     return light_texture;
 }
 
+/**
+ * Box blur of one row or column of alpha values
+ **/
+static void blur_alpha_line(const Uint8 *src, Uint8 *dst, int n, int stride, int radius) {
+    int d = 2 * radius + 1;
+    int sum = 0;
+
+    for (int i = -radius; i <= radius; i++) {
+        sum += i >= 0 && i < n ? src[i * stride] : 0;
+    }
+
+    for (int i = 0; i < n; i++) {
+        dst[i * stride] = sum / d;
+        int in = i + radius + 1;
+        int out = i - radius;
+        sum += in < n ? src[in * stride] : 0;
+        sum -= out >= 0 ? src[out * stride] : 0;
+    }
+}
+
+/**
+ * Returns a white surface with the blurred alpha of the given surface,
+ * grown by blur pixels on each side. Two box blurs come close enough to
+ * a gaussian for soft shadows.
+ **/
+SDL_Surface *new_shadow_surface(SDL_Surface *surface, int blur) {
+    int w = surface->w + 2 * blur;
+    int h = surface->h + 2 * blur;
+    int radius = (blur + 1) / 2;
+
+    SDL_Surface *shadow = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, DEFAULT_SDL_PIXELFORMAT);
+    if (!shadow) {
+        log_error(SDL_CTX, "Could not create shadow surface: %s\n", SDL_GetError());
+        return NULL;
+    }
+
+    Uint8 *alpha = calloc(w * h, 1);
+    Uint8 *tmp = calloc(w * h, 1);
+
+    SDL_LockSurface(surface);
+    for (int y = 0; y < surface->h; y++) {
+        for (int x = 0; x < surface->w; x++) {
+            Uint32 pixel = 0;
+            memcpy(&pixel, (Uint8 *) surface->pixels + surface->pitch * y + surface->format->BytesPerPixel * x,
+                   surface->format->BytesPerPixel);
+            alpha[w * (y + blur) + x + blur] = get_alpha(pixel, surface->format);
+        }
+    }
+    SDL_UnlockSurface(surface);
+
+    for (int pass = 0; pass < 2 && radius > 0; pass++) {
+        for (int y = 0; y < h; y++) {
+            blur_alpha_line(alpha + w * y, tmp + w * y, w, 1, radius);
+        }
+        for (int x = 0; x < w; x++) {
+            blur_alpha_line(tmp + x, alpha + x, h, w, radius);
+        }
+    }
+
+    for (int y = 0; y < h; y++) {
+        Uint32 *row = (Uint32 *) ((Uint8 *) shadow->pixels + shadow->pitch * y);
+        for (int x = 0; x < w; x++) {
+            row[x] = SDL_MapRGBA(shadow->format, 255, 255, 255, alpha[w * y + x]);
+        }
+    }
+
+    free(alpha);
+    free(tmp);
+
+    return shadow;
+}
+
 SDL_Color *clone_color(SDL_Color *color) {
     SDL_Color *new_color = malloc(sizeof(SDL_Color));
     new_color->a = color->a;
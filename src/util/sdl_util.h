@@ -30,6 +30,10 @@
 
 float Q_rsqrt( float number );
 TTF_Font *my_OpenTTF_Font(const char *path, const int size);
+void my_CloseTTF_Font(TTF_Font *font);
+int my_TTF_FontRefs(TTF_Font *font);
+void my_LockTTF(void);
+void my_UnlockTTF(void);
 SDL_Color *html_to_color_and_alpha(char *c, unsigned char *alpha);
 SDL_Color *html_to_color(char *c);
 SDL_Color *rgb_to_color(int r, int g, int b);
@@ -37,6 +41,8 @@ void color_between_rgb(unsigned char rf, unsigned char gf, unsigned char bf, uns
 SDL_Color *color_between(SDL_Color *from, SDL_Color *to, double t);
 SDL_Color *clone_color(SDL_Color *color);
 void html_print_color(char *name, SDL_Color *c);
+SDL_Surface *new_light_surface(int w, int h, int light_x, int light_y, int radius, int alpha);
 SDL_Texture *new_light_texture(SDL_Renderer *renderer, int w, int h, int light_x, int light_y, int radius, int alpha);
+SDL_Surface *new_shadow_surface(SDL_Surface *surface, int blur);
 Uint8 get_alpha(Uint32 pixel, SDL_PixelFormat *format);
 int init_SDL();